@@ -0,0 +1,244 @@
+/**********************************************************************
+ *  benchmark.h - On-Target Micro-Benchmarks
+ *  Times the hot paths (command parsing and dispatch, status and
+ *  collision formatting, servo and filter updates) over a fixed input
+ *  and reports the time per call and the stack and heap each one needs.
+ *  The BENCH report runs one case per REPORT task run, which blocks for
+ *  that case's iterations - use it with the robot idle.
+ *
+ *  Output, one line per case (BENCH command):
+ *    BENCH:<case> ns=<time per call> stack=<bytes> heap=<bytes>
+ *
+ *  Built with BENCH_CYCLE_COUNT (host/simavr_bench.sh, under simavr)
+ *  the lines add cycles=<per call> from Timer1 and go to Serial (the
+ *  link may not be up yet), and setup() runs the cases once and halts.
+ *  host/bench_main.cpp runs the same cases on a desktop build.
+ *********************************************************************/
+
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include "bluetooth_handler.h"
+#include "command_processor.h"
+#include "config.h"
+#include "memory_optimization.h"
+#include "sensor_filter.h"
+#include "sensor_status.h"
+#include "servo_arm.h"
+#include "watchdog.h"
+
+#define BENCH_DEFAULT_ITERATIONS 100
+#define BENCH_MAX_ITERATIONS 1000
+
+// Count CPU cycles on Timer1 at clk/1; the timer is otherwise free (the
+// servos take Timer5), and interrupts inside a case count as in ns
+#ifndef BENCH_CYCLE_COUNT
+#define BENCH_CYCLE_COUNT false
+#endif
+
+#if BENCH_CYCLE_COUNT
+#if !defined(__AVR__)
+#error "BENCH_CYCLE_COUNT needs the AVR's Timer1"
+#endif
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+#endif
+
+typedef void (*BenchFunction)();
+
+struct BenchCase {
+  PGM_P name;
+  BenchFunction function;
+};
+
+class Benchmark {
+private:
+  static char *output; // Formatting target for the cases that build text
+  static size_t outputSize;
+  static SensorFilter filter;
+  static uint16_t sample;
+
+  static void benchParse();
+  static void benchExecute();
+  static void benchStatus();
+  static void benchCollisionMessage();
+  static void benchServoUpdate();
+  static void benchFilter();
+
+  static void runCase(const BenchCase &bench, uint16_t iterations,
+                      char *line, size_t lineSize);
+
+#if BENCH_CYCLE_COUNT
+  static void startCycleCount();
+  static uint32_t readCycleCount();
+#endif
+
+public:
+  // Run the case at cursor and write its line (REPORT source for BENCH);
+  // 0 iterations means BENCH_DEFAULT_ITERATIONS
+  static bool reportLine(uint16_t &cursor, uint16_t iterations, char *line,
+                         size_t lineSize);
+
+  // Run every case and print the lines to Serial (simulator build)
+  static void runAll(uint16_t iterations);
+
+#if BENCH_CYCLE_COUNT
+  static volatile uint16_t cycleOverflows;
+
+  // End a simulator run: simavr exits when the CPU sleeps with
+  // interrupts off
+  static void halt();
+#endif
+};
+
+// Static variable definitions
+char *Benchmark::output = nullptr;
+size_t Benchmark::outputSize = 0;
+SensorFilter Benchmark::filter;
+uint16_t Benchmark::sample = 0;
+#if BENCH_CYCLE_COUNT
+volatile uint16_t Benchmark::cycleOverflows = 0;
+
+ISR(TIMER1_OVF_vect) { Benchmark::cycleOverflows++; }
+#endif
+
+// Implementation
+void Benchmark::benchParse() {
+  CommandProcessor::isValidCommand("T:80,-40");
+}
+
+// Parse and dispatch a stop, including its ack; acks that don't fit the
+// TX queue are dropped and show up in PERF:TX_DROPPED
+void Benchmark::benchExecute() {
+  CommandProcessor::processImmediate(CMD_STOP);
+}
+
+void Benchmark::benchStatus() {
+  SensorStatusManager::getStatusBuffer(output, outputSize);
+}
+
+void Benchmark::benchCollisionMessage() {
+  formatCollisionMessage("FRONT", 123, output, outputSize);
+}
+
+void Benchmark::benchServoUpdate() { ServoArm::update(); }
+
+void Benchmark::benchFilter() {
+  // Sweep 500-627mm so the median and rate paths see moving data
+  SensorFilterStage::addSample(filter, 500 + (sample++ & 0x7F), millis(),
+                               CM_TO_MM(COLLISION_DISTANCE_WARN));
+}
+
+const char BENCH_PARSE[] PROGMEM = "PARSE";
+const char BENCH_EXECUTE[] PROGMEM = "EXECUTE";
+const char BENCH_STATUS[] PROGMEM = "STATUS";
+const char BENCH_COLLISION_MSG[] PROGMEM = "COLLISION_MSG";
+const char BENCH_SERVO_UPDATE[] PROGMEM = "SERVO_UPDATE";
+const char BENCH_FILTER[] PROGMEM = "FILTER";
+
+void Benchmark::runCase(const BenchCase &bench, uint16_t iterations,
+                        char *line, size_t lineSize) {
+  int heapBefore = MemoryMonitor::getHeapUsed();
+  int freeBefore = MemoryMonitor::getFreeMemory();
+  MemoryMonitor::repaintFreeMemory();
+
+#if BENCH_CYCLE_COUNT
+  startCycleCount();
+#endif
+  unsigned long start = micros();
+  for (uint16_t i = 0; i < iterations; i++) {
+    bench.function();
+  }
+  unsigned long elapsed = micros() - start;
+#if BENCH_CYCLE_COUNT
+  uint32_t cycles = readCycleCount();
+#endif
+  Watchdog::kick(); // One case can outlast the watchdog timeout
+
+  // Stack below this frame that the case overwrote
+  int stack = freeBefore - MemoryMonitor::getUntouchedMemory();
+  if (stack < 0)
+    stack = 0;
+
+  char name[16];
+  strcpy_P(name, bench.name);
+  int length = snprintf_P(
+      line, lineSize, PSTR("BENCH:%s ns=%lu stack=%d heap=%d"), name,
+      elapsed / iterations * 1000UL +
+          elapsed % iterations * 1000UL / iterations,
+      stack, MemoryMonitor::getHeapUsed() - heapBefore);
+#if BENCH_CYCLE_COUNT
+  snprintf_P(line + length, lineSize - length, PSTR(" cycles=%lu"),
+             cycles / iterations);
+#endif
+}
+
+#if BENCH_CYCLE_COUNT
+void Benchmark::startCycleCount() {
+  TCCR1B = 0; // Stopped while it is set up
+  TCCR1A = 0;
+  TCNT1 = 0;
+  cycleOverflows = 0;
+  TIFR1 = _BV(TOV1);
+  TIMSK1 = _BV(TOIE1);
+  TCCR1B = _BV(CS10);
+}
+
+uint32_t Benchmark::readCycleCount() {
+  uint8_t sreg = SREG;
+  cli();
+  uint16_t count = TCNT1;
+  uint16_t overflows = cycleOverflows;
+  // An overflow that happened since interrupts went off is still pending
+  if ((TIFR1 & _BV(TOV1)) && count < 0x8000)
+    overflows++;
+  SREG = sreg;
+  return ((uint32_t)overflows << 16) | count;
+}
+
+void Benchmark::halt() {
+  Serial.flush();
+  cli();
+  set_sleep_mode(SLEEP_MODE_PWR_DOWN);
+  sleep_enable();
+  sleep_cpu();
+}
+#endif
+
+bool Benchmark::reportLine(uint16_t &cursor, uint16_t iterations,
+                           char *line, size_t lineSize) {
+  const BenchCase cases[] = {{BENCH_PARSE, benchParse},
+                             {BENCH_EXECUTE, benchExecute},
+                             {BENCH_STATUS, benchStatus},
+                             {BENCH_COLLISION_MSG, benchCollisionMessage},
+                             {BENCH_SERVO_UPDATE, benchServoUpdate},
+                             {BENCH_FILTER, benchFilter}};
+  if (cursor >= sizeof(cases) / sizeof(cases[0]))
+    return false;
+
+  if (iterations == 0)
+    iterations = BENCH_DEFAULT_ITERATIONS;
+  iterations = min(iterations, (uint16_t)BENCH_MAX_ITERATIONS);
+
+  if (cursor == 0)
+    SensorFilterStage::reset(filter);
+
+  // The cases that build text use the line, and the result replaces it
+  output = line;
+  outputSize = lineSize;
+  runCase(cases[cursor++], iterations, line, lineSize);
+  return true;
+}
+
+void Benchmark::runAll(uint16_t iterations) {
+  MessageHandle message(MAX_MESSAGE_LENGTH);
+  if (!message)
+    return;
+
+  uint16_t cursor = 0;
+  while (reportLine(cursor, iterations, message.get(), message.size())) {
+    Serial.println(message.get());
+  }
+}
+
+#endif // BENCHMARK_H
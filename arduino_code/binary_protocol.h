@@ -0,0 +1,145 @@
+/**********************************************************************
+ *  binary_protocol.h - Compact Binary Command Frames
+ *  Fast-path framing for high-rate commands (joystick, servo streaming)
+ *
+ *  Frame layout (5 bytes):
+ *    [SYNC 0xA5] [OPCODE] [VALUE1 int8] [VALUE2 int8] [CRC8]
+ *
+ *  The CRC8 (polynomial 0x07) covers OPCODE, VALUE1 and VALUE2. The sync
+ *  byte is outside the ASCII range, so text commands keep working on the
+ *  same link. Servo angles are sent relative to the 90° centre position
+ *  so the full 0-180° range fits in a signed byte.
+ *********************************************************************/
+
+#ifndef BINARY_PROTOCOL_H
+#define BINARY_PROTOCOL_H
+
+#include "config.h"
+#include "memory_optimization.h"
+
+// Frame format
+#define FRAME_SYNC 0xA5
+#define FRAME_LENGTH 5
+#define FRAME_SERVO_ANGLE_OFFSET 90
+
+// Wire opcodes - motor commands
+#define FRAME_OP_FORWARD 0x01  // value1 = speed (0-100)
+#define FRAME_OP_BACKWARD 0x02 // value1 = speed (0-100)
+#define FRAME_OP_LEFT 0x03     // value1 = speed (0-100)
+#define FRAME_OP_RIGHT 0x04    // value1 = speed (0-100)
+#define FRAME_OP_TANK 0x05     // value1 = left, value2 = right (-100-100)
+#define FRAME_OP_STOP 0x06
+
+// Wire opcodes - servo commands
+#define FRAME_OP_SERVO 0x10 // value1 = servo (1-6), value2 = angle - 90
+#define FRAME_OP_ARM_HOME 0x11
+#define FRAME_OP_ARM_PRESET 0x12 // value1 = preset (1-5)
+#define FRAME_OP_GRIPPER_OPEN 0x13
+#define FRAME_OP_GRIPPER_CLOSE 0x14
+
+// Wire opcodes - system commands
+#define FRAME_OP_EMERGENCY 0x20
+#define FRAME_OP_PING 0x21
+#define FRAME_OP_SPEED 0x22 // value1 = global speed (20-100)
+#define FRAME_OP_POWER_ON 0x30
+#define FRAME_OP_POWER_OFF 0x31
+#define FRAME_OP_POWER_TOGGLE 0x32
+
+// Command opcode and name for each wire opcode, stored in flash
+struct FrameOpcodeEntry {
+  uint8_t wireOpcode;
+  uint8_t opcode;
+  char type[6];
+};
+
+const FrameOpcodeEntry FRAME_OPCODES[] PROGMEM = {
+    {FRAME_OP_FORWARD, OP_FORWARD, CMD_FORWARD},
+    {FRAME_OP_BACKWARD, OP_BACKWARD, CMD_BACKWARD},
+    {FRAME_OP_LEFT, OP_LEFT, CMD_LEFT},
+    {FRAME_OP_RIGHT, OP_RIGHT, CMD_RIGHT},
+    {FRAME_OP_TANK, OP_TANK, CMD_TANK},
+    {FRAME_OP_STOP, OP_STOP, CMD_STOP},
+    {FRAME_OP_SERVO, OP_SERVO_MOVE, CMD_SERVO_MOVE},
+    {FRAME_OP_ARM_HOME, OP_ARM_HOME, CMD_ARM_HOME},
+    {FRAME_OP_ARM_PRESET, OP_ARM_PRESET, CMD_ARM_PRESET},
+    {FRAME_OP_GRIPPER_OPEN, OP_GRIPPER_OPEN, CMD_GRIPPER_OPEN},
+    {FRAME_OP_GRIPPER_CLOSE, OP_GRIPPER_CLOSE, CMD_GRIPPER_CLOSE},
+    {FRAME_OP_EMERGENCY, OP_EMERGENCY, CMD_EMERGENCY},
+    {FRAME_OP_PING, OP_PING, CMD_PING},
+    {FRAME_OP_SPEED, OP_SPEED, CMD_SPEED},
+    {FRAME_OP_POWER_ON, OP_POWER_ON, CMD_POWER_ON},
+    {FRAME_OP_POWER_OFF, OP_POWER_OFF, CMD_POWER_OFF},
+    {FRAME_OP_POWER_TOGGLE, OP_POWER_TOGGLE, CMD_POWER_TOGGLE}};
+
+#define FRAME_OPCODE_COUNT (sizeof(FRAME_OPCODES) / sizeof(FRAME_OPCODES[0]))
+
+class BinaryProtocol {
+public:
+  // CRC-8 (polynomial 0x07, initial value 0) over a byte range
+  static uint8_t crc8(const uint8_t *data, size_t length);
+
+  // Decode a complete frame (including sync byte) into a Command
+  static bool decodeFrame(const uint8_t *frame, Command &cmd);
+
+  // Encode a command into a frame buffer of FRAME_LENGTH bytes
+  static void encodeFrame(uint8_t opcode, int8_t value1, int8_t value2,
+                          uint8_t *frame);
+};
+
+// Implementation
+uint8_t BinaryProtocol::crc8(const uint8_t *data, size_t length) {
+  uint8_t crc = 0;
+  for (size_t i = 0; i < length; i++) {
+    crc ^= data[i];
+    for (uint8_t bitIndex = 0; bitIndex < 8; bitIndex++) {
+      crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : (crc << 1);
+    }
+  }
+  return crc;
+}
+
+bool BinaryProtocol::decodeFrame(const uint8_t *frame, Command &cmd) {
+  if (frame[0] != FRAME_SYNC)
+    return false;
+
+  if (crc8(frame + 1, FRAME_LENGTH - 2) != frame[FRAME_LENGTH - 1]) {
+    DEBUG_PRINTLN_P("⚠ Binary frame CRC mismatch, dropping");
+    return false;
+  }
+
+  uint8_t wireOpcode = frame[1];
+  for (size_t i = 0; i < FRAME_OPCODE_COUNT; i++) {
+    if (pgm_read_byte(&FRAME_OPCODES[i].wireOpcode) != wireOpcode)
+      continue;
+
+    cmd.opcode = pgm_read_byte(&FRAME_OPCODES[i].opcode);
+    strcpy_P(cmd.type, FRAME_OPCODES[i].type);
+    cmd.parameter[0] = '\0';
+    cmd.value1 = (int8_t)frame[2];
+    cmd.value2 = (int8_t)frame[3];
+    cmd.timestamp = millis();
+    cmd.batchSeq = BATCH_NONE;
+    cmd.batchItem = 0;
+
+    // Servo frames carry the angle relative to the centre position
+    if (cmd.opcode == OP_SERVO_MOVE) {
+      cmd.value2 += FRAME_SERVO_ANGLE_OFFSET;
+    }
+    return true;
+  }
+
+  DEBUG_PRINT_P("⚠ Unknown binary opcode: ");
+  DEBUG_PRINTLN(wireOpcode);
+  return false;
+}
+
+void BinaryProtocol::encodeFrame(uint8_t opcode, int8_t value1,
+                                 int8_t value2, uint8_t *frame) {
+  frame[0] = FRAME_SYNC;
+  frame[1] = opcode;
+  frame[2] = (uint8_t)value1;
+  frame[3] = (uint8_t)value2;
+  frame[4] = crc8(frame + 1, FRAME_LENGTH - 2);
+}
+
+#endif // BINARY_PROTOCOL_H
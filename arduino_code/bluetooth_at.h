@@ -0,0 +1,113 @@
+/**********************************************************************
+ *  bluetooth_at.h - HC-05 AT Command Channel
+ *  Drives the module's KEY pin (HC-05 pin 34) to switch its UART between
+ *  data and AT command mode, and runs one AT command at a time without
+ *  waiting: send() writes the command, poll() reports the reply.
+ *
+ *  BluetoothHandler keeps reading Serial1 and hands each line to
+ *  takeLine(), so app commands that arrive between replies still run.
+ *  While the KEY pin is high its output queues are held.
+ *********************************************************************/
+
+#ifndef BLUETOOTH_AT_H
+#define BLUETOOTH_AT_H
+
+#include "config.h"
+
+// Outcome of the command in flight
+enum AtResult : uint8_t { AT_PENDING, AT_OK, AT_ERROR, AT_TIMEOUT };
+
+#define AT_REPLY_LENGTH 24
+
+class BluetoothAt {
+private:
+  static char reply[AT_REPLY_LENGTH]; // Last "+..." line of the reply
+  static unsigned long sentAt;
+  static bool pending;
+  static AtResult result;
+
+public:
+  // KEY pin high: the module treats Serial1 as AT commands
+  static void enterCommandMode();
+
+  // KEY pin low: back to transparent data
+  static void exitCommandMode();
+
+  // Send one command (without the line ending)
+  static void send(const char *command);
+
+  // Offer a received line; true if it belongs to the reply in flight
+  static bool takeLine(const char *text);
+
+  // Check for the reply; AT_PENDING until OK, ERROR or the timeout
+  static AtResult poll();
+
+  // Data line of the last reply (e.g. "+UART:115200,0,0"), may be empty
+  static const char *getReply();
+
+  static size_t getRamUsage();
+};
+
+// Static variable definitions
+char BluetoothAt::reply[AT_REPLY_LENGTH];
+unsigned long BluetoothAt::sentAt = 0;
+bool BluetoothAt::pending = false;
+AtResult BluetoothAt::result = AT_ERROR;
+
+// Implementation
+void BluetoothAt::enterCommandMode() {
+  pinMode(BLUETOOTH_KEY_PIN, OUTPUT);
+  digitalWrite(BLUETOOTH_KEY_PIN, HIGH);
+}
+
+void BluetoothAt::exitCommandMode() {
+  digitalWrite(BLUETOOTH_KEY_PIN, LOW);
+  pending = false;
+}
+
+void BluetoothAt::send(const char *command) {
+  // At most ~20 bytes, which the UART buffer takes without waiting
+  Serial1.print(command);
+  Serial1.print(F("\r\n"));
+
+  reply[0] = '\0';
+  sentAt = millis();
+  pending = true;
+  result = AT_PENDING;
+}
+
+bool BluetoothAt::takeLine(const char *text) {
+  if (!pending || result != AT_PENDING)
+    return false;
+
+  if (strcmp_P(text, PSTR("OK")) == 0) {
+    result = AT_OK;
+  } else if (strncmp_P(text, PSTR("ERROR"), 5) == 0 ||
+             strncmp_P(text, PSTR("FAIL"), 4) == 0) {
+    result = AT_ERROR;
+  } else if (text[0] == '+') {
+    // "+NAME:..." style data ahead of the OK
+    strncpy(reply, text, AT_REPLY_LENGTH - 1);
+    reply[AT_REPLY_LENGTH - 1] = '\0';
+  } else {
+    return false; // Not a reply: a command from the app
+  }
+  return true;
+}
+
+AtResult BluetoothAt::poll() {
+  if (!pending)
+    return AT_ERROR;
+
+  if (result == AT_PENDING && millis() - sentAt >= BLUETOOTH_AT_TIMEOUT)
+    result = AT_TIMEOUT;
+  if (result != AT_PENDING)
+    pending = false;
+  return result;
+}
+
+const char *BluetoothAt::getReply() { return reply; }
+
+size_t BluetoothAt::getRamUsage() { return sizeof(reply); }
+
+#endif // BLUETOOTH_AT_H
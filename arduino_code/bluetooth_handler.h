@@ -1,36 +1,144 @@
 /**********************************************************************
  *  bluetooth_handler.h - Bluetooth Communication Module
  *  Handles all Bluetooth communication with HC-05/HC-06 modules
+ *
+ *  With BLUETOOTH_AT_ENABLED the UART rate is not fixed: boot finds the
+ *  module's rate over AT commands, and BAUD:<rate> moves the link to a
+ *  faster one, falling back if the app can't be heard at the new rate.
  *********************************************************************/
 
 #ifndef BLUETOOTH_HANDLER_H
 #define BLUETOOTH_HANDLER_H
 
+#include "binary_protocol.h"
+#include "bluetooth_at.h"
 #include "config.h"
+#include "debug_log.h"
 #include "memory_optimization.h"
+#include "perf_monitor.h"
+#include "trace.h"
 
 // Forward declaration to avoid circular dependency
 class CommandProcessor;
 
+// Result of queueing an outbound message
+enum TxResult : uint8_t { TX_QUEUED = 0, TX_WOULD_BLOCK };
+
+// Link bring-up and baud changes, advanced by update() so nothing waits
+enum BluetoothLinkState : uint8_t {
+  BT_LINK_POWERUP,    // Module settling; output held, input accepted
+  BT_LINK_DETECT,     // AT probing for the module's current rate
+  BT_LINK_CONFIRMING, // BLUETOOTH_INIT sent, waiting for any answer
+  BT_LINK_READY,
+  BT_LINK_DRAINING,  // Baud change accepted; letting the reply go out
+  BT_LINK_SET_UART,  // AT+UART sent
+  BT_LINK_RESET,     // AT+RESET sent; the new rate applies on restart
+  BT_LINK_VERIFYING // Waiting for a clean line at the new rate
+};
+
+// Which TX queue is mid-message (a line is never interleaved with another)
+#define TX_QUEUE_NONE 0xFF
+
 class BluetoothHandler {
 private:
-  static char inputBuffer[MAX_COMMAND_LENGTH];
+  static char inputBuffer[MAX_LINE_LENGTH];
+  static uint8_t inputLength;
+  static bool inputCorrupt; // Holds a byte no command line can
+  static uint8_t frameBuffer[FRAME_LENGTH];
+  static uint8_t frameIndex;
   static bool connectionEstablished;
   static unsigned long lastHeartbeat;
   static unsigned long lastDataReceived;
+  static BluetoothLinkState linkState;
+  static unsigned long linkStateSince;
+
+  // UART rate and the change in progress
+  static unsigned long currentBaud;
+  static unsigned long previousBaud;
+  static unsigned long targetBaud;
+  static uint8_t detectIndex;
+  static bool fallingBack;
+
+  // Receive errors (bytes that can't be protocol, bad frames) stand in
+  // for UART framing errors, which HardwareSerial discards
+  static unsigned int windowGood;
+  static unsigned int windowErrors;
+  static unsigned long windowStart;
+  static unsigned long rxErrors;
+  static uint8_t linkQuality;
+
+  static void setLinkState(BluetoothLinkState state);
+  static bool inCommandMode();
+  static void startDetect();
+  static void probeNextRate();
+  static void startSwitch(unsigned long baud, bool fallback);
+  static void openUart(unsigned long baud);
+  static void updateLinkQuality();
+  static void sendBaudNotice(PGM_P format, unsigned long baud);
+
+  // Outbound queues, one per priority class
+  static RingBuffer<TX_HIGH_BUFFER_SIZE> txHigh;
+  static RingBuffer<TX_TELEMETRY_BUFFER_SIZE> txTelemetry;
+  static uint8_t txActiveQueue;
+  static unsigned long txDropped;
+
+  // Batch item being run: its OK is covered by the batch ACK
+  static uint16_t responseBatchSeq;
+  static uint8_t responseBatchItem;
+  static bool responseFailed;
 
 public:
-  // Initialize Bluetooth module
-  static void init();
+  // Open the UART and start the link bring-up; returns immediately.
+  // A warm restart passes the rate the module was left at, which skips
+  // the settle time and rate detection.
+  static void init(unsigned long resumeBaud = 0);
+
+  // Step the bring-up / baud change state machine (called from update)
+  static void updateLink();
+
+  // Move the UART to another supported rate; false if not possible now
+  static bool requestBaud(unsigned long baud);
+
+  // Current UART rate
+  static unsigned long getBaud();
+
+  // Bring-up done and no rate change in progress
+  static bool isLinkReady();
+
+  // Receive errors since boot
+  static unsigned long getRxErrorCount();
 
   // Update - call this in main loop
   static void update();
 
-  // Send message to Bluetooth device
-  static void sendMessage(const char *message);
+  // Queue message for Bluetooth device; never waits for the UART
+  static TxResult sendMessage(const char *message,
+                              uint8_t priority = TX_PRIORITY_TELEMETRY);
+
+  // Send response with OK/ERROR prefix. Inside a batch only failures
+  // are sent, as ERR:<seq>,<item>,<command>
+  static TxResult sendResponse(const char *command, bool success = true);
+
+  // Responses that follow belong to this batch item (BATCH_NONE to end)
+  static void setResponseBatch(uint16_t seq, uint8_t item);
+
+  // Whether the current batch item has sent an error response
+  static bool batchItemFailed();
+
+  // A batch or macro item is running, so successes are not sent
+  static bool inResponseBatch();
+
+  // Move queued bytes into the UART as space allows (non-blocking)
+  static void serviceTx();
+
+  // Messages rejected because their queue was full
+  static unsigned long getTxDroppedCount();
 
-  // Send response with OK/ERROR prefix
-  static void sendResponse(const char *command, bool success = true);
+  // Bytes the telemetry queue can still take
+  static uint16_t getTelemetryFree();
+
+  // Static RAM of the receive and transmit buffers
+  static size_t getRamUsage();
 
   // Send status information
   static void sendStatus();
@@ -38,12 +146,16 @@ public:
   // Check if Bluetooth is connected
   static bool isConnected();
 
-  // Get signal strength (if supported)
+  // Link quality 0-100 from the receive error rate (the HC-05 has no
+  // RSSI for an open connection), 0 when not connected
   static int getSignalStrength();
 
-  // Process incoming data
+  // Process incoming data (text lines and binary frames)
   static void processIncomingData();
 
+  // Decode and queue a completed binary frame
+  static void processFrame();
+
   // Clear input buffer
   static void clearBuffer();
 
@@ -55,12 +167,40 @@ public:
 };
 
 // Implementation
-char BluetoothHandler::inputBuffer[MAX_COMMAND_LENGTH];
+char BluetoothHandler::inputBuffer[MAX_LINE_LENGTH];
+uint8_t BluetoothHandler::inputLength = 0;
+bool BluetoothHandler::inputCorrupt = false;
+uint8_t BluetoothHandler::frameBuffer[FRAME_LENGTH];
+uint8_t BluetoothHandler::frameIndex = 0;
 bool BluetoothHandler::connectionEstablished = false;
 unsigned long BluetoothHandler::lastHeartbeat = 0;
 unsigned long BluetoothHandler::lastDataReceived = 0;
-
-void BluetoothHandler::init() {
+BluetoothLinkState BluetoothHandler::linkState = BT_LINK_POWERUP;
+unsigned long BluetoothHandler::linkStateSince = 0;
+unsigned long BluetoothHandler::currentBaud = BLUETOOTH_BAUD;
+unsigned long BluetoothHandler::previousBaud = BLUETOOTH_BAUD;
+unsigned long BluetoothHandler::targetBaud = BLUETOOTH_BAUD;
+uint8_t BluetoothHandler::detectIndex = 0;
+bool BluetoothHandler::fallingBack = false;
+unsigned int BluetoothHandler::windowGood = 0;
+unsigned int BluetoothHandler::windowErrors = 0;
+unsigned long BluetoothHandler::windowStart = 0;
+unsigned long BluetoothHandler::rxErrors = 0;
+uint8_t BluetoothHandler::linkQuality = 100;
+RingBuffer<TX_HIGH_BUFFER_SIZE> BluetoothHandler::txHigh;
+RingBuffer<TX_TELEMETRY_BUFFER_SIZE> BluetoothHandler::txTelemetry;
+uint8_t BluetoothHandler::txActiveQueue = TX_QUEUE_NONE;
+unsigned long BluetoothHandler::txDropped = 0;
+uint16_t BluetoothHandler::responseBatchSeq = BATCH_NONE;
+uint8_t BluetoothHandler::responseBatchItem = 0;
+bool BluetoothHandler::responseFailed = false;
+
+// Rates the HC-05 supports that the Mega's UART hits closely enough;
+// detection tries them in this order after BLUETOOTH_BAUD
+const uint32_t BLUETOOTH_RATES[] PROGMEM = {115200, 57600, 38400, 19200, 9600};
+#define BLUETOOTH_RATE_COUNT (sizeof(BLUETOOTH_RATES) / sizeof(uint32_t))
+
+void BluetoothHandler::init(unsigned long resumeBaud) {
 #if SERIAL_TESTING_MODE
   DEBUG_PRINTLN_P("🔵 Bluetooth initialization skipped - Serial testing mode");
   connectionEstablished = true; // Simulate connection for testing
@@ -69,44 +209,258 @@ void BluetoothHandler::init() {
 
   DEBUG_PRINTLN_P("🔵 Initializing Bluetooth...");
 
+  // Only the Mega restarted: the module kept its rate and the app its
+  // connection, so the link is up as soon as the UART is
+  if (resumeBaud != 0) {
+    openUart(resumeBaud);
+    connectionEstablished = true;
+    setLinkState(BT_LINK_READY);
+    DEBUG_PRINT_P("🔵 Bluetooth resumed at ");
+    DEBUG_PRINTLN(currentBaud);
+    return;
+  }
+
   // Initialize Serial1 for Bluetooth communication
-  Serial1.begin(BLUETOOTH_BAUD);
+  openUart(BLUETOOTH_BAUD);
+
+  // Queued now, sent once the module has settled; commands that arrive
+  // in the meantime are processed as normal
+  sendMessage("BLUETOOTH_INIT", TX_PRIORITY_HIGH);
+  linkState = BT_LINK_POWERUP;
+  linkStateSince = millis();
+
+  DEBUG_PRINTLN_P("🔵 Bluetooth started on Serial1");
+}
+
+void BluetoothHandler::setLinkState(BluetoothLinkState state) {
+  linkState = state;
+  linkStateSince = millis();
+}
 
-  // Clear any existing data
+bool BluetoothHandler::inCommandMode() {
+  return linkState == BT_LINK_DETECT || linkState == BT_LINK_SET_UART ||
+         linkState == BT_LINK_RESET;
+}
+
+void BluetoothHandler::openUart(unsigned long baud) {
+  Serial1.begin(baud);
   while (Serial1.available()) {
     Serial1.read();
   }
+  // A line cut off by the rate change would run into the next one
+  inputLength = 0;
+  inputCorrupt = false;
+  frameIndex = 0;
+  currentBaud = baud;
+}
 
-  // Send initialization message
-  delay(1000);
-  sendMessage("BLUETOOTH_INIT");
-
-  // Wait for response or timeout
-  unsigned long startTime = millis();
-  char responseBuffer[64];
-  int responseIndex = 0;
-
-  while (millis() - startTime < 3000) {
-    if (Serial1.available()) {
-      char c = Serial1.read();
-      if (c != '\r' && c != '\n' && responseIndex < 63) {
-        responseBuffer[responseIndex++] = c;
-      } else if (responseIndex > 0) {
-        responseBuffer[responseIndex] = '\0';
-        connectionEstablished = true;
-        lastDataReceived = millis();
-        DEBUG_PRINTLN_P("✅ Bluetooth connection established");
+void BluetoothHandler::startDetect() {
+  BluetoothAt::enterCommandMode();
+  detectIndex = 0;
+  setLinkState(BT_LINK_DETECT);
+  probeNextRate();
+}
+
+void BluetoothHandler::probeNextRate() {
+  // BLUETOOTH_BAUD first: it is what an unconfigured module runs at
+  unsigned long baud = detectIndex == 0
+                           ? BLUETOOTH_BAUD
+                           : pgm_read_dword(&BLUETOOTH_RATES[detectIndex - 1]);
+  openUart(baud);
+  BluetoothAt::send("AT");
+}
+
+void BluetoothHandler::startSwitch(unsigned long baud, bool fallback) {
+  targetBaud = baud;
+  fallingBack = fallback;
+  BluetoothAt::enterCommandMode();
+
+  char command[24];
+  snprintf_P(command, sizeof(command), PSTR("AT+UART=%lu,0,0"), baud);
+  BluetoothAt::send(command);
+  setLinkState(BT_LINK_SET_UART);
+}
+
+bool BluetoothHandler::requestBaud(unsigned long baud) {
+#if BLUETOOTH_AT_ENABLED
+  if (linkState != BT_LINK_READY)
+    return false;
+
+  for (uint8_t i = 0; i < BLUETOOTH_RATE_COUNT; i++) {
+    if (pgm_read_dword(&BLUETOOTH_RATES[i]) == baud) {
+      targetBaud = baud;
+      setLinkState(BT_LINK_DRAINING);
+      return true;
+    }
+  }
+#endif
+  return false;
+}
+
+void BluetoothHandler::updateLink() {
+  unsigned long now = millis();
+  AtResult result;
+
+  switch (linkState) {
+  case BT_LINK_POWERUP:
+    if (now - linkStateSince >= BLUETOOTH_SETTLE_TIME) {
+#if BLUETOOTH_AT_ENABLED
+      // After a fallback the module's rate is already known
+      if (!fallingBack) {
+        startDetect();
         break;
       }
+#endif
+      fallingBack = false;
+      setLinkState(BT_LINK_CONFIRMING);
+    }
+    break;
+
+  case BT_LINK_DETECT:
+    result = BluetoothAt::poll();
+    if (result == AT_PENDING)
+      break;
+
+    if (result != AT_OK && ++detectIndex <= BLUETOOTH_RATE_COUNT) {
+      probeNextRate();
+      break;
+    }
+
+    BluetoothAt::exitCommandMode();
+    // Garbage heard at the wrong rates says nothing about the link
+    windowGood = 0;
+    windowErrors = 0;
+    windowStart = now;
+    if (result == AT_OK) {
+      DEBUG_PRINT_P("🔵 HC-05 answering at ");
+      DEBUG_PRINTLN(currentBaud);
+    } else {
+      // No KEY pin wired or an HC-06: keep the configured rate
+      DEBUG_PRINTLN_P("⚠ No AT reply - using BLUETOOTH_BAUD");
+      openUart(BLUETOOTH_BAUD);
+    }
+
+    // A fallback that couldn't set the rate ends here, on whatever works
+    if (fallingBack) {
+      fallingBack = false;
+      sendBaudNotice(PSTR("BAUD:FALLBACK %lu"), currentBaud);
+      setLinkState(BT_LINK_READY);
+    } else {
+      setLinkState(BT_LINK_CONFIRMING);
+    }
+    break;
+
+  case BT_LINK_CONFIRMING:
+    // Any line from the app confirms the link (processIncomingData)
+    if (connectionEstablished) {
+      DEBUG_PRINTLN_P("✅ Bluetooth connection established");
+      setLinkState(BT_LINK_READY);
+    } else if (now - linkStateSince >= BLUETOOTH_CONFIRM_TIME) {
+      DEBUG_PRINTLN_P("⚠ Bluetooth connection not confirmed, but continuing...");
+      setLinkState(BT_LINK_READY);
+    }
+    break;
+
+  case BT_LINK_READY:
+    // A burst of garbage at a raised rate means the link can't hold it
+    if (windowErrors >= BLUETOOTH_RX_ERROR_LIMIT &&
+        currentBaud != BLUETOOTH_BAUD) {
+      DEBUG_PRINTLN_P("⚠ Bluetooth receive errors - falling back");
+      startSwitch(BLUETOOTH_BAUD, true);
+    }
+    break;
+
+  case BT_LINK_DRAINING:
+    // The BAUD:SWITCH notice must reach the app before the link drops
+    if (txHigh.isEmpty() && txTelemetry.isEmpty() &&
+        txActiveQueue == TX_QUEUE_NONE) {
+      if (now - linkStateSince >= BLUETOOTH_AT_GUARD_TIME)
+        startSwitch(targetBaud, false);
+    } else {
+      linkStateSince = now;
+    }
+    break;
+
+  case BT_LINK_SET_UART:
+    result = BluetoothAt::poll();
+    if (result == AT_PENDING)
+      break;
+
+    if (result == AT_OK) {
+      BluetoothAt::send("AT+RESET");
+      setLinkState(BT_LINK_RESET);
+    } else if (fallingBack) {
+      // The module isn't at the rate we think; find it again
+      startDetect();
+    } else {
+      BluetoothAt::exitCommandMode();
+      sendBaudNotice(PSTR("BAUD:FAIL %lu"), targetBaud);
+      setLinkState(BT_LINK_READY);
+    }
+    break;
+
+  case BT_LINK_RESET:
+    // The module may restart before its OK gets out, so a timeout is fine
+    if (BluetoothAt::poll() == AT_PENDING)
+      break;
+
+    // KEY must be low before the module boots, or it comes up in AT mode
+    BluetoothAt::exitCommandMode();
+    previousBaud = currentBaud;
+    openUart(targetBaud);
+    connectionEstablished = false;
+    windowGood = 0;
+    windowErrors = 0;
+    windowStart = now;
+
+    DEBUG_PRINT_P("🔵 Bluetooth UART now ");
+    DEBUG_PRINTLN(currentBaud);
+
+    if (fallingBack) {
+      sendBaudNotice(PSTR("BAUD:FALLBACK %lu"), currentBaud);
+      setLinkState(BT_LINK_POWERUP); // Settle, then wait for the app
+    } else {
+      setLinkState(BT_LINK_VERIFYING);
+    }
+    break;
+
+  case BT_LINK_VERIFYING:
+    // The app reconnects and sends anything; one clean line proves the
+    // rate, errors or silence send the module back to the old one
+    if (windowErrors >= BLUETOOTH_RX_ERROR_LIMIT ||
+        now - linkStateSince >= BLUETOOTH_BAUD_VERIFY_TIME) {
+      DEBUG_PRINTLN_P("⚠ New Bluetooth rate not confirmed - falling back");
+      startSwitch(previousBaud, true);
+    } else if (windowGood > 0) {
+      sendBaudNotice(PSTR("BAUD:OK %lu"), currentBaud);
+      setLinkState(BT_LINK_READY);
     }
-    delay(100);
+    break;
   }
+}
 
-  if (!connectionEstablished) {
-    DEBUG_PRINTLN_P("⚠ Bluetooth connection not confirmed, but continuing...");
+void BluetoothHandler::sendBaudNotice(PGM_P format, unsigned long baud) {
+  MessageHandle message;
+  if (message) {
+    message.printf_P(format, baud);
+    sendMessage(message.get(), TX_PRIORITY_HIGH);
   }
+}
+
+void BluetoothHandler::updateLinkQuality() {
+  unsigned long now = millis();
+  if (now - windowStart < BLUETOOTH_QUALITY_WINDOW)
+    return;
 
-  DEBUG_PRINTLN_P("🔵 Bluetooth initialized on Serial1");
+  // Quiet windows say nothing about the link; keep the last estimate
+  unsigned int total = windowGood + windowErrors;
+  if (total > 0) {
+    int sample = (unsigned long)windowGood * 100 / total;
+    linkQuality += (sample - linkQuality) / 4;
+  }
+  windowGood = 0;
+  windowErrors = 0;
+  windowStart = now;
 }
 
 void BluetoothHandler::update() {
@@ -115,10 +469,21 @@ void BluetoothHandler::update() {
   return;
 #endif
 
-  // Process any incoming data
+  // Process any incoming data; AT replies are picked out of it, and
+  // commands that arrive between them still run
   processIncomingData();
 
-  // Send periodic heartbeat
+  updateLink();
+  if (inCommandMode())
+    return;
+
+  // Keep the UART fed from the outbound queues
+  serviceTx();
+
+  updateLinkQuality();
+
+  // Send a heartbeat only after 5s without other output - any line sent
+  // already tells the app the link is alive
   if (millis() - lastHeartbeat > 5000) {
     sendHeartbeat();
     lastHeartbeat = millis();
@@ -131,81 +496,200 @@ void BluetoothHandler::update() {
   }
 }
 
-void BluetoothHandler::sendMessage(const char *message) {
+TxResult BluetoothHandler::sendMessage(const char *message,
+                                      uint8_t priority) {
+  // Acks and alerts only; telemetry would fill the trace in seconds
+  if (priority == TX_PRIORITY_HIGH)
+    CommandTrace::recordOutbound(message);
+
 #if SERIAL_TESTING_MODE
   // In testing mode, output to Serial Monitor with prefix
   Serial.print(F("📡 "));
   Serial.println(message);
-  return;
+  return TX_QUEUED;
 #endif
 
-  if (DEBUG_BLUETOOTH) {
-    DEBUG_PRINT_P("📤 BT Send: ");
-    DEBUG_PRINTLN(message);
+  unsigned long startTime = micros();
+
+  // Queue the whole line (with the same CR/LF println used) or nothing
+  uint16_t length = strlen(message);
+  LOG_DEBUG(BLUETOOTH, LOG_MSG_BT_SEND, length, priority);
+
+  bool queued;
+  if (priority == TX_PRIORITY_HIGH) {
+    queued = txHigh.freeSpace() >= length + 2 &&
+             txHigh.write((const uint8_t *)message, length) &&
+             txHigh.write((const uint8_t *)"\r\n", 2);
+  } else {
+    queued = txTelemetry.freeSpace() >= length + 2 &&
+             txTelemetry.write((const uint8_t *)message, length) &&
+             txTelemetry.write((const uint8_t *)"\r\n", 2);
+  }
+
+  if (!queued) {
+    txDropped++;
+    return TX_WOULD_BLOCK;
   }
+  lastHeartbeat = millis();
 
-  Serial1.println(message);
-  Serial1.flush(); // Ensure data is sent immediately
+  // Start transmitting right away if the UART has room
+  serviceTx();
+  PerfMonitor::record(PROBE_TX, micros() - startTime);
+  return TX_QUEUED;
 }
 
-void BluetoothHandler::sendResponse(const char *command, bool success) {
-  if (MessageBuffer::isAvailable()) {
-    char *buffer = MessageBuffer::getBuffer();
-    const char *responsePrefix = success ? "OK" : "ERROR";
-    snprintf_P(buffer, MAX_MESSAGE_LENGTH, PSTR("%s_%s"), responsePrefix,
-               command);
-    sendMessage(buffer);
-    MessageBuffer::releaseBuffer();
+TxResult BluetoothHandler::sendResponse(const char *command, bool success) {
+  if (responseBatchSeq != BATCH_NONE) {
+    if (!success)
+      responseFailed = true;
+    // Macro failures are reported by the macro's MACRO_ABORT line
+    if (success || responseBatchSeq == BATCH_MACRO)
+      return TX_QUEUED;
+  }
+
+  TxResult result = TX_WOULD_BLOCK;
+  MessageHandle message;
+  if (message) {
+    if (responseBatchSeq != BATCH_NONE) {
+      message.printf_P(PSTR("ERR:%u,%u,%s"), responseBatchSeq,
+                       responseBatchItem, command);
+    } else {
+      const char *responsePrefix = success ? "OK" : "ERROR";
+      message.printf_P(PSTR("%s_%s"), responsePrefix, command);
+    }
+    result = sendMessage(message.get(), TX_PRIORITY_HIGH);
   }
+  return result;
+}
+
+void BluetoothHandler::setResponseBatch(uint16_t seq, uint8_t item) {
+  responseBatchSeq = seq;
+  responseBatchItem = item;
+  responseFailed = false;
+}
+
+bool BluetoothHandler::batchItemFailed() { return responseFailed; }
+
+bool BluetoothHandler::inResponseBatch() {
+  return responseBatchSeq != BATCH_NONE;
+}
+
+void BluetoothHandler::serviceTx() {
+  // Output waits in the queues until the module is up, and while the
+  // UART is talking AT to it
+  if (linkState == BT_LINK_POWERUP || inCommandMode())
+    return;
+
+  // HardwareSerial owns the TX interrupt and drains its own small buffer,
+  // so only hand over as many bytes as it can take without waiting
+  int space = Serial1.availableForWrite();
+  while (space-- > 0) {
+    if (txActiveQueue == TX_QUEUE_NONE) {
+      if (!txHigh.isEmpty()) {
+        txActiveQueue = TX_PRIORITY_HIGH;
+      } else if (!txTelemetry.isEmpty()) {
+        txActiveQueue = TX_PRIORITY_TELEMETRY;
+      } else {
+        return;
+      }
+    }
+
+    uint8_t c = (txActiveQueue == TX_PRIORITY_HIGH) ? txHigh.read()
+                                                    : txTelemetry.read();
+    Serial1.write(c);
+
+    // Re-check priorities at each line boundary
+    if (c == '\n') {
+      txActiveQueue = TX_QUEUE_NONE;
+    }
+  }
+}
+
+unsigned long BluetoothHandler::getTxDroppedCount() { return txDropped; }
+
+uint16_t BluetoothHandler::getTelemetryFree() {
+  return txTelemetry.freeSpace();
 }
 
 void BluetoothHandler::sendStatus() {
   // Send comprehensive status using message buffer
-  if (MessageBuffer::isAvailable()) {
-    char *buffer = MessageBuffer::getBuffer();
+  MessageHandle message;
+  if (message) {
 
-    snprintf_P(buffer, MAX_MESSAGE_LENGTH,
-               PSTR("STATUS_BLUETOOTH_CONNECTED:%d"), connectionEstablished);
-    sendMessage(buffer);
+    message.printf_P(PSTR("STATUS_BLUETOOTH_CONNECTED:%d"),
+                     connectionEstablished);
+    sendMessage(message.get());
 
-    snprintf_P(buffer, MAX_MESSAGE_LENGTH, PSTR("STATUS_UPTIME:%lu"), millis());
-    sendMessage(buffer);
+    message.printf_P(PSTR("STATUS_LINK_QUALITY:%d"), getSignalStrength());
+    sendMessage(message.get());
 
-    snprintf_P(buffer, MAX_MESSAGE_LENGTH, PSTR("STATUS_FREE_MEMORY:%d"),
-               MemoryMonitor::getFreeMemory());
-    sendMessage(buffer);
+    message.printf_P(PSTR("STATUS_UPTIME:%lu"), millis());
+    sendMessage(message.get());
 
-    snprintf_P(buffer, MAX_MESSAGE_LENGTH, PSTR("STATUS_LAST_COMMAND:%lu"),
-               millis() - lastDataReceived);
-    sendMessage(buffer);
+    message.printf_P(PSTR("STATUS_FREE_MEMORY:%d"),
+                     MemoryMonitor::getFreeMemory());
+    sendMessage(message.get());
+
+    message.printf_P(PSTR("STATUS_LAST_COMMAND:%lu"),
+                     millis() - lastDataReceived);
+    sendMessage(message.get());
 
-    MessageBuffer::releaseBuffer();
   }
 }
 
 bool BluetoothHandler::isConnected() { return connectionEstablished; }
 
 int BluetoothHandler::getSignalStrength() {
-  // This would require AT commands for HC-05
-  // For now, return a dummy value
-  return connectionEstablished ? 85 : 0;
+  return connectionEstablished ? linkQuality : 0;
 }
 
-void BluetoothHandler::processIncomingData() {
-  static int bufferIndex = 0;
+unsigned long BluetoothHandler::getBaud() { return currentBaud; }
+
+bool BluetoothHandler::isLinkReady() { return linkState == BT_LINK_READY; }
+
+unsigned long BluetoothHandler::getRxErrorCount() { return rxErrors; }
 
+void BluetoothHandler::processIncomingData() {
   while (Serial1.available()) {
     char c = Serial1.read();
 
+    // Collect the rest of a binary frame without any text handling
+    if (frameIndex > 0) {
+      frameBuffer[frameIndex++] = (uint8_t)c;
+      if (frameIndex == FRAME_LENGTH) {
+        processFrame();
+        frameIndex = 0;
+      }
+      continue;
+    }
+
+    // A sync byte at the start of a line opens a binary frame
+    if (inputLength == 0 && (uint8_t)c == FRAME_SYNC) {
+      frameBuffer[0] = FRAME_SYNC;
+      frameIndex = 1;
+      continue;
+    }
+
     if (c == '\n' || c == '\r') {
-      if (bufferIndex > 0) {
+      if (inputCorrupt) {
+        // Likely a rate mismatch or noise; don't act on it
+        windowErrors++;
+        rxErrors++;
+        inputCorrupt = false;
+        inputLength = 0;
+      } else if (inputLength > 0) {
         // Null terminate the command
-        BluetoothHandler::inputBuffer[bufferIndex] = '\0';
+        BluetoothHandler::inputBuffer[inputLength] = '\0';
+        inputLength = 0;
+
+        // The module's answer to an AT command, not the app's
+        if (BluetoothAt::takeLine(BluetoothHandler::inputBuffer))
+          continue;
 
-        if (DEBUG_BLUETOOTH) {
-          DEBUG_PRINT_P("📥 BT Received: ");
-          DEBUG_PRINTLN(BluetoothHandler::inputBuffer);
-        }
+        windowGood++;
+
+        LOG_DEBUG(BLUETOOTH, LOG_MSG_BT_RECEIVED,
+                  strlen(BluetoothHandler::inputBuffer));
 
         // Update connection status
         connectionEstablished = true;
@@ -214,21 +698,23 @@ void BluetoothHandler::processIncomingData() {
         // Add command to processing queue - will be handled after
         // CommandProcessor is included This is a temporary solution to avoid
         // circular dependency
-        extern void addCommandToQueue(const char *cmd);
+        CommandTrace::recordInbound(BluetoothHandler::inputBuffer);
+        extern bool addCommandToQueue(const char *cmd);
         addCommandToQueue(BluetoothHandler::inputBuffer);
 
         // Clear buffer
-        bufferIndex = 0;
         memset(BluetoothHandler::inputBuffer, 0,
                sizeof(BluetoothHandler::inputBuffer));
       }
     } else if (c != '\0' && c != '\r') {
-      if (bufferIndex < MAX_COMMAND_LENGTH - 1) {
-        BluetoothHandler::inputBuffer[bufferIndex++] = c;
+      if ((uint8_t)c < ' ' || (uint8_t)c > '~') {
+        inputCorrupt = true;
+      } else if (inputLength < MAX_LINE_LENGTH - 1) {
+        BluetoothHandler::inputBuffer[inputLength++] = c;
       } else {
         // Prevent buffer overflow
         DEBUG_PRINTLN_P("⚠ Bluetooth buffer overflow, clearing");
-        bufferIndex = 0;
+        inputLength = 0;
         memset(BluetoothHandler::inputBuffer, 0,
                sizeof(BluetoothHandler::inputBuffer));
       }
@@ -236,9 +722,30 @@ void BluetoothHandler::processIncomingData() {
   }
 }
 
+void BluetoothHandler::processFrame() {
+  Command cmd;
+  if (!BinaryProtocol::decodeFrame(frameBuffer, cmd)) {
+    windowErrors++;
+    rxErrors++;
+    return;
+  }
+  windowGood++;
+
+  LOG_DEBUG(BLUETOOTH, LOG_MSG_BT_FRAME, cmd.opcode);
+
+  // Update connection status
+  connectionEstablished = true;
+  lastDataReceived = millis();
+
+  CommandTrace::recordFrame(frameBuffer);
+  extern bool addFrameCommandToQueue(const Command &cmd);
+  addFrameCommandToQueue(cmd);
+}
+
 void BluetoothHandler::clearBuffer() {
   memset(BluetoothHandler::inputBuffer, 0,
          sizeof(BluetoothHandler::inputBuffer));
+  frameIndex = 0;
   while (Serial1.available()) {
     Serial1.read();
   }
@@ -254,4 +761,9 @@ bool BluetoothHandler::isConnectionHealthy() {
   return connectionEstablished && (millis() - lastDataReceived < 10000);
 }
 
+size_t BluetoothHandler::getRamUsage() {
+  return sizeof(inputBuffer) + sizeof(frameBuffer) + sizeof(txHigh) +
+         sizeof(txTelemetry) + BluetoothAt::getRamUsage();
+}
+
 #endif // BLUETOOTH_HANDLER_H
\ No newline at end of file
@@ -10,25 +10,43 @@
 
 #include "config.h"
 #include "memory_optimization.h"
+#include "motor_controller.h"
 #include "sensor_manager.h"
 
-// Forward declaration to avoid circular dependency
-extern void sendBluetoothMessage(const char *message);
+#define TTC_NONE 0xFFFF // Not closing on anything
+
+// Directions an emergency stop blocks travel toward until they clear
+#define LATCH_FRONT 0x01
+#define LATCH_REAR 0x02
 
 class CollisionAvoidance {
 private:
   static bool collisionAvoidanceEnabled;
   static bool emergencyStopActive;
+  static uint8_t latchedSides; // LATCH_* bits
   static unsigned long lastCollisionWarning;
+  static bool frontObstacleReported;
+  static bool rearObstacleReported;
   static unsigned long lastEmergencyStop;
   static int originalSpeed;
   static bool wasMovingForward;
+  static int8_t forwardSpeedLimit;
+  static int8_t backwardSpeedLimit;
 
   // Movement validation
-  static bool validateMovementCommand(const char *command, int speed,
+  static bool validateMovementCommand(uint8_t opcode, int speed,
                                       bool &isForward);
   static int calculateSafeSpeed(int requestedSpeed, bool movingForward);
 
+  // Time-to-collision model for the sensors facing the direction of travel
+  static int closingSpeed(int sensorIndex, bool movingForward);
+  static uint16_t timeToCollision(int sensorIndex, bool movingForward);
+  static int sensorSpeedLimit(int sensorIndex, bool movingForward);
+  static int travelSpeedLimit(bool movingForward);
+  static int findDangerSensor(bool movingForward); // NO_ACTIVE_SENSOR if none
+  static bool isClearOf(int sensorIndex);
+  static bool isSideClear(bool movingForward);
+
 public:
   // Initialize collision avoidance
   static void init();
@@ -42,7 +60,7 @@ public:
   static bool isEnabled();
 
   // Movement validation and modification
-  static bool isMovementSafe(const char *command, int speed);
+  static bool isMovementSafe(uint8_t opcode, int speed);
   static int adjustSpeedForSafety(int requestedSpeed, bool movingForward);
   static bool shouldStopMovement(bool movingForward);
 
@@ -51,6 +69,9 @@ public:
   static void clearEmergencyStop();
   static bool isEmergencyStopActive();
 
+  // Predicted ms until the stop distance is reached, TTC_NONE if not closing
+  static uint16_t getTimeToCollision(bool movingForward);
+
   // Status and diagnostics
   static void getStatus(char *buffer, size_t bufferSize);
   static void sendCollisionWarning(const char *direction);
@@ -67,18 +88,27 @@ public:
 };
 
 // Implementation
-bool CollisionAvoidance::collisionAvoidanceEnabled = true;
+// The bridge build has no sensors and never calls init()
+bool CollisionAvoidance::collisionAvoidanceEnabled = !ESP32_BRIDGE_MODE;
 bool CollisionAvoidance::emergencyStopActive = false;
+uint8_t CollisionAvoidance::latchedSides = 0;
 unsigned long CollisionAvoidance::lastCollisionWarning = 0;
+bool CollisionAvoidance::frontObstacleReported = false;
+bool CollisionAvoidance::rearObstacleReported = false;
 unsigned long CollisionAvoidance::lastEmergencyStop = 0;
 int CollisionAvoidance::originalSpeed = 0;
 bool CollisionAvoidance::wasMovingForward = true;
+int8_t CollisionAvoidance::forwardSpeedLimit = 100;
+int8_t CollisionAvoidance::backwardSpeedLimit = 100;
 
 void CollisionAvoidance::init() {
   DEBUG_PRINTLN_P("Initializing Collision Avoidance...");
   collisionAvoidanceEnabled = true;
   emergencyStopActive = false;
+  latchedSides = 0;
   lastCollisionWarning = 0;
+  frontObstacleReported = false;
+  rearObstacleReported = false;
   lastEmergencyStop = 0;
 
   DEBUG_PRINTLN_P("Collision Avoidance initialized - ENABLED");
@@ -88,44 +118,76 @@ void CollisionAvoidance::update() {
   if (!collisionAvoidanceEnabled)
     return;
 
-  // Check for immediate collision risks
-  bool frontRisk = SensorManager::isFrontCollisionRisk();
-  bool rearRisk = SensorManager::isRearCollisionRisk();
+  int travel = MotorController::getTravelSpeed();
+  SensorManager::setTravelDirection(travel);
+
+  // Emergency stop only if braking can't keep up with what we're closing on
+  int frontDanger = findDangerSensor(true);
+  int rearDanger = findDangerSensor(false);
 
   // Handle emergency stops
-  if (frontRisk || rearRisk) {
+  if (frontDanger != NO_ACTIVE_SENSOR || rearDanger != NO_ACTIVE_SENSOR) {
+    lastEmergencyStop = millis(); // Hold time counts from the last danger
+    if (frontDanger != NO_ACTIVE_SENSOR)
+      latchedSides |= LATCH_FRONT;
+    if (rearDanger != NO_ACTIVE_SENSOR)
+      latchedSides |= LATCH_REAR;
     if (!emergencyStopActive) {
+      bool frontRisk = frontDanger != NO_ACTIVE_SENSOR;
       const char *direction = frontRisk ? "FRONT" : "REAR";
       triggerEmergencyStop("Collision risk detected");
 
       // Send collision warning with optimized message
-      if (MessageBuffer::isAvailable()) {
-        char *buffer = MessageBuffer::getBuffer();
-        float distance = frontRisk ? SensorManager::getFrontDistance()
-                                   : SensorManager::getRearDistance();
-        formatCollisionMessage(direction, distance, buffer, MAX_MESSAGE_LENGTH);
-        sendBluetoothMessage(buffer);
-        MessageBuffer::releaseBuffer();
+      MessageHandle message;
+      if (message) {
+        uint16_t distance =
+            SensorManager::getDistanceMm(frontRisk ? frontDanger : rearDanger);
+        formatCollisionMessage(direction, distance, message.get(),
+                               message.size());
+        sendBluetoothMessage(message.get(), TX_PRIORITY_HIGH);
       }
     }
-  } else {
-    // Clear emergency stop if no immediate risks
-    if (emergencyStopActive && (millis() - lastEmergencyStop > 1000)) {
+  } else if (emergencyStopActive &&
+             millis() - lastEmergencyStop > COLLISION_CLEAR_HOLD_MS) {
+    // Hysteresis: after the hold time, each side un-latches once its own
+    // sensors show the clear margin - backing away is what clears it
+    if ((latchedSides & LATCH_FRONT) && isSideClear(true))
+      latchedSides &= ~LATCH_FRONT;
+    if ((latchedSides & LATCH_REAR) && isSideClear(false))
+      latchedSides &= ~LATCH_REAR;
+    if (latchedSides == 0)
       clearEmergencyStop();
-    }
   }
 
-  // Send periodic warnings for obstacles
+  // Brake continuously: cap each direction of travel from its sensors.
+  // A latched side is closed; the other stays open to drive away on.
+  forwardSpeedLimit =
+      (latchedSides & LATCH_FRONT) ? 0 : travelSpeedLimit(true);
+  backwardSpeedLimit =
+      (latchedSides & LATCH_REAR) ? 0 : travelSpeedLimit(false);
+  MotorController::setTravelLimits(forwardSpeedLimit, backwardSpeedLimit);
+
+  // Warn once when an obstacle appears - telemetry flags carry the ongoing
+  // state. The interval stops a flickering reading from re-warning.
+  bool frontObstacle = SensorManager::isFrontObstacleDetected();
+  bool rearObstacle = SensorManager::isRearObstacleDetected();
   unsigned long currentTime = millis();
   if (currentTime - lastCollisionWarning > 2000) {
-    if (SensorManager::isFrontObstacleDetected()) {
+    if (frontObstacle && !frontObstacleReported) {
       sendCollisionWarning("FRONT");
+      frontObstacleReported = true;
+      lastCollisionWarning = currentTime;
     }
-    if (SensorManager::isRearObstacleDetected()) {
+    if (rearObstacle && !rearObstacleReported) {
       sendCollisionWarning("REAR");
+      rearObstacleReported = true;
+      lastCollisionWarning = currentTime;
     }
-    lastCollisionWarning = currentTime;
   }
+  if (!frontObstacle)
+    frontObstacleReported = false;
+  if (!rearObstacle)
+    rearObstacleReported = false;
 }
 
 void CollisionAvoidance::enable() {
@@ -136,39 +198,44 @@ void CollisionAvoidance::enable() {
 void CollisionAvoidance::disable() {
   collisionAvoidanceEnabled = false;
   clearEmergencyStop();
+  forwardSpeedLimit = 100;
+  backwardSpeedLimit = 100;
+  MotorController::setTravelLimits(100, 100);
   DEBUG_PRINTLN("🛡 Collision avoidance DISABLED");
 }
 
 bool CollisionAvoidance::isEnabled() { return collisionAvoidanceEnabled; }
 
-bool CollisionAvoidance::isMovementSafe(const char *command, int speed) {
+bool CollisionAvoidance::isMovementSafe(uint8_t opcode, int speed) {
   if (!collisionAvoidanceEnabled)
     return true;
 
   bool isForward;
-  return validateMovementCommand(command, speed, isForward);
+  return validateMovementCommand(opcode, speed, isForward);
 }
 
-bool CollisionAvoidance::validateMovementCommand(const char *command, int speed,
+bool CollisionAvoidance::validateMovementCommand(uint8_t opcode, int speed,
                                                  bool &isForward) {
   isForward = true;
 
-  if (strcmp(command, "FORWARD") == 0) {
+  switch (opcode) {
+  case OP_FORWARD:
     isForward = true;
     return validateForwardMovement(speed);
-  } else if (strcmp(command, "BACKWARD") == 0) {
+  case OP_BACKWARD:
     isForward = false;
     return validateBackwardMovement(speed);
-  } else if (strcmp(command, "LEFT") == 0 || strcmp(command, "RIGHT") == 0) {
+  case OP_LEFT:
+  case OP_RIGHT:
     // For turns, check both directions but prioritize the turn direction
     return validateTurnMovement(speed);
-  } else if (strcmp(command, "TANK") == 0) {
+  case OP_TANK:
     // Tank drive - more complex validation needed
     // For now, allow tank drive but at reduced speed if obstacles present
     return true;
+  default:
+    return true; // Allow other commands (like STOP)
   }
-
-  return true; // Allow other commands (like STOP)
 }
 
 bool CollisionAvoidance::validateForwardMovement(int speed) {
@@ -202,7 +269,118 @@ int CollisionAvoidance::adjustSpeedForSafety(int requestedSpeed,
   if (!collisionAvoidanceEnabled)
     return requestedSpeed;
 
-  return SensorManager::getRecommendedSpeed(requestedSpeed, movingForward);
+  // The motor travel limits keep applying after the command starts
+  int limit = movingForward ? forwardSpeedLimit : backwardSpeedLimit;
+  return min(requestedSpeed, limit);
+}
+
+int CollisionAvoidance::closingSpeed(int sensorIndex, bool movingForward) {
+  // Our own travel toward the sensor's side, from the driven output
+  int travel = MotorController::getTravelSpeed();
+  if (!movingForward)
+    travel = -travel;
+  long driven = (long)travel * ROBOT_FULL_SPEED_MM_S / 100;
+
+  // The filtered closing rate also sees obstacles that move toward us;
+  // trust whichever says we're closing faster
+  int measured = SensorManager::getClosingRate(sensorIndex);
+  return max((long)measured, driven);
+}
+
+uint16_t CollisionAvoidance::timeToCollision(int sensorIndex,
+                                             bool movingForward) {
+  uint16_t distance = SensorManager::getDistanceMm(sensorIndex);
+  if (!SensorManager::areSensorsEnabled() || distance == SENSOR_NO_ECHO)
+    return TTC_NONE;
+
+  uint16_t stopDistance = CM_TO_MM(SensorManager::getCollisionDistance());
+  if (distance <= stopDistance)
+    return 0;
+
+  int closing = closingSpeed(sensorIndex, movingForward);
+  if (closing <= 0)
+    return TTC_NONE;
+
+  unsigned long ttc = (unsigned long)(distance - stopDistance) * 1000UL /
+                      (unsigned long)closing;
+  return ttc < TTC_NONE ? ttc : TTC_NONE - 1;
+}
+
+int CollisionAvoidance::sensorSpeedLimit(int sensorIndex, bool movingForward) {
+  uint16_t distance = SensorManager::getDistanceMm(sensorIndex);
+  if (!SensorManager::areSensorsEnabled() || distance == SENSOR_NO_ECHO)
+    return 100;
+
+  uint16_t stopDistance = CM_TO_MM(SensorManager::getCollisionDistance());
+  if (distance <= stopDistance)
+    return 0;
+
+  // Fastest approach that still leaves COLLISION_TTC_TARGET_MS to the stop
+  // distance, less whatever the obstacle itself is closing at
+  long allowed = (long)(distance - stopDistance) * 1000L /
+                 COLLISION_TTC_TARGET_MS;
+  int travel = MotorController::getTravelSpeed();
+  if (!movingForward)
+    travel = -travel;
+  long obstacleSpeed = SensorManager::getClosingRate(sensorIndex) -
+                       (long)max(travel, 0) * ROBOT_FULL_SPEED_MM_S / 100;
+  if (obstacleSpeed > 0)
+    allowed -= obstacleSpeed;
+
+  long limit = allowed * 100 / ROBOT_FULL_SPEED_MM_S;
+  // Below this the motors stall rather than creep; findDangerSensor()
+  // stops the robot if even this is too fast
+  if (limit < MIN_SPEED_THRESHOLD)
+    return MIN_SPEED_THRESHOLD;
+  return limit > 100 ? 100 : limit;
+}
+
+int CollisionAvoidance::travelSpeedLimit(bool movingForward) {
+  // The most constrained sensor covering this direction sets the limit
+  int limit = 100;
+  for (int i = 0; i < SensorManager::getSensorCount(); i++) {
+    if (SensorManager::isFacing(i, movingForward))
+      limit = min(limit, sensorSpeedLimit(i, movingForward));
+  }
+  return limit;
+}
+
+int CollisionAvoidance::findDangerSensor(bool movingForward) {
+  for (int i = 0; i < SensorManager::getSensorCount(); i++) {
+    if (!SensorManager::isFacing(i, movingForward))
+      continue;
+
+    // Only while closing - backing away from a wall is not a collision
+    if (closingSpeed(i, movingForward) > 0 &&
+        timeToCollision(i, movingForward) < COLLISION_TTC_EMERGENCY_MS)
+      return i;
+  }
+  return NO_ACTIVE_SENSOR;
+}
+
+bool CollisionAvoidance::isClearOf(int sensorIndex) {
+  uint16_t distance = SensorManager::getDistanceMm(sensorIndex);
+  if (distance == SENSOR_NO_ECHO)
+    return true;
+  return distance > CM_TO_MM(SensorManager::getCollisionDistance()) +
+                        COLLISION_CLEAR_MARGIN_MM;
+}
+
+bool CollisionAvoidance::isSideClear(bool movingForward) {
+  for (int i = 0; i < SensorManager::getSensorCount(); i++) {
+    if (SensorManager::isFacing(i, movingForward) && !isClearOf(i))
+      return false;
+  }
+  return true;
+}
+
+uint16_t CollisionAvoidance::getTimeToCollision(bool movingForward) {
+  uint16_t soonest = TTC_NONE;
+  for (int i = 0; i < SensorManager::getSensorCount(); i++) {
+    if (SensorManager::isFacing(i, movingForward))
+      soonest = min(soonest, timeToCollision(i, movingForward));
+  }
+  return soonest;
 }
 
 bool CollisionAvoidance::shouldStopMovement(bool movingForward) {
@@ -225,12 +403,10 @@ void CollisionAvoidance::triggerEmergencyStop(const char *reason) {
     DEBUG_PRINTLN(reason);
 
     // Send emergency stop notification using message buffer
-    if (MessageBuffer::isAvailable()) {
-      char *buffer = MessageBuffer::getBuffer();
-      snprintf_P(buffer, MAX_MESSAGE_LENGTH,
-                 PSTR("EMERGENCY_STOP_COLLISION:%s"), reason);
-      sendBluetoothMessage(buffer);
-      MessageBuffer::releaseBuffer();
+    MessageHandle message;
+    if (message) {
+      message.printf_P(PSTR("EMERGENCY_STOP_COLLISION:%s"), reason);
+      sendBluetoothMessage(message.get(), TX_PRIORITY_HIGH);
     }
 
     // Stop all motors immediately
@@ -240,11 +416,12 @@ void CollisionAvoidance::triggerEmergencyStop(const char *reason) {
 }
 
 void CollisionAvoidance::clearEmergencyStop() {
+  latchedSides = 0;
   if (emergencyStopActive) {
     emergencyStopActive = false;
     DEBUG_PRINTLN_P("✅ Collision avoidance emergency stop cleared");
 
-    sendBluetoothMessage("EMERGENCY_STOP_CLEARED");
+    sendBluetoothMessage("EMERGENCY_STOP_CLEARED", TX_PRIORITY_HIGH);
   }
 }
 
@@ -255,8 +432,9 @@ void CollisionAvoidance::getStatus(char *buffer, size_t bufferSize) {
   const char *emergency = emergencyStopActive ? "ACTIVE" : "CLEAR";
 
   snprintf_P(buffer, bufferSize,
-             PSTR("Collision Avoidance: %s | Emergency Stop: %s"), enabled,
-             emergency);
+             PSTR("Collision Avoidance: %s | Emergency Stop: %s | "
+                  "Limit F:%d R:%d"),
+             enabled, emergency, forwardSpeedLimit, backwardSpeedLimit);
 
   if (SensorManager::isFrontCollisionRisk() ||
       SensorManager::isRearCollisionRisk()) {
@@ -272,23 +450,22 @@ void CollisionAvoidance::getStatus(char *buffer, size_t bufferSize) {
 }
 
 void CollisionAvoidance::sendCollisionWarning(const char *direction) {
-  float distance = (strcmp(direction, "FRONT") == 0)
-                       ? SensorManager::getFrontDistance()
-                       : SensorManager::getRearDistance();
+  uint16_t distance = (strcmp(direction, "FRONT") == 0)
+                          ? SensorManager::getFrontDistanceMm()
+                          : SensorManager::getRearDistanceMm();
 
   DEBUG_PRINT_P("⚠ Collision warning: ");
   DEBUG_PRINT(direction);
   DEBUG_PRINT_P(" obstacle at ");
   DEBUG_PRINT_VAL("", distance);
-  DEBUG_PRINTLN_P("cm");
+  DEBUG_PRINTLN_P("mm");
 
   // Use the optimized collision message formatter
-  if (MessageBuffer::isAvailable()) {
-    char *buffer = MessageBuffer::getBuffer();
-    formatCollisionMessage(direction, distance, buffer, MAX_MESSAGE_LENGTH);
-    extern void sendBluetoothMessage(const char *message);
-    sendBluetoothMessage(buffer);
-    MessageBuffer::releaseBuffer();
+  MessageHandle message;
+  if (message) {
+    formatCollisionMessage(direction, distance, message.get(),
+                           message.size());
+    sendBluetoothMessage(message.get(), TX_PRIORITY_HIGH);
   }
 }
 
@@ -310,12 +487,12 @@ void CollisionAvoidance::setAggressiveness(int level) {
     break;
   }
 
-  DEBUG_PRINTLN("🛡 Collision avoidance aggressiveness set to level " +
-                String(level));
+  DEBUG_PRINT_P("🛡 Collision avoidance aggressiveness set to level ");
+  DEBUG_PRINTLN(level);
 }
 
 int CollisionAvoidance::getAggressiveness() {
-  float collisionDist = SensorManager::getCollisionDistance();
+  int collisionDist = SensorManager::getCollisionDistance();
 
   if (collisionDist >= 20)
     return 1; // Conservative
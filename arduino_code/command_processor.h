@@ -4,29 +4,232 @@
 
 #include "bluetooth_handler.h"
 #include "config.h"
+#include "config_store.h"
+#include "debug_log.h"
+#include "link_probe.h"
+#include "macro_engine.h"
 #include "memory_optimization.h"
 #include "motor_controller.h"
 #include "relay_controller.h"
+#include "report.h"
 #include "sensor_status.h"
 #include "servo_arm.h"
 #include "system_status.h"
+#include "task_scheduler.h"
+#include "trace.h"
+
+// Coalescing classes for continuous setpoints. Servo moves get one class
+// per servo (COALESCE_SERVO_BASE + servo number).
+#define COALESCE_NONE 0
+#define COALESCE_DRIVE 1
+#define COALESCE_SERVO_BASE 2
+
+// Command name table entry - maps a text command to its opcode. The
+// argument carries a fixed parameter such as the servo number of SERVO1-6
+// or the motor number of TEST_FL/RL/FR/RR.
+struct CommandEntry {
+  char name[25];
+  uint8_t opcode;
+  uint8_t arg;
+};
+
+// Sorted by name (strcmp order) for binary search - keep it sorted
+const CommandEntry COMMAND_TABLE[] PROGMEM = {
+    {"ARM_DISABLE", OP_ARM_DISABLE, 0},
+    {"ARM_ENABLE", OP_ARM_ENABLE, 0},
+    {"ARM_HOME", OP_ARM_HOME, 0},
+    {"ARM_PRESET", OP_ARM_PRESET, 0},
+    {"B", OP_BACKWARD, 0},
+    {"BACKWARD", OP_BACKWARD, 0},
+    {"BAUD", OP_BAUD, 0},
+    {"BENCH", OP_BENCH, 0},
+    {"CALIBRATE", OP_CALIBRATE, 0},
+    {"CALIBRATE_SENSORS", OP_CALIBRATE_SENSORS, 0},
+    {"CD", OP_COLLISION_DISTANCE, 0},
+    {"CFG", OP_CONFIG, 0},
+    {"COLLISION_AGGRESSIVENESS", OP_COLLISION_AGGRESSIVENESS, 0},
+    {"COLLISION_DIST", OP_COLLISION_DISTANCE, 0},
+    {"D", OP_DEBUG, 0},
+    {"DEBUG", OP_DEBUG, 0},
+    {"E", OP_EMERGENCY, 0},
+    {"EMERGENCY", OP_EMERGENCY, 0},
+    {"F", OP_FORWARD, 0},
+    {"FORWARD", OP_FORWARD, 0},
+    {"GC", OP_GRIPPER_CLOSE, 0},
+    {"GO", OP_GRIPPER_OPEN, 0},
+    {"GRIPPER_CLOSE", OP_GRIPPER_CLOSE, 0},
+    {"GRIPPER_OPEN", OP_GRIPPER_OPEN, 0},
+    {"H", OP_ARM_HOME, 0},
+    {"HELP", OP_HELP, 0},
+    {"L", OP_LEFT, 0},
+    {"LEFT", OP_LEFT, 0},
+    {"MDEL", OP_MACRO_DELETE, 0},
+    {"MEM", OP_MEM, 0},
+    {"MEND", OP_MACRO_END, 0},
+    {"MLIST", OP_MACRO_LIST, 0},
+    {"MREC", OP_MACRO_RECORD, 0},
+    {"MRUN", OP_MACRO_RUN, 0},
+    {"MSTOP", OP_MACRO_STOP, 0},
+    {"MWAIT", OP_MACRO_WAIT, 0},
+    {"P", OP_ARM_PRESET, 0},
+    {"PB", OP_PING_BURST, 0},
+    {"PERF", OP_PERF, 0},
+    {"PING", OP_PING, 0},
+    {"PN", OP_PING, 0},
+    {"POFF", OP_POWER_OFF, 0},
+    {"PON", OP_POWER_ON, 0},
+    {"PR", OP_PING_REPLY, 0},
+    {"PTOG", OP_POWER_TOGGLE, 0},
+    {"R", OP_RIGHT, 0},
+    {"RESET", OP_RESET, 0},
+    {"RIGHT", OP_RIGHT, 0},
+    {"S", OP_STOP, 0},
+    {"SDS", OP_SENSORS_DISABLE, 0},
+    {"SE", OP_SERVO_MOVE, 0},
+    {"SEN", OP_SENSORS_ENABLE, 0},
+    {"SENSORS_DISABLE", OP_SENSORS_DISABLE, 0},
+    {"SENSORS_ENABLE", OP_SENSORS_ENABLE, 0},
+    {"SENSOR_DETAILED", OP_SENSOR_DETAILED, 0},
+    {"SENSOR_STATUS", OP_SENSOR_STATUS, 0},
+    {"SERVO1", OP_SERVO_MOVE, 1},
+    {"SERVO2", OP_SERVO_MOVE, 2},
+    {"SERVO3", OP_SERVO_MOVE, 3},
+    {"SERVO4", OP_SERVO_MOVE, 4},
+    {"SERVO5", OP_SERVO_MOVE, 5},
+    {"SERVO6", OP_SERVO_MOVE, 6},
+    {"SERVO_BASE", OP_SERVO_MOVE, 1},
+    {"SERVO_ELBOW", OP_SERVO_MOVE, 3},
+    {"SERVO_GRIPPER", OP_SERVO_MOVE, 6},
+    {"SERVO_SHOULDER", OP_SERVO_MOVE, 2},
+    {"SERVO_SPEED", OP_SERVO_SPEED, 0},
+    {"SERVO_WRIST_ROT", OP_SERVO_MOVE, 4},
+    {"SERVO_WRIST_TILT", OP_SERVO_MOVE, 5},
+    {"SP", OP_SPEED, 0},
+    {"SPEED", OP_SPEED, 0},
+    {"SS", OP_SENSOR_STATUS, 0},
+    {"ST", OP_STATUS, 0},
+    {"STATUS", OP_STATUS, 0},
+    {"STOP", OP_STOP, 0},
+    {"T", OP_TANK, 0},
+    {"TANK", OP_TANK, 0},
+    {"TEST_ALL", OP_TEST_MOTORS, 0},
+    {"TEST_FL", OP_TEST_MOTORS, FRONT_LEFT + 1},
+    {"TEST_FR", OP_TEST_MOTORS, FRONT_RIGHT + 1},
+    {"TEST_MOTORS", OP_TEST_MOTORS, 0},
+    {"TEST_RL", OP_TEST_MOTORS, REAR_LEFT + 1},
+    {"TEST_RR", OP_TEST_MOTORS, REAR_RIGHT + 1},
+    {"TEST_SENSORS", OP_TEST_SENSORS, 0},
+    {"TEST_SERVOS", OP_TEST_SERVOS, 0},
+    {"TRACE", OP_TRACE, 0},
+    {"WP", OP_ARM_WAYPOINT, 0}};
+
+#define COMMAND_TABLE_SIZE (sizeof(COMMAND_TABLE) / sizeof(COMMAND_TABLE[0]))
 
 class CommandProcessor {
 private:
+  typedef void (*CommandHandler)(const Command &cmd);
+
   static Command commandQueue[COMMAND_QUEUE_SIZE]; // Reduced queue size
   static int queueHead;
   static int queueTail;
   static int queueSize;
   static unsigned long lastProcessTime;
 
+  // Handler per opcode, indexed by CommandOpcode
+  static const CommandHandler handlers[] PROGMEM;
+
   // Private helper methods
   static bool parseCommand(const char *input, Command &cmd);
+  static bool addBatch(const char *line);
+  // ERR:<seq>,<item>,<reason>; item 0 is the whole batch
+  static void rejectBatch(uint16_t seq, PGM_P reason, uint8_t item = 0);
+  static const CommandEntry *lookupCommand(const char *name);
   static void executeCommand(const Command &cmd);
   static bool isQueueFull();
   static bool isQueueEmpty();
-  static void processMotorCommand(const Command &cmd);
-  static void processServoCommand(const Command &cmd);
-  static void processSystemCommand(const Command &cmd);
+  static Command &queueAt(int position); // 0 = next to execute
+  static void removeAt(int position);
+  static void dropAt(int position, PGM_P reason); // Reports batch items
+  static uint8_t coalesceClass(const Command &cmd);
+  static void queueEmergency(const Command &cmd);
+  static bool checkMovementSafety(const Command &cmd);
+  static void sendFormatted(PGM_P format, int value);
+
+  // Motor command handlers
+  static void handleForward(const Command &cmd);
+  static void handleBackward(const Command &cmd);
+  static void handleLeft(const Command &cmd);
+  static void handleRight(const Command &cmd);
+  static void handleTank(const Command &cmd);
+  static void handleStop(const Command &cmd);
+
+  // Servo command handlers
+  static void handleArmHome(const Command &cmd);
+  static void handleArmPreset(const Command &cmd);
+  static void handleServoMove(const Command &cmd);
+  static void handleGripperOpen(const Command &cmd);
+  static void handleGripperClose(const Command &cmd);
+  static void handleArmWaypoint(const Command &cmd);
+
+  // Sensor command handlers
+  static void handleSensorStatus(const Command &cmd);
+  static void handleSensorsEnable(const Command &cmd);
+  static void handleSensorsDisable(const Command &cmd);
+  static void handleCollisionDistance(const Command &cmd);
+  static void handleCollisionAggressiveness(const Command &cmd);
+  static void handleSensorDetailed(const Command &cmd);
+  static void handleTestSensors(const Command &cmd);
+  static void handleCalibrateSensors(const Command &cmd);
+
+  // System command handlers
+  static void handleStatus(const Command &cmd);
+  static void handleSpeed(const Command &cmd);
+  static void handleDebug(const Command &cmd);
+  static void handleEmergency(const Command &cmd);
+  static void handlePing(const Command &cmd);
+  static void handlePingBurst(const Command &cmd);
+  static void handlePingReply(const Command &cmd);
+  static void handleHelp(const Command &cmd);
+  static void handleTestMotors(const Command &cmd);
+  static void handleTestServos(const Command &cmd);
+  static void handleCalibrate(const Command &cmd);
+  static void handleServoSpeed(const Command &cmd);
+  static void handleArmEnable(const Command &cmd);
+  static void handleArmDisable(const Command &cmd);
+  static void handleReset(const Command &cmd);
+  static void handlePerf(const Command &cmd);
+  static void handleMem(const Command &cmd);
+  static void handleConfig(const Command &cmd);
+  static void handleBench(const Command &cmd);
+  static void handleTrace(const Command &cmd);
+  static void handleBaud(const Command &cmd);
+
+  // Macro command handlers
+  static void handleMacroRecord(const Command &cmd);
+  static void handleMacroWait(const Command &cmd);
+  static void handleMacroEnd(const Command &cmd);
+  static void handleMacroRun(const Command &cmd);
+  static void handleMacroStop(const Command &cmd);
+  static void handleMacroDelete(const Command &cmd);
+  static void handleMacroList(const Command &cmd);
+
+  // Relay command handlers
+  static void handlePowerOn(const Command &cmd);
+  static void handlePowerOff(const Command &cmd);
+  static void handlePowerToggle(const Command &cmd);
+
+  static void handleUnknown(const Command &cmd);
+  static void handleNotFitted(const Command &cmd);
+
+  // Multi-line replies go out from the REPORT task (report.h)
+  static void startReport(const char *response, ReportSource source,
+                          uint16_t argument = 0);
+  static bool helpLine(uint16_t &cursor, uint16_t argument, char *buffer,
+                       size_t bufferSize);
+  static bool perfLine(uint16_t &cursor, uint16_t argument, char *buffer,
+                       size_t bufferSize);
+  static bool memLine(uint16_t &cursor, uint16_t argument, char *buffer,
+                      size_t bufferSize);
 
 public:
   // Initialize command processor
@@ -34,7 +237,7 @@ public:
 
   // Add command to queue
   static bool addCommand(const char *commandString);
-  static bool addCommand(const String &commandString); // Backward compatibility
+  static bool addCommand(const Command &cmd); // Pre-decoded (binary frames)
 
   // Process command queue
   static void processQueue();
@@ -45,11 +248,13 @@ public:
   // Queue management
   static void clearQueue();
   static int getQueueCount();
+
+  // Static RAM of the command queue
+  static size_t getRamUsage();
   static void getQueueStatus(char *buffer, size_t bufferSize);
 
   // Command validation
   static bool isValidCommand(const char *commandString);
-  static void sendCommandHelp();
 };
 
 // Implementation
@@ -59,7 +264,84 @@ int CommandProcessor::queueTail = 0;
 int CommandProcessor::queueSize = 0;
 unsigned long CommandProcessor::lastProcessTime = 0;
 
+// Must follow the CommandOpcode order in config.h
+#if ESP32_BRIDGE_MODE
+// The bridge build has no arm, sensors or relay; their commands fail
+#define FITTED(handler) handleNotFitted
+#else
+#define FITTED(handler) handler
+#endif
+
+const CommandProcessor::CommandHandler CommandProcessor::handlers[] PROGMEM = {
+    handleUnknown,
+
+    // Motor commands
+    handleForward,
+    handleBackward,
+    handleLeft,
+    handleRight,
+    handleTank,
+    handleStop,
+
+    // Servo commands
+    FITTED(handleArmHome),
+    FITTED(handleArmPreset),
+    FITTED(handleServoMove),
+    FITTED(handleGripperOpen),
+    FITTED(handleGripperClose),
+    FITTED(handleArmWaypoint),
+
+    // Sensor commands
+    FITTED(handleSensorStatus),
+    FITTED(handleSensorsEnable),
+    FITTED(handleSensorsDisable),
+    FITTED(handleCollisionDistance),
+    FITTED(handleCollisionAggressiveness),
+    FITTED(handleSensorDetailed),
+    FITTED(handleTestSensors),
+    FITTED(handleCalibrateSensors),
+
+    // System commands
+    handleStatus,
+    handleSpeed,
+    handleDebug,
+    handleEmergency,
+    handlePing,
+    handlePingBurst,
+    handlePingReply,
+    handleHelp,
+    handleTestMotors,
+    FITTED(handleTestServos),
+    FITTED(handleCalibrate),
+    FITTED(handleServoSpeed),
+    FITTED(handleArmEnable),
+    FITTED(handleArmDisable),
+    handleReset,
+    handlePerf,
+    handleMem,
+    handleConfig,
+    handleBench,
+    handleTrace,
+    handleBaud,
+
+    // Macro commands
+    handleMacroRecord,
+    handleMacroWait,
+    handleMacroEnd,
+    handleMacroRun,
+    handleMacroStop,
+    handleMacroDelete,
+    handleMacroList,
+
+    // Relay commands
+    FITTED(handlePowerOn),
+    FITTED(handlePowerOff),
+    FITTED(handlePowerToggle)};
+
 void CommandProcessor::init() {
+  static_assert(sizeof(handlers) == OP_COUNT * sizeof(handlers[0]),
+                "Command handler table out of sync with CommandOpcode");
+
   DEBUG_PRINTLN_P("Initializing Command Processor...");
 
   // Clear queue
@@ -70,11 +352,8 @@ void CommandProcessor::init() {
 }
 
 bool CommandProcessor::addCommand(const char *commandString) {
-  if (isQueueFull()) {
-    DEBUG_PRINTLN_P("Command queue full, dropping command");
-    sendBluetoothMessage("ERROR_QUEUE_FULL");
-    return false;
-  }
+  if (commandString[0] == BATCH_PREFIX)
+    return addBatch(commandString);
 
   Command cmd;
   if (!parseCommand(commandString, cmd)) {
@@ -82,32 +361,218 @@ bool CommandProcessor::addCommand(const char *commandString) {
     return false;
   }
 
+  return addCommand(cmd);
+}
+
+bool CommandProcessor::addCommand(const Command &cmd) {
+  if (cmd.opcode == OP_EMERGENCY) {
+    queueEmergency(cmd);
+    return true;
+  }
+
+#if COMMAND_QUEUE_COALESCE
+  // Replace a pending setpoint of the same class, unless a discrete command
+  // is queued after it - the new setpoint must not overtake that command.
+  // Batches are kept whole: their items neither replace nor get replaced.
+  // Nor is anything merged while a macro records every step.
+  uint8_t group = coalesceClass(cmd);
+  if (group != COALESCE_NONE && cmd.batchSeq == BATCH_NONE &&
+      !MacroEngine::isRecording()) {
+    for (int position = queueSize - 1; position >= 0; position--) {
+      Command &pending = queueAt(position);
+      uint8_t pendingGroup = coalesceClass(pending);
+      if (pendingGroup == COALESCE_NONE || pending.batchSeq != BATCH_NONE)
+        break;
+
+      if (pendingGroup == group) {
+        pending = cmd;
+        pending.queuedAt = micros();
+        return true;
+      }
+    }
+  }
+#endif
+
+  if (isQueueFull()) {
+    if (cmd.batchSeq == BATCH_MACRO)
+      return false; // The macro retries on its next tick
+
+    DEBUG_PRINTLN_P("Command queue full, dropping command");
+    sendBluetoothMessage("ERROR_QUEUE_FULL");
+    return false;
+  }
+
   // Add to queue
   commandQueue[queueTail] = cmd;
+  commandQueue[queueTail].queuedAt = micros();
   queueTail = (queueTail + 1) % COMMAND_QUEUE_SIZE;
   queueSize++;
 
   return true;
 }
 
-// Backward compatibility wrapper
-bool CommandProcessor::addCommand(const String &commandString) {
-  return addCommand(commandString.c_str());
+bool CommandProcessor::addBatch(const char *line) {
+  // @<seq>:<cmd>;<cmd>;...
+  char *header;
+  unsigned long seq = strtoul(line + 1, &header, 10);
+  bool seqValid = seq != BATCH_NONE && seq < BATCH_MACRO;
+  if (*header != ':' || !seqValid) {
+    DEBUG_PRINTLN_P("Invalid batch header");
+    // Answer with what seq there is, so the app isn't left waiting
+    rejectBatch(seqValid ? seq : BATCH_NONE, PSTR("INVALID"));
+    return false;
+  }
+
+  // Check the whole batch before queueing any of it
+  const char *items = header + 1;
+  uint8_t count = 0;
+  const char *start = items;
+  while (true) {
+    const char *separator = strchr(start, BATCH_SEPARATOR);
+    size_t length = separator ? separator - start : strlen(start);
+    if (length == 0 || length >= MAX_COMMAND_LENGTH ||
+        ++count > BATCH_MAX_ITEMS) {
+      rejectBatch(seq, PSTR("INVALID"));
+      return false;
+    }
+    if (!separator)
+      break;
+    start = separator + 1;
+  }
+
+  if (COMMAND_QUEUE_SIZE - queueSize < count) {
+    rejectBatch(seq, PSTR("QUEUE_FULL"));
+    return false;
+  }
+
+  TempString<MAX_COMMAND_LENGTH> item;
+  start = items;
+  for (uint8_t index = 1; index <= count; index++) {
+    const char *separator = strchr(start, BATCH_SEPARATOR);
+    size_t length = separator ? separator - start : strlen(start);
+    memcpy(item.get(), start, length);
+    item.get()[length] = '\0';
+
+    Command cmd;
+    parseCommand(item.get(), cmd);
+
+    // An emergency stop still jumps the queue, with its own ack
+    if (cmd.opcode != OP_EMERGENCY) {
+      cmd.batchSeq = seq;
+      cmd.batchItem = index;
+    }
+    addCommand(cmd);
+    start = separator + 1;
+  }
+  return true;
+}
+
+void CommandProcessor::rejectBatch(uint16_t seq, PGM_P reason,
+                                   uint8_t item) {
+  DEBUG_PRINTLN_P("Batch rejected");
+  MessageHandle message;
+  if (message) {
+    char name[12];
+    strcpy_P(name, reason);
+    message.printf_P(PSTR("ERR:%u,%u,%s"), seq, item, name);
+    BluetoothHandler::sendMessage(message.get(), TX_PRIORITY_HIGH);
+  }
+}
+
+void CommandProcessor::queueEmergency(const Command &cmd) {
+  // Pending setpoints would restart motion right after the stop
+  for (int position = 0; position < queueSize;) {
+    if (coalesceClass(queueAt(position)) != COALESCE_NONE) {
+      dropAt(position, PSTR("ESTOP"));
+    } else {
+      position++;
+    }
+  }
+
+  // Never drop the stop itself; sacrifice the newest command instead
+  if (isQueueFull()) {
+    DEBUG_PRINTLN_P("Command queue full, dropping newest for emergency");
+    dropAt(queueSize - 1, PSTR("QUEUE_FULL"));
+  }
+
+  // Jump to the front of the queue
+  queueHead = (queueHead + COMMAND_QUEUE_SIZE - 1) % COMMAND_QUEUE_SIZE;
+  commandQueue[queueHead] = cmd;
+  commandQueue[queueHead].queuedAt = micros();
+  queueSize++;
+}
+
+uint8_t CommandProcessor::coalesceClass(const Command &cmd) {
+  switch (cmd.opcode) {
+  case OP_FORWARD:
+  case OP_BACKWARD:
+  case OP_LEFT:
+  case OP_RIGHT:
+  case OP_TANK:
+    return COALESCE_DRIVE;
+  case OP_SERVO_MOVE:
+    return COALESCE_SERVO_BASE + constrain(cmd.value1, 0, 6);
+  default:
+    return COALESCE_NONE;
+  }
+}
+
+Command &CommandProcessor::queueAt(int position) {
+  return commandQueue[(queueHead + position) % COMMAND_QUEUE_SIZE];
+}
+
+void CommandProcessor::removeAt(int position) {
+  for (int i = position; i < queueSize - 1; i++) {
+    queueAt(i) = queueAt(i + 1);
+  }
+  queueTail = (queueTail + COMMAND_QUEUE_SIZE - 1) % COMMAND_QUEUE_SIZE;
+  queueSize--;
 }
 
+void CommandProcessor::dropAt(int position, PGM_P reason) {
+  // A batch item that never runs must not be covered by a later ACK
+  const Command &cmd = queueAt(position);
+  if (cmd.batchSeq != BATCH_NONE && cmd.batchSeq != BATCH_MACRO)
+    rejectBatch(cmd.batchSeq, reason, cmd.batchItem);
+  removeAt(position);
+}
+
+// Backward compatibility wrapper
 void CommandProcessor::processQueue() {
   // Process fewer commands per loop to save memory
   int commandsProcessed = 0;
   const int maxCommandsPerLoop = 2; // Reduced from 3
+  bool batchOpen = false;
+  uint16_t batchDone = BATCH_NONE;
 
-  while (!isQueueEmpty() && commandsProcessed < maxCommandsPerLoop) {
+  // A batch runs to its last item in the same tick, past the limit
+  while (!isQueueEmpty() &&
+         (commandsProcessed < maxCommandsPerLoop || batchOpen)) {
     Command cmd = commandQueue[queueHead];
     queueHead = (queueHead + 1) % COMMAND_QUEUE_SIZE;
     queueSize--;
 
+    PerfMonitor::record(PROBE_CMD_QUEUE, micros() - cmd.queuedAt);
     executeCommand(cmd);
     commandsProcessed++;
     lastProcessTime = millis();
+
+    if (cmd.batchSeq != BATCH_NONE && cmd.batchSeq != BATCH_MACRO) {
+      const Command &next = queueAt(0);
+      batchOpen = !isQueueEmpty() && next.batchSeq == cmd.batchSeq &&
+                  next.batchItem > cmd.batchItem;
+      if (!batchOpen)
+        batchDone = cmd.batchSeq;
+    }
+  }
+
+  // ACK:<seq> also covers any earlier batch finished in this tick
+  if (batchDone != BATCH_NONE) {
+    MessageHandle message;
+    if (message) {
+      message.printf_P(PSTR("ACK:%u"), batchDone);
+      BluetoothHandler::sendMessage(message.get(), TX_PRIORITY_HIGH);
+    }
   }
 }
 
@@ -131,6 +596,8 @@ bool CommandProcessor::parseCommand(const char *input, Command &cmd) {
   }
 
   cmd.timestamp = millis();
+  cmd.batchSeq = BATCH_NONE;
+  cmd.batchItem = 0;
 
   // Parse command components
   char *colonPos = strchr(str, ':');
@@ -141,19 +608,15 @@ bool CommandProcessor::parseCommand(const char *input, Command &cmd) {
     strncpy(cmd.type, str, sizeof(cmd.type) - 1);
     cmd.type[sizeof(cmd.type) - 1] = '\0';
 
+    // The raw text is kept for fields wider than an int (PN, PR).
+    // strtol saturates where atoi overflow would be undefined.
     char *params = colonPos + 1;
-    if (commaPos && commaPos > colonPos) {
-      *commaPos = '\0'; // Split at comma
-      strncpy(cmd.parameter, params, sizeof(cmd.parameter) - 1);
-      cmd.parameter[sizeof(cmd.parameter) - 1] = '\0';
-      cmd.value1 = atoi(params);
-      cmd.value2 = atoi(commaPos + 1);
-    } else {
-      strncpy(cmd.parameter, params, sizeof(cmd.parameter) - 1);
-      cmd.parameter[sizeof(cmd.parameter) - 1] = '\0';
-      cmd.value1 = atoi(params);
-      cmd.value2 = 0;
-    }
+    strncpy(cmd.parameter, params, sizeof(cmd.parameter) - 1);
+    cmd.parameter[sizeof(cmd.parameter) - 1] = '\0';
+    cmd.value1 = (int)strtol(params, nullptr, 10);
+    cmd.value2 =
+        commaPos && commaPos > colonPos ? (int)strtol(commaPos + 1, nullptr, 10)
+                                        : 0;
   } else {
     strncpy(cmd.type, str, sizeof(cmd.type) - 1);
     cmd.type[sizeof(cmd.type) - 1] = '\0';
@@ -162,345 +625,682 @@ bool CommandProcessor::parseCommand(const char *input, Command &cmd) {
     cmd.value2 = 0;
   }
 
+  // Resolve the opcode once from the full (untruncated) command name
+  const CommandEntry *entry = lookupCommand(str);
+  if (entry) {
+    cmd.opcode = pgm_read_byte(&entry->opcode);
+
+    // Named servo commands (SERVO1:angle) become SE:servo,angle and
+    // single motor tests (TEST_FL:speed) TEST_MOTORS:motor,speed
+    uint8_t arg = pgm_read_byte(&entry->arg);
+    if ((cmd.opcode == OP_SERVO_MOVE || cmd.opcode == OP_TEST_MOTORS) &&
+        arg != 0) {
+      cmd.value2 = cmd.value1;
+      cmd.value1 = arg;
+    }
+  } else {
+    cmd.opcode = OP_UNKNOWN;
+  }
+
   return true;
 }
 
+const CommandEntry *CommandProcessor::lookupCommand(const char *name) {
+  int low = 0;
+  int high = COMMAND_TABLE_SIZE - 1;
+
+  while (low <= high) {
+    int mid = (low + high) / 2;
+    int result = strcmp_P(name, COMMAND_TABLE[mid].name);
+    if (result == 0) {
+      return &COMMAND_TABLE[mid];
+    } else if (result < 0) {
+      high = mid - 1;
+    } else {
+      low = mid + 1;
+    }
+  }
+  return nullptr;
+}
+
 void CommandProcessor::executeCommand(const Command &cmd) {
-  DEBUG_PRINT_P("⚡ Executing: ");
-  DEBUG_PRINTLN(cmd.type);
+  LOG_INFO(COMMAND, LOG_MSG_EXECUTE, cmd.opcode);
 
-  // Route command to appropriate subsystem
-  if (strcmp(cmd.type, CMD_FORWARD) == 0 ||
-      strcmp(cmd.type, CMD_BACKWARD) == 0 || strcmp(cmd.type, CMD_LEFT) == 0 ||
-      strcmp(cmd.type, CMD_RIGHT) == 0 || strcmp(cmd.type, CMD_TANK) == 0 ||
-      strcmp(cmd.type, CMD_STOP) == 0) {
-    processMotorCommand(cmd);
+  // Route command through the opcode table
+  uint8_t opcode = cmd.opcode < OP_COUNT ? cmd.opcode : (uint8_t)OP_UNKNOWN;
+  CommandHandler handler = (CommandHandler)pgm_read_ptr(&handlers[opcode]);
 
-  } else if (strncmp(cmd.type, "SE", 2) == 0 ||
-             strncmp(cmd.type, "H", 1) == 0 || strncmp(cmd.type, "G", 1) == 0) {
-    processServoCommand(cmd);
+  // Steps left in the queue when their macro was stopped
+  bool macroStep = cmd.batchSeq == BATCH_MACRO;
+  if (macroStep && !MacroEngine::isRunning())
+    return;
 
-  } else {
-    processSystemCommand(cmd);
+  // While a macro is recorded its steps are stored instead of run
+  if (MacroEngine::isRecording() && MacroEngine::isRecordable(cmd.opcode) &&
+      !macroStep) {
+    bool stored = MacroEngine::recordStep(cmd);
+    const char *reply = stored                  ? "MREC"
+                        : MacroEngine::isFull() ? "MACRO_FULL"
+                                                : "MACRO_BUSY";
+    BluetoothHandler::sendResponse(reply, stored);
+    return;
+  }
+
+  unsigned long startTime = micros();
+  BluetoothHandler::setResponseBatch(cmd.batchSeq, cmd.batchItem);
+  handler(cmd);
+  bool failed = BluetoothHandler::batchItemFailed();
+  BluetoothHandler::setResponseBatch(BATCH_NONE, 0);
+  PerfMonitor::record(PROBE_CMD_EXEC, micros() - startTime);
+  if (macroStep)
+    MacroEngine::onStepDone(cmd, failed);
+  CommandTrace::onCommandDone(cmd);
+}
+
+void CommandProcessor::sendFormatted(PGM_P format, int value) {
+  MessageHandle message;
+  if (message) {
+    message.printf_P(format, value);
+    BluetoothHandler::sendMessage(message.get());
   }
 }
 
-void CommandProcessor::processMotorCommand(const Command &cmd) {
+// ========== MOTOR COMMANDS ==========
+
+bool CommandProcessor::checkMovementSafety(const Command &cmd) {
   // Check collision avoidance before executing motor commands
-  if (!CollisionAvoidance::isMovementSafe(cmd.type, cmd.value1)) {
-    // Use message buffer for blocked message
-    if (MessageBuffer::isAvailable()) {
-      char *buffer = MessageBuffer::getBuffer();
-      snprintf_P(buffer, MAX_MESSAGE_LENGTH,
-                 PSTR("BLOCKED_BY_COLLISION_AVOIDANCE:%s"), cmd.type);
-      BluetoothHandler::sendMessage(buffer);
-      MessageBuffer::releaseBuffer();
-    }
-    BluetoothHandler::sendResponse(cmd.type, false);
-    return;
+  if (CollisionAvoidance::isMovementSafe(cmd.opcode, cmd.value1)) {
+    return true;
   }
 
-  if (strcmp(cmd.type, CMD_FORWARD) == 0) {
-    int speed = constrain(cmd.value1, 0, 100);
-    // Apply collision avoidance speed adjustment
-    speed = CollisionAvoidance::adjustSpeedForSafety(speed, true);
-    MotorController::moveForward(speed);
-    BluetoothHandler::sendResponse(CMD_FORWARD);
-
-  } else if (strcmp(cmd.type, CMD_BACKWARD) == 0) {
-    int speed = constrain(cmd.value1, 0, 100);
-    // Apply collision avoidance speed adjustment
-    speed = CollisionAvoidance::adjustSpeedForSafety(speed, false);
-    MotorController::moveBackward(speed);
-    BluetoothHandler::sendResponse(CMD_BACKWARD);
-
-  } else if (strcmp(cmd.type, CMD_LEFT) == 0) {
-    int speed = constrain(cmd.value1, 0, 100);
-    MotorController::turnLeft(speed);
-    BluetoothHandler::sendResponse(CMD_LEFT);
-
-  } else if (strcmp(cmd.type, CMD_RIGHT) == 0) {
-    int speed = constrain(cmd.value1, 0, 100);
-    MotorController::turnRight(speed);
-    BluetoothHandler::sendResponse(CMD_RIGHT);
-
-  } else if (strcmp(cmd.type, CMD_TANK) == 0) {
-    int leftSpeed = constrain(cmd.value1, -100, 100);
-    int rightSpeed = constrain(cmd.value2, -100, 100);
-    MotorController::tankDrive(leftSpeed, rightSpeed);
-    BluetoothHandler::sendResponse(CMD_TANK);
-
-  } else if (strcmp(cmd.type, CMD_STOP) == 0) {
-    MotorController::stopAll();
-    BluetoothHandler::sendResponse(CMD_STOP);
-  }
-}
-
-void CommandProcessor::processServoCommand(const Command &cmd) {
-  if (strcmp(cmd.type, CMD_ARM_HOME) == 0) {
-    ServoArm::moveToHome();
-    BluetoothHandler::sendResponse(CMD_ARM_HOME);
-
-  } else if (strcmp(cmd.type, CMD_ARM_PRESET) == 0) {
-    int preset = constrain(cmd.value1, 1, 5);
-    ServoArm::moveToPreset(preset);
-    BluetoothHandler::sendResponse(CMD_ARM_PRESET);
-
-  } else if (strcmp(cmd.type, CMD_GRIPPER_OPEN) == 0) {
-    ServoArm::openGripper();
-    BluetoothHandler::sendResponse(CMD_GRIPPER_OPEN);
-
-  } else if (strcmp(cmd.type, CMD_GRIPPER_CLOSE) == 0) {
-    ServoArm::closeGripper();
-    BluetoothHandler::sendResponse(CMD_GRIPPER_CLOSE);
-
-  } else if (strncmp(cmd.type, "SERVO", 5) == 0) {
-    // Parse servo command (e.g., SERVO1:90, SERVO_BASE:45)
-    int servoIndex = -1;
-
-    if (strcmp(cmd.type, "SERVO1") == 0 ||
-        strcmp(cmd.type, "SERVO_BASE") == 0) {
-      servoIndex = SERVO_BASE_IDX;
-    } else if (strcmp(cmd.type, "SERVO2") == 0 ||
-               strcmp(cmd.type, "SERVO_SHOULDER") == 0) {
-      servoIndex = SERVO_SHOULDER_IDX;
-    } else if (strcmp(cmd.type, "SERVO3") == 0 ||
-               strcmp(cmd.type, "SERVO_ELBOW") == 0) {
-      servoIndex = SERVO_ELBOW_IDX;
-    } else if (strcmp(cmd.type, "SERVO4") == 0 ||
-               strcmp(cmd.type, "SERVO_WRIST_ROT") == 0) {
-      servoIndex = SERVO_WRIST_ROT_IDX;
-    } else if (strcmp(cmd.type, "SERVO5") == 0 ||
-               strcmp(cmd.type, "SERVO_WRIST_TILT") == 0) {
-      servoIndex = SERVO_WRIST_TILT_IDX;
-    } else if (strcmp(cmd.type, "SERVO6") == 0 ||
-               strcmp(cmd.type, "SERVO_GRIPPER") == 0) {
-      servoIndex = SERVO_GRIPPER_IDX;
-    }
+  // Use message buffer for blocked message
+  MessageHandle message;
+  if (message) {
+    message.printf_P(PSTR("BLOCKED_BY_COLLISION_AVOIDANCE:%s"), cmd.type);
+    BluetoothHandler::sendMessage(message.get(), TX_PRIORITY_HIGH);
+  }
+  BluetoothHandler::sendResponse(cmd.type, false);
+  return false;
+}
 
-    if (servoIndex >= 0) {
-      int angle = constrain(cmd.value1, SERVO_MIN_ANGLE, SERVO_MAX_ANGLE);
-      ServoArm::setServoAngle(servoIndex, angle);
-      BluetoothHandler::sendResponse(cmd.type);
-    } else {
-      // Invalid servo command format
-      if (MessageBuffer::isAvailable()) {
-        char *buffer = MessageBuffer::getBuffer();
-        snprintf_P(buffer, MAX_MESSAGE_LENGTH, PSTR("ERROR_%s_INVALID"),
-                   cmd.type);
-        BluetoothHandler::sendMessage(buffer);
-        MessageBuffer::releaseBuffer();
-      }
+void CommandProcessor::handleForward(const Command &cmd) {
+  if (!checkMovementSafety(cmd))
+    return;
+
+  int speed = constrain(cmd.value1, 0, 100);
+  // Apply collision avoidance speed adjustment
+  speed = CollisionAvoidance::adjustSpeedForSafety(speed, true);
+  MotorController::moveForward(speed);
+  BluetoothHandler::sendResponse(CMD_FORWARD);
+}
+
+void CommandProcessor::handleBackward(const Command &cmd) {
+  if (!checkMovementSafety(cmd))
+    return;
+
+  int speed = constrain(cmd.value1, 0, 100);
+  // Apply collision avoidance speed adjustment
+  speed = CollisionAvoidance::adjustSpeedForSafety(speed, false);
+  MotorController::moveBackward(speed);
+  BluetoothHandler::sendResponse(CMD_BACKWARD);
+}
+
+void CommandProcessor::handleLeft(const Command &cmd) {
+  if (!checkMovementSafety(cmd))
+    return;
+
+  int speed = constrain(cmd.value1, 0, 100);
+  MotorController::turnLeft(speed);
+  BluetoothHandler::sendResponse(CMD_LEFT);
+}
+
+void CommandProcessor::handleRight(const Command &cmd) {
+  if (!checkMovementSafety(cmd))
+    return;
+
+  int speed = constrain(cmd.value1, 0, 100);
+  MotorController::turnRight(speed);
+  BluetoothHandler::sendResponse(CMD_RIGHT);
+}
+
+void CommandProcessor::handleTank(const Command &cmd) {
+  if (!checkMovementSafety(cmd))
+    return;
+
+  int leftSpeed = constrain(cmd.value1, -100, 100);
+  int rightSpeed = constrain(cmd.value2, -100, 100);
+  MotorController::tankDrive(leftSpeed, rightSpeed);
+  BluetoothHandler::sendResponse(CMD_TANK);
+}
+
+void CommandProcessor::handleStop(const Command &cmd) {
+  MotorController::stopAll();
+  BluetoothHandler::sendResponse(CMD_STOP);
+}
+
+// ========== SERVO COMMANDS ==========
+
+void CommandProcessor::handleArmHome(const Command &cmd) {
+  ServoArm::moveToHome();
+  BluetoothHandler::sendResponse(CMD_ARM_HOME);
+}
+
+void CommandProcessor::handleArmPreset(const Command &cmd) {
+  int preset = constrain(cmd.value1, 1, 5);
+  ServoArm::moveToPreset(preset);
+  BluetoothHandler::sendResponse(CMD_ARM_PRESET);
+}
+
+void CommandProcessor::handleServoMove(const Command &cmd) {
+  // value1 = servo number (1-6), value2 = angle
+  int servoIndex = cmd.value1 - 1;
+
+  if (servoIndex >= SERVO_BASE_IDX && servoIndex <= SERVO_GRIPPER_IDX) {
+    int angle = constrain(cmd.value2, SERVO_MIN_ANGLE, SERVO_MAX_ANGLE);
+    ServoArm::setServoAngle(servoIndex, angle);
+    BluetoothHandler::sendResponse(cmd.type);
+  } else {
+    // Invalid servo command format
+    MessageHandle message;
+    if (message) {
+      message.printf_P(PSTR("ERROR_%s_INVALID"), cmd.type);
+      BluetoothHandler::sendMessage(message.get());
     }
   }
 }
 
-void CommandProcessor::processSystemCommand(const Command &cmd) {
-  if (cmd.type == CMD_STATUS) {
-    // Use char buffers instead of String objects for better memory efficiency
-    char motorStatus[64], servoStatus[64], systemStatus[64], relayStatus[64];
-    MotorController::getStatus(motorStatus, sizeof(motorStatus));
-    ServoArm::getStatus(servoStatus, sizeof(servoStatus));
-    RelayController::getStatus(relayStatus, sizeof(relayStatus));
-    // SystemStatus::getStatus(systemStatus, sizeof(systemStatus));  //
-    // Temporarily disabled
-    strcpy_P(systemStatus, PSTR("SYS:OK"));
-
-    // Send status messages using buffer formatting
-    if (MessageBuffer::isAvailable()) {
-      char *buffer = MessageBuffer::getBuffer();
-      snprintf_P(buffer, MAX_MESSAGE_LENGTH, PSTR("STATUS_MOTORS:%s"),
-                 motorStatus);
-      BluetoothHandler::sendMessage(buffer);
-      MessageBuffer::releaseBuffer();
-    }
+void CommandProcessor::handleGripperOpen(const Command &cmd) {
+  ServoArm::openGripper();
+  BluetoothHandler::sendResponse(CMD_GRIPPER_OPEN);
+}
 
-    if (MessageBuffer::isAvailable()) {
-      char *buffer = MessageBuffer::getBuffer();
-      snprintf_P(buffer, MAX_MESSAGE_LENGTH, PSTR("STATUS_SERVOS:%s"),
-                 servoStatus);
-      BluetoothHandler::sendMessage(buffer);
-      MessageBuffer::releaseBuffer();
-    }
+void CommandProcessor::handleGripperClose(const Command &cmd) {
+  ServoArm::closeGripper();
+  BluetoothHandler::sendResponse(CMD_GRIPPER_CLOSE);
+}
 
-    if (MessageBuffer::isAvailable()) {
-      char *buffer = MessageBuffer::getBuffer();
-      snprintf_P(buffer, MAX_MESSAGE_LENGTH, PSTR("STATUS_RELAY:%s"),
-                 relayStatus);
-      BluetoothHandler::sendMessage(buffer);
-      MessageBuffer::releaseBuffer();
-    }
+void CommandProcessor::handleArmWaypoint(const Command &cmd) {
+  // value1 = preset (0 = home), value2 = duration in ms (0 = servo speed)
+  int preset = constrain(cmd.value1, 0, 5);
+  uint16_t duration = constrain(cmd.value2, 0, SERVO_MAX_MOVE_MS);
 
-    if (MessageBuffer::isAvailable()) {
-      char *buffer = MessageBuffer::getBuffer();
-      snprintf_P(buffer, MAX_MESSAGE_LENGTH, PSTR("STATUS_SYSTEM:%s"),
-                 systemStatus);
-      BluetoothHandler::sendMessage(buffer);
-      MessageBuffer::releaseBuffer();
-    }
+  if (ServoArm::queuePreset(preset, duration)) {
+    BluetoothHandler::sendResponse(CMD_ARM_WAYPOINT);
+  } else {
+    BluetoothHandler::sendMessage("ERROR_WP_FULL");
+  }
+}
 
-    BluetoothHandler::sendResponse(CMD_STATUS);
+// ========== SENSOR COMMANDS ==========
 
-  } else if (cmd.type == CMD_SPEED) {
-    int speed = constrain(cmd.value1, 20, 100);
-    MotorController::setGlobalSpeed(speed);
+void CommandProcessor::handleSensorStatus(const Command &cmd) {
+  SensorStatusManager::sendStatusNow();
+  BluetoothHandler::sendResponse(CMD_SENSOR_STATUS);
+}
 
-    if (MessageBuffer::isAvailable()) {
-      char *buffer = MessageBuffer::getBuffer();
-      snprintf_P(buffer, MAX_MESSAGE_LENGTH, PSTR("SPEED_SET:%d"), speed);
-      BluetoothHandler::sendMessage(buffer);
-      MessageBuffer::releaseBuffer();
-    }
-    BluetoothHandler::sendResponse(CMD_SPEED);
+void CommandProcessor::handleSensorsEnable(const Command &cmd) {
+  SensorManager::enableSensors();
+  CollisionAvoidance::enable();
+  BluetoothHandler::sendResponse(CMD_SENSORS_ENABLE);
+}
 
-  } else if (cmd.type == CMD_DEBUG) {
-    // Toggle debug mode
-    // SystemStatus::setDebugMode(cmd.value1 == 1);  // Temporarily disabled
+void CommandProcessor::handleSensorsDisable(const Command &cmd) {
+  SensorManager::disableSensors();
+  CollisionAvoidance::disable();
+  BluetoothHandler::sendResponse(CMD_SENSORS_DISABLE);
+}
 
-    if (MessageBuffer::isAvailable()) {
-      char *buffer = MessageBuffer::getBuffer();
-      snprintf_P(buffer, MAX_MESSAGE_LENGTH, PSTR("DEBUG_MODE:%d"), cmd.value1);
-      BluetoothHandler::sendMessage(buffer);
-      MessageBuffer::releaseBuffer();
-    }
-    BluetoothHandler::sendResponse(CMD_DEBUG);
+void CommandProcessor::handleCollisionDistance(const Command &cmd) {
+  int distance = constrain(cmd.value1, 5, 100);
+  SensorManager::setCollisionDistance(distance);
 
-  } else if (cmd.type == CMD_EMERGENCY) {
-    MotorController::emergencyStop();
-    ServoArm::emergencyStop();
-    // SystemStatus::setEmergencyStop(true);  // Temporarily disabled
-    BluetoothHandler::sendMessage("EMERGENCY_STOP_ACTIVATED");
-    BluetoothHandler::sendResponse(CMD_EMERGENCY);
+  MessageHandle message;
+  if (message) {
+    char distStr[8];
+    formatDistance(CM_TO_MM(distance), distStr, sizeof(distStr));
+    message.printf_P(PSTR("COLLISION_DISTANCE_SET:%s"), distStr);
+    BluetoothHandler::sendMessage(message.get());
+  }
+  BluetoothHandler::sendResponse(CMD_COLLISION_DISTANCE);
+}
+
+void CommandProcessor::handleCollisionAggressiveness(const Command &cmd) {
+  int level = constrain(cmd.value1, 1, 3);
+  CollisionAvoidance::setAggressiveness(level);
+  sendFormatted(PSTR("AGGRESSIVENESS_SET:%d"), level);
+  BluetoothHandler::sendResponse("COLLISION_AGGRESSIVENESS");
+}
 
-  } else if (cmd.type == CMD_PING) {
-    BluetoothHandler::sendMessage(RESP_PONG);
+void CommandProcessor::handleSensorDetailed(const Command &cmd) {
+  SensorStatusManager::sendDetailedStatus();
+  BluetoothHandler::sendResponse("SENSOR_DETAILED");
+}
+
+void CommandProcessor::handleTestSensors(const Command &cmd) {
+  SensorManager::testSensors();
+  BluetoothHandler::sendResponse("TEST_SENSORS");
+}
 
-  } else if (cmd.type == "HELP") {
-    sendCommandHelp();
-    BluetoothHandler::sendResponse("HELP");
+void CommandProcessor::handleCalibrateSensors(const Command &cmd) {
+  SensorManager::calibrateSensors();
+  BluetoothHandler::sendResponse("CALIBRATE_SENSORS");
+}
+
+// ========== SYSTEM COMMANDS ==========
+
+void CommandProcessor::handleStatus(const Command &cmd) {
+  // Use char buffers instead of String objects for better memory efficiency
+  char motorStatus[64], systemStatus[64];
+  MotorController::getStatus(motorStatus, sizeof(motorStatus));
+#if !ESP32_BRIDGE_MODE
+  char servoStatus[64], relayStatus[64];
+  ServoArm::getStatus(servoStatus, sizeof(servoStatus));
+  RelayController::getStatus(relayStatus, sizeof(relayStatus));
+#endif
+  // SystemStatus::getStatus(systemStatus, sizeof(systemStatus));  //
+  // Temporarily disabled
+  strcpy_P(systemStatus, PSTR("SYS:OK"));
+
+  // Send status messages using buffer formatting
+  MessageHandle message(MAX_MESSAGE_LENGTH);
+  if (message) {
+    message.printf_P(PSTR("STATUS_MOTORS:%s"), motorStatus);
+    BluetoothHandler::sendMessage(message.get());
+
+#if !ESP32_BRIDGE_MODE
+    message.printf_P(PSTR("STATUS_SERVOS:%s"), servoStatus);
+    BluetoothHandler::sendMessage(message.get());
+
+    message.printf_P(PSTR("STATUS_RELAY:%s"), relayStatus);
+    BluetoothHandler::sendMessage(message.get());
+#endif
+
+    message.printf_P(PSTR("STATUS_SYSTEM:%s"), systemStatus);
+    BluetoothHandler::sendMessage(message.get());
+  }
+
+  BluetoothHandler::sendResponse(CMD_STATUS);
+}
+
+void CommandProcessor::handleSpeed(const Command &cmd) {
+  int speed = constrain(cmd.value1, 20, 100);
+  MotorController::setGlobalSpeed(speed);
+  sendFormatted(PSTR("SPEED_SET:%d"), speed);
+  BluetoothHandler::sendResponse(CMD_SPEED);
+}
+
+void CommandProcessor::handleDebug(const Command &cmd) {
+  // Toggle debug mode
+  // SystemStatus::setDebugMode(cmd.value1 == 1);  // Temporarily disabled
+  sendFormatted(PSTR("DEBUG_MODE:%d"), cmd.value1);
+  BluetoothHandler::sendResponse(CMD_DEBUG);
+}
+
+void CommandProcessor::handleEmergency(const Command &cmd) {
+  MotorController::emergencyStop();
+#if !ESP32_BRIDGE_MODE
+  ServoArm::emergencyStop();
+#endif
+  MacroEngine::abort(PSTR("ESTOP"));
+  // SystemStatus::setEmergencyStop(true);  // Temporarily disabled
+  BluetoothHandler::sendMessage("EMERGENCY_STOP_ACTIVATED", TX_PRIORITY_HIGH);
+  BluetoothHandler::sendResponse(CMD_EMERGENCY);
+}
+
+void CommandProcessor::handlePing(const Command &cmd) {
+  if (cmd.parameter[0] == '\0') {
+    BluetoothHandler::sendMessage(RESP_PONG, TX_PRIORITY_HIGH);
+    return;
+  }
+
+  // PN:<seq>,<host_ts> - echo both with the receive (queued), dequeue
+  // (handler start) and ack times in micros(), so the app can split link
+  // time from firmware queueing. host_ts goes back unchanged, all 32 bits.
+  unsigned long dequeuedAt = micros();
+  char *end;
+  unsigned long seq = strtoul(cmd.parameter, &end, 10);
+  unsigned long hostTs = *end == ',' ? strtoul(end + 1, nullptr, 10) : 0;
+  MessageHandle message;
+  if (message) {
+    message.printf_P(PSTR(RESP_PONG ":%lu,%lu,%lu,%lu,%lu"), seq, hostTs,
+                     cmd.queuedAt, dequeuedAt, micros());
+    BluetoothHandler::sendMessage(message.get(), TX_PRIORITY_HIGH);
+  }
+}
 
-  } else if (cmd.type == "TEST_MOTORS") {
+void CommandProcessor::handlePingBurst(const Command &cmd) {
+  LinkProbe::startBurst(cmd.value1 > 0 ? cmd.value1 : 1);
+  BluetoothHandler::sendResponse("PB");
+}
+
+void CommandProcessor::handlePingReply(const Command &cmd) {
+  // No ack: it would sit in the same queue as the next ping
+  LinkProbe::onReply((uint16_t)strtoul(cmd.parameter, nullptr, 10));
+}
+
+void CommandProcessor::handleHelp(const Command &cmd) {
+  startReport("HELP", helpLine);
+}
+
+void CommandProcessor::handleTestMotors(const Command &cmd) {
+  // TEST_MOTORS:motor,speed runs one motor (1-4, in FRONT_LEFT order)
+  if (cmd.value1 >= 1 && cmd.value1 <= 4) {
+    MotorController::testMotor(cmd.value1 - 1,
+                               constrain(cmd.value2, -100, 100));
+  } else {
     MotorController::testAllMotors();
-    BluetoothHandler::sendResponse("TEST_MOTORS");
+  }
+  BluetoothHandler::sendResponse("TEST_MOTORS");
+}
+
+void CommandProcessor::handleTestServos(const Command &cmd) {
+  ServoArm::testAllServos();
+  BluetoothHandler::sendResponse("TEST_SERVOS");
+}
+
+void CommandProcessor::handleCalibrate(const Command &cmd) {
+  ServoArm::calibrateServos();
+  BluetoothHandler::sendResponse("CALIBRATE");
+}
+
+void CommandProcessor::handleServoSpeed(const Command &cmd) {
+  int speed = constrain(cmd.value1, SERVO_SPEED_SLOW, SERVO_SPEED_FAST);
+  ServoArm::setMovementSpeed(speed);
+  sendFormatted(PSTR("SERVO_SPEED_SET:%d"), speed);
+  BluetoothHandler::sendResponse("SERVO_SPEED");
+}
+
+void CommandProcessor::handleArmEnable(const Command &cmd) {
+  ServoArm::enableArm();
+  BluetoothHandler::sendResponse("ARM_ENABLE");
+}
+
+void CommandProcessor::handleArmDisable(const Command &cmd) {
+  ServoArm::disableArm();
+  BluetoothHandler::sendResponse("ARM_DISABLE");
+}
+
+void CommandProcessor::handleReset(const Command &cmd) {
+  // SystemStatus::resetSystem();  // Temporarily disabled
+  BluetoothHandler::sendResponse("RESET");
+}
 
-  } else if (cmd.type == "TEST_SERVOS") {
-    ServoArm::testAllServos();
-    BluetoothHandler::sendResponse("TEST_SERVOS");
+// ========== DIAGNOSTIC COMMANDS ==========
 
-  } else if (cmd.type == "CALIBRATE") {
-    ServoArm::calibrateServos();
-    BluetoothHandler::sendResponse("CALIBRATE");
+void CommandProcessor::handlePerf(const Command &cmd) {
+  // PERF:1 starts a fresh measurement window once the report is out
+  startReport("PERF", perfLine, cmd.value1 == 1);
+}
 
-  } else if (cmd.type == "SERVO_SPEED") {
-    int speed = constrain(cmd.value1, SERVO_SPEED_SLOW, SERVO_SPEED_FAST);
-    ServoArm::setMovementSpeed(speed);
+// The bucket list, one line per probe, then the TX and pool totals
+bool CommandProcessor::perfLine(uint16_t &cursor, uint16_t argument,
+                                char *buffer, size_t bufferSize) {
+  if (cursor == 0) {
+    cursor++;
+    snprintf_P(buffer, bufferSize,
+               PSTR("PERF_BUCKETS_US:16,64,256,1024,4096,16384,65536"));
+    return true;
+  }
 
-    if (MessageBuffer::isAvailable()) {
-      char *buffer = MessageBuffer::getBuffer();
-      snprintf_P(buffer, MAX_MESSAGE_LENGTH, PSTR("SERVO_SPEED_SET:%d"), speed);
-      BluetoothHandler::sendMessage(buffer);
-      MessageBuffer::releaseBuffer();
+  char name[12];
+  while (cursor <= PERF_PROBE_COUNT) {
+    uint8_t probe = cursor++ - 1;
+    const Task *task = nullptr;
+    if (probe == PROBE_CMD_QUEUE) {
+      strcpy_P(name, PSTR("CMD_QUEUE"));
+    } else if (probe == PROBE_CMD_EXEC) {
+      strcpy_P(name, PSTR("CMD_EXEC"));
+    } else if (probe == PROBE_TX) {
+      strcpy_P(name, PSTR("TX"));
+    } else if (probe == PROBE_LINK_RTT) {
+      strcpy_P(name, PSTR("LINK_RTT"));
+    } else if (probe == PROBE_LINK_JITTER) {
+      strcpy_P(name, PSTR("LINK_JITTER"));
+    } else if (probe - PROBE_TASK_BASE < TaskScheduler::getTaskCount()) {
+      task = &TaskScheduler::getTask(probe - PROBE_TASK_BASE);
+      strncpy_P(name, task->name, sizeof(name) - 1);
+      name[sizeof(name) - 1] = '\0';
+    } else {
+      continue;
     }
-    BluetoothHandler::sendResponse("SERVO_SPEED");
-
-  } else if (cmd.type == "ARM_ENABLE") {
-    ServoArm::enableArm();
-    BluetoothHandler::sendResponse("ARM_ENABLE");
-
-  } else if (cmd.type == "ARM_DISABLE") {
-    ServoArm::disableArm();
-    BluetoothHandler::sendResponse("ARM_DISABLE");
-
-  } else if (cmd.type == "RESET") {
-    // SystemStatus::resetSystem();  // Temporarily disabled
-    BluetoothHandler::sendResponse("RESET");
-
-  } else if (cmd.type == CMD_SENSOR_STATUS) {
-    SensorStatusManager::sendStatusNow();
-    BluetoothHandler::sendResponse(CMD_SENSOR_STATUS);
-
-  } else if (cmd.type == CMD_SENSORS_ENABLE) {
-    SensorManager::enableSensors();
-    CollisionAvoidance::enable();
-    BluetoothHandler::sendResponse(CMD_SENSORS_ENABLE);
-
-  } else if (cmd.type == CMD_SENSORS_DISABLE) {
-    SensorManager::disableSensors();
-    CollisionAvoidance::disable();
-    BluetoothHandler::sendResponse(CMD_SENSORS_DISABLE);
-
-  } else if (cmd.type == CMD_COLLISION_DISTANCE) {
-    float distance = constrain(cmd.value1, 5, 100);
-    SensorManager::setCollisionDistance(distance);
-
-    if (MessageBuffer::isAvailable()) {
-      char *buffer = MessageBuffer::getBuffer();
-      char distStr[8];
-      formatFloat(distance, distStr, sizeof(distStr), 1);
-      snprintf_P(buffer, MAX_MESSAGE_LENGTH, PSTR("COLLISION_DISTANCE_SET:%s"),
-                 distStr);
-      BluetoothHandler::sendMessage(buffer);
-      MessageBuffer::releaseBuffer();
+
+    if (!PerfMonitor::formatProbe(probe, name, buffer, bufferSize))
+      continue;
+
+    // Scheduled tasks also report how often they started late
+    if (task) {
+      size_t length = strlen(buffer);
+      snprintf_P(buffer + length, bufferSize - length, PSTR(" miss=%u"),
+                 task->missedDeadlines);
     }
-    BluetoothHandler::sendResponse(CMD_COLLISION_DISTANCE);
-
-  } else if (cmd.type == "COLLISION_AGGRESSIVENESS") {
-    int level = constrain(cmd.value1, 1, 3);
-    CollisionAvoidance::setAggressiveness(level);
-
-    if (MessageBuffer::isAvailable()) {
-      char *buffer = MessageBuffer::getBuffer();
-      snprintf_P(buffer, MAX_MESSAGE_LENGTH, PSTR("AGGRESSIVENESS_SET:%d"),
-                 level);
-      BluetoothHandler::sendMessage(buffer);
-      MessageBuffer::releaseBuffer();
+    return true;
+  }
+
+  uint16_t line = cursor++ - PERF_PROBE_COUNT - 1;
+  if (line == 0) {
+    snprintf_P(buffer, bufferSize, PSTR("PERF:TX_DROPPED %lu"),
+               BluetoothHandler::getTxDroppedCount());
+  } else if (line == 1) {
+    snprintf_P(buffer, bufferSize,
+               PSTR("PERF:MSG_POOL peak=%u/%u failed=%u"),
+               MessageBuffer::getPeakSlotsInUse(), MESSAGE_SLOT_COUNT,
+               MessageBuffer::getFailedAllocations());
+  } else {
+    if (argument) {
+      PerfMonitor::reset();
     }
-    BluetoothHandler::sendResponse("COLLISION_AGGRESSIVENESS");
-
-  } else if (cmd.type == "SENSOR_DETAILED") {
-    SensorStatusManager::sendDetailedStatus();
-    BluetoothHandler::sendResponse("SENSOR_DETAILED");
-
-  } else if (cmd.type == "TEST_SENSORS") {
-    SensorManager::testSensors();
-    BluetoothHandler::sendResponse("TEST_SENSORS");
-
-  } else if (cmd.type == "CALIBRATE_SENSORS") {
-    SensorManager::calibrateSensors();
-    BluetoothHandler::sendResponse("CALIBRATE_SENSORS");
-
-  } else if (strcmp(cmd.type, CMD_POWER_ON) == 0) {
-    RelayController::powerOn();
-    BluetoothHandler::sendMessage("POWER_ON");
-    BluetoothHandler::sendResponse(CMD_POWER_ON);
-
-  } else if (strcmp(cmd.type, CMD_POWER_OFF) == 0) {
-    RelayController::powerOff();
-    BluetoothHandler::sendMessage("POWER_OFF");
-    BluetoothHandler::sendResponse(CMD_POWER_OFF);
-
-  } else if (strcmp(cmd.type, CMD_POWER_TOGGLE) == 0) {
-    RelayController::toggle();
-    if (MessageBuffer::isAvailable()) {
-      char *buffer = MessageBuffer::getBuffer();
-      snprintf_P(buffer, MAX_MESSAGE_LENGTH, PSTR("POWER_TOGGLED:%s"), 
-                 RelayController::isPowerOn() ? "ON" : "OFF");
-      BluetoothHandler::sendMessage(buffer);
-      MessageBuffer::releaseBuffer();
+    return false;
+  }
+  return true;
+}
+
+void CommandProcessor::handleMem(const Command &cmd) {
+  startReport("MEM", memLine);
+}
+
+bool CommandProcessor::memLine(uint16_t &cursor, uint16_t argument,
+                               char *buffer, size_t bufferSize) {
+  // Static tables per subsystem; everything else is reported as OTHER
+  const struct {
+    PGM_P name;
+    size_t bytes;
+  } ledger[] = {{PSTR("BT"), BluetoothHandler::getRamUsage()},
+                {PSTR("CMD"), CommandProcessor::getRamUsage()},
+                {PSTR("LOG"), DeferredLog::getRamUsage()},
+                {PSTR("MSG"), MessageBuffer::getRamUsage()},
+                {PSTR("MOTOR"), MotorController::getRamUsage()},
+                {PSTR("PERF"), PerfMonitor::getRamUsage()},
+                {PSTR("SENSOR"), SensorManager::getRamUsage()},
+                {PSTR("SERVO"), ServoArm::getRamUsage()},
+                {PSTR("TASK"), TaskScheduler::getRamUsage()}};
+  const uint8_t ledgerCount = sizeof(ledger) / sizeof(ledger[0]);
+
+  int staticRam = MemoryMonitor::getStaticRamUsed();
+  uint16_t line = cursor++;
+  if (line == 0) {
+    snprintf_P(buffer, bufferSize,
+               PSTR("MEM:STACK peak=%d min_free=%d free=%d"),
+               MemoryMonitor::getStackPeak(),
+               MemoryMonitor::getMinimumFreeMemory(),
+               MemoryMonitor::getFreeMemory());
+  } else if (line == 1) {
+    snprintf_P(buffer, bufferSize, PSTR("MEM:HEAP %d"),
+               MemoryMonitor::getHeapUsed());
+  } else if (line == 2) {
+    snprintf_P(buffer, bufferSize, PSTR("MEM:STATIC %d"), staticRam);
+  } else if (line - 3 < ledgerCount) {
+    char name[8];
+    strcpy_P(name, ledger[line - 3].name);
+    snprintf_P(buffer, bufferSize, PSTR("MEM:%s %u"), name,
+               (unsigned int)ledger[line - 3].bytes);
+  } else if (line - 3 == ledgerCount) {
+    int listed = 0;
+    for (uint8_t i = 0; i < ledgerCount; i++) {
+      listed += ledger[i].bytes;
     }
-    BluetoothHandler::sendResponse(CMD_POWER_TOGGLE);
 
+    // The linker totals are only known on the target
+    if (staticRam < listed)
+      return false;
+    snprintf_P(buffer, bufferSize, PSTR("MEM:OTHER %d"), staticRam - listed);
   } else {
-    DEBUG_PRINT_P("❌ Unknown command: ");
-    DEBUG_PRINTLN(cmd.type);
-    if (MessageBuffer::isAvailable()) {
-      char *buffer = MessageBuffer::getBuffer();
-      snprintf_P(buffer, MAX_MESSAGE_LENGTH, PSTR("ERROR_UNKNOWN_COMMAND:%s"),
-                 cmd.type);
-      BluetoothHandler::sendMessage(buffer);
-      MessageBuffer::releaseBuffer();
+    return false;
+  }
+  return true;
+}
+
+void CommandProcessor::handleConfig(const Command &cmd) {
+  // CFG:1 goes back to the compiled-in settings; they are saved once settled
+  if (cmd.value1 == 1) {
+    ConfigStore::restoreDefaults();
+  }
+
+  MessageHandle message;
+  if (message) {
+    ConfigStore::getStatus(message.get(), message.size());
+    BluetoothHandler::sendMessage(message.get());
+  }
+  BluetoothHandler::sendResponse("CFG");
+}
+
+void CommandProcessor::handleBench(const Command &cmd) {
+  // BENCH:n runs each case n times (default 100), one case per line
+  startReport("BENCH", benchmarkLine, cmd.value1 > 0 ? cmd.value1 : 0);
+}
+
+void CommandProcessor::handleTrace(const Command &cmd) {
+  // TRACE:1 record, TRACE:2 stop, TRACE:3,speed replay, TRACE:4 dump;
+  // plain TRACE reports
+  switch (cmd.value1) {
+  case 1:
+    CommandTrace::startRecording();
+    break;
+  case 2:
+    CommandTrace::stop();
+    break;
+  case 3:
+    CommandTrace::startReplay(cmd.value2 > 0 ? cmd.value2 : 1);
+    break;
+  case 4:
+    // The TR: lines and OK_TRACE come from the REPORT task
+    startReport("TRACE", CommandTrace::dumpLine);
+    return;
+  default:
+    CommandTrace::sendReport();
+    break;
+  }
+  BluetoothHandler::sendResponse("TRACE");
+}
+
+void CommandProcessor::handleBaud(const Command &cmd) {
+  // BAUD:<rate> announces the switch, then the link drops while the
+  // module restarts; the app reconnects and sends any line to confirm
+  unsigned long baud = atol(cmd.parameter);
+  if (baud != 0 && !BluetoothHandler::requestBaud(baud)) {
+    BluetoothHandler::sendResponse("BAUD", false);
+    return;
+  }
+
+  MessageHandle message;
+  if (message) {
+    if (baud != 0) {
+      message.printf_P(PSTR("BAUD:SWITCH %lu"), baud);
+    } else {
+      message.printf_P(PSTR("BAUD:%lu quality=%d rx_errors=%lu"),
+                       BluetoothHandler::getBaud(),
+                       BluetoothHandler::getSignalStrength(),
+                       BluetoothHandler::getRxErrorCount());
     }
+    BluetoothHandler::sendMessage(message.get(), TX_PRIORITY_HIGH);
   }
+  BluetoothHandler::sendResponse("BAUD");
+}
+
+// ========== MACRO COMMANDS ==========
+
+void CommandProcessor::handleMacroRecord(const Command &cmd) {
+  // MREC:<name> - motion and arm commands that follow are stored, with
+  // MWAIT:<ms> pauses, until MEND
+  BluetoothHandler::sendResponse("MREC",
+                                 MacroEngine::startRecording(cmd.parameter));
+}
+
+void CommandProcessor::handleMacroWait(const Command &cmd) {
+  bool recording = MacroEngine::isRecording() && cmd.value1 > 0;
+  if (recording)
+    MacroEngine::addDelay(cmd.value1);
+  BluetoothHandler::sendResponse("MWAIT", recording);
+}
+
+void CommandProcessor::handleMacroEnd(const Command &cmd) {
+  int steps = MacroEngine::finishRecording();
+  if (steps >= 0)
+    sendFormatted(PSTR("MACRO_STEPS:%d"), steps);
+  BluetoothHandler::sendResponse("MEND", steps >= 0);
+}
+
+void CommandProcessor::handleMacroRun(const Command &cmd) {
+  // The run reports MACRO_DONE or MACRO_ABORT when it ends
+  BluetoothHandler::sendResponse("MRUN", MacroEngine::run(cmd.parameter));
+}
+
+void CommandProcessor::handleMacroStop(const Command &cmd) {
+  MacroEngine::abort(PSTR("STOPPED"));
+  BluetoothHandler::sendResponse("MSTOP");
+}
+
+void CommandProcessor::handleMacroDelete(const Command &cmd) {
+  BluetoothHandler::sendResponse("MDEL", MacroEngine::remove(cmd.parameter));
+}
+
+void CommandProcessor::handleMacroList(const Command &cmd) {
+  startReport("MLIST", MacroEngine::listLine);
+}
+
+// ========== RELAY COMMANDS ==========
+
+void CommandProcessor::handlePowerOn(const Command &cmd) {
+  RelayController::powerOn();
+  BluetoothHandler::sendMessage("POWER_ON");
+  BluetoothHandler::sendResponse(CMD_POWER_ON);
+}
+
+void CommandProcessor::handlePowerOff(const Command &cmd) {
+  RelayController::powerOff();
+  BluetoothHandler::sendMessage("POWER_OFF");
+  BluetoothHandler::sendResponse(CMD_POWER_OFF);
+}
+
+void CommandProcessor::handlePowerToggle(const Command &cmd) {
+  RelayController::toggle();
+  MessageHandle message;
+  if (message) {
+    message.printf_P(PSTR("POWER_TOGGLED:%s"),
+                     RelayController::isPowerOn() ? "ON" : "OFF");
+    BluetoothHandler::sendMessage(message.get());
+  }
+  BluetoothHandler::sendResponse(CMD_POWER_TOGGLE);
+}
+
+void CommandProcessor::handleUnknown(const Command &cmd) {
+  DEBUG_PRINT_P("❌ Unknown command: ");
+  DEBUG_PRINTLN(cmd.type);
+  if (cmd.batchSeq != BATCH_NONE) {
+    BluetoothHandler::sendResponse(cmd.type, false); // ERR:<seq>,<item>
+    return;
+  }
+
+  MessageHandle message;
+  if (message) {
+    message.printf_P(PSTR("ERROR_UNKNOWN_COMMAND:%s"), cmd.type);
+    BluetoothHandler::sendMessage(message.get());
+  }
+}
+
+void CommandProcessor::handleNotFitted(const Command &cmd) {
+  DEBUG_PRINT_P("❌ Not fitted on this build: ");
+  DEBUG_PRINTLN(cmd.type);
+  BluetoothHandler::sendResponse(cmd.type, false);
 }
 
 void CommandProcessor::clearQueue() {
@@ -526,48 +1326,93 @@ bool CommandProcessor::isValidCommand(const char *commandString) {
   return parseCommand(commandString, cmd);
 }
 
-void CommandProcessor::sendCommandHelp() {
-  BluetoothHandler::sendMessage("=== ROBOT COMMAND HELP ===");
-  BluetoothHandler::sendMessage("MOTOR COMMANDS:");
-  BluetoothHandler::sendMessage("  FORWARD:speed    - Move forward (0-100)");
-  BluetoothHandler::sendMessage("  BACKWARD:speed   - Move backward (0-100)");
-  BluetoothHandler::sendMessage("  LEFT:speed       - Turn left (0-100)");
-  BluetoothHandler::sendMessage("  RIGHT:speed      - Turn right (0-100)");
-  BluetoothHandler::sendMessage(
-      "  TANK:left,right  - Tank drive (-100 to 100)");
-  BluetoothHandler::sendMessage("  STOP             - Stop all motors");
-  BluetoothHandler::sendMessage("");
-  BluetoothHandler::sendMessage("SERVO ARM COMMANDS:");
-  BluetoothHandler::sendMessage(
-      "  ARM_HOME         - Move arm to home position");
-  BluetoothHandler::sendMessage("  ARM_PRESET:1-5   - Move to preset position");
-  BluetoothHandler::sendMessage(
-      "  SERVO1:angle     - Control base servo (0-180)");
-  BluetoothHandler::sendMessage("  SERVO2:angle     - Control shoulder servo");
-  BluetoothHandler::sendMessage("  SERVO3:angle     - Control elbow servo");
-  BluetoothHandler::sendMessage("  SERVO4:angle     - Control wrist rotation");
-  BluetoothHandler::sendMessage("  SERVO5:angle     - Control wrist tilt");
-  BluetoothHandler::sendMessage("  SERVO6:angle     - Control gripper");
-  BluetoothHandler::sendMessage("  GRIPPER_OPEN     - Open gripper");
-  BluetoothHandler::sendMessage("  GRIPPER_CLOSE    - Close gripper");
-  BluetoothHandler::sendMessage("");
-  BluetoothHandler::sendMessage("SYSTEM COMMANDS:");
-  BluetoothHandler::sendMessage("  STATUS           - Get system status");
-  BluetoothHandler::sendMessage(
-      "  SPEED:value      - Set motor speed (20-100)");
-  BluetoothHandler::sendMessage("  SERVO_SPEED:val  - Set servo speed (1-5)");
-  BluetoothHandler::sendMessage("  DEBUG:0/1        - Toggle debug mode");
-  BluetoothHandler::sendMessage("  EMERGENCY        - Emergency stop all");
-  BluetoothHandler::sendMessage("  TEST_MOTORS      - Test all motors");
-  BluetoothHandler::sendMessage("  TEST_SERVOS      - Test all servos");
-  BluetoothHandler::sendMessage("  CALIBRATE        - Calibrate servos");
-  BluetoothHandler::sendMessage("  PING             - Connection test");
-  BluetoothHandler::sendMessage("");
-  BluetoothHandler::sendMessage("POWER CONTROL:");
-  BluetoothHandler::sendMessage("  PON              - Turn power relay ON");
-  BluetoothHandler::sendMessage("  POFF             - Turn power relay OFF");
-  BluetoothHandler::sendMessage("  PTOG             - Toggle power relay");
-  BluetoothHandler::sendMessage("=== END HELP ===");
+// HELP text, one report line per \n
+const char COMMAND_HELP[] PROGMEM =
+    "=== ROBOT COMMAND HELP ===\n"
+    "MOTOR COMMANDS:\n"
+    "  FORWARD:speed    - Move forward (0-100)\n"
+    "  BACKWARD:speed   - Move backward (0-100)\n"
+    "  LEFT:speed       - Turn left (0-100)\n"
+    "  RIGHT:speed      - Turn right (0-100)\n"
+    "  TANK:left,right  - Tank drive (-100 to 100)\n"
+    "  STOP             - Stop all motors\n"
+    "\n"
+    "SERVO ARM COMMANDS:\n"
+    "  ARM_HOME         - Move arm to home position\n"
+    "  ARM_PRESET:1-5   - Move to preset position\n"
+    "  WP:preset,ms     - Queue preset (0 = home) as a waypoint\n"
+    "  SERVO1:angle     - Control base servo (0-180)\n"
+    "  SERVO2:angle     - Control shoulder servo\n"
+    "  SERVO3:angle     - Control elbow servo\n"
+    "  SERVO4:angle     - Control wrist rotation\n"
+    "  SERVO5:angle     - Control wrist tilt\n"
+    "  SERVO6:angle     - Control gripper\n"
+    "  SE:servo,angle   - Control servo 1-6\n"
+    "  GRIPPER_OPEN     - Open gripper\n"
+    "  GRIPPER_CLOSE    - Close gripper\n"
+    "\n"
+    "SYSTEM COMMANDS:\n"
+    "  STATUS           - Get system status\n"
+    "  SPEED:value      - Set motor speed (20-100)\n"
+    "  SERVO_SPEED:val  - Set servo speed (1-5)\n"
+    "  DEBUG:0/1        - Toggle debug mode\n"
+    "  EMERGENCY        - Emergency stop all\n"
+    "  TEST_MOTORS      - Test all motors\n"
+    "  TEST_FL:speed    - Test one motor (also FR, RL, RR)\n"
+    "  TEST_SERVOS      - Test all servos\n"
+    "  CALIBRATE        - Calibrate servos\n"
+    "  PING             - Connection test\n"
+    "  PN:seq,ts        - Ping with firmware timestamps\n"
+    "  PB:n             - Send n link pings (answer PR:seq)\n"
+    "  PERF[:1]         - Timing probes (1 = reset after)\n"
+    "  MEM              - Stack high-water mark and RAM use\n"
+    "  CFG[:1]          - Saved settings (1 = restore defaults)\n"
+    "  BENCH[:n]        - Time hot paths n times (robot idle)\n"
+    "  TRACE[:1-4]      - 1 record, 2 stop, 3,x replay, 4 dump\n"
+    "  BAUD[:rate]      - Link rate and quality / switch rate\n"
+    "  @seq:cmd;cmd     - Batch, one tick, answered ACK:seq\n"
+    "\n"
+    "MACROS:\n"
+    "  MREC:name        - Record the commands that follow\n"
+    "  MWAIT:ms         - Pause before the next recorded step\n"
+    "  MEND             - Save the recording\n"
+    "  MRUN:name        - Play a macro\n"
+    "  MSTOP            - Stop the macro\n"
+    "  MDEL:name        - Delete a macro\n"
+    "  MLIST            - List stored macros\n"
+    "\n"
+    "POWER CONTROL:\n"
+    "  PON              - Turn power relay ON\n"
+    "  POFF             - Turn power relay OFF\n"
+    "  PTOG             - Toggle power relay\n"
+    "=== END HELP ===\n";
+
+bool CommandProcessor::helpLine(uint16_t &cursor, uint16_t argument,
+                                char *buffer, size_t bufferSize) {
+  char c = pgm_read_byte(COMMAND_HELP + cursor);
+  if (c == '\0')
+    return false;
+
+  size_t length = 0;
+  while (c != '\n' && c != '\0') {
+    if (length + 1 < bufferSize)
+      buffer[length++] = c;
+    c = pgm_read_byte(COMMAND_HELP + ++cursor);
+  }
+  buffer[length] = '\0';
+  if (c == '\n')
+    cursor++;
+  return true;
 }
 
+void CommandProcessor::startReport(const char *response, ReportSource source,
+                                   uint16_t argument) {
+  // One report at a time; its OK follows the last line
+  if (!Report::start(response, source, argument)) {
+    BluetoothHandler::sendResponse(response, false);
+  }
+}
+
+size_t CommandProcessor::getRamUsage() { return sizeof(commandQueue); }
+
 #endif // COMMAND_PROCESSOR_H
\ No newline at end of file
@@ -18,14 +18,38 @@
 // Testing mode - set to true for Serial Monitor testing, false for Bluetooth
 #define SERIAL_TESTING_MODE false
 
+// ESP32 bridge target (controller/new_motor): a TTGO T-Call takes the
+// HC-05's place on Serial1, at a fixed high rate and without AT commands.
+// The sketch defines it before including this file.
+#ifndef ESP32_BRIDGE_MODE
+#define ESP32_BRIDGE_MODE false
+#endif
+
 // Debug settings
 #define DEBUG_ENABLED true
-#define DEBUG_MOTOR true
-#define DEBUG_SERVO true
-#define DEBUG_BLUETOOTH true
+
+// Deferred log levels (see debug_log.h)
+#define LOG_LEVEL_NONE 0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_INFO 3
+#define LOG_LEVEL_DEBUG 4
+
+// Per-module log levels - calls above the level compile to nothing
+#define LOG_LEVEL_MOTOR LOG_LEVEL_DEBUG
+#define LOG_LEVEL_SERVO LOG_LEVEL_DEBUG
+#define LOG_LEVEL_BLUETOOTH LOG_LEVEL_DEBUG
+#define LOG_LEVEL_COMMAND LOG_LEVEL_INFO
+#define PERF_MONITOR_ENABLED true // Latency probes reported by PERF
+#define TRACE_BUFFER_SIZE 512     // Bytes of command trace kept (TRACE)
 
 // Safety settings
+#if ESP32_BRIDGE_MODE
+// The ESP32 repeats drive commands, so a lost link stops the robot fast
+#define COMMAND_TIMEOUT 500
+#else
 #define COMMAND_TIMEOUT 5000      // 5 seconds timeout (increased for testing)
+#endif
 #define SAFETY_STOP_TIMEOUT 10000 // 10 seconds emergency stop
 #define MIN_SPEED_THRESHOLD 20    // Minimum motor speed
 #define MAX_SPEED_LIMIT 100       // Maximum motor speed
@@ -42,6 +66,29 @@
   1000 // Send status every 1 second (reduced frequency)
 #endif
 
+// Delta telemetry - auto-sent status carries only fields that changed
+#define TELEMETRY_KEYFRAME_INTERVAL 10000 // Full frame at least this often
+#define TELEMETRY_DISTANCE_DEADBAND 20    // mm of change ignored
+
+// Persistent tunables (see config_store.h)
+#define CONFIG_STORE_ENABLED true // Load and save settings in EEPROM
+#define CONFIG_STORE_ADDRESS 0    // First EEPROM byte used
+#define CONFIG_STORE_SLOTS 8      // Records rotated through for wear leveling
+#define CONFIG_STORE_VERSION 1    // Bump when PersistentConfig changes
+#define CONFIG_SAVE_DELAY 5000    // ms a change must hold before it is saved
+
+// Hardware watchdog and warm restart (see watchdog.h)
+#define WATCHDOG_ENABLED true      // Reset if a task hangs or stops running
+#define WATCHDOG_TIMEOUT WDTO_2S   // avr/wdt.h; above the slowest task period
+#define WATCHDOG_MAX_WARM_BOOTS 3  // Restarts in a row before a cold boot
+#define WATCHDOG_STABLE_TIME 10000 // ms of running that clears that count
+
+// On-board macros (see macro_engine.h)
+#define MACRO_STORE_ADDRESS 256 // First EEPROM byte, after the config slots
+#define MACRO_SLOTS 4           // Macros kept in EEPROM
+#define MACRO_MAX_STEPS 24      // Commands per macro
+#define MACRO_NAME_LENGTH 8     // Including the terminator
+
 // ========== PIN DEFINITIONS ==========
 
 // Status LED
@@ -50,7 +97,28 @@
 // Bluetooth Module (HC-05/HC-06)
 #define BLUETOOTH_RX 19 // Pin 19 (Serial1 RX)
 #define BLUETOOTH_TX 18 // Pin 18 (Serial1 TX)
+#if ESP32_BRIDGE_MODE
+// Exact at 16MHz; the 64-byte UART buffer still holds 2.5ms of input
+#define BLUETOOTH_BAUD 250000
+#else
 #define BLUETOOTH_BAUD 9600
+#endif
+#define BLUETOOTH_SETTLE_TIME 1000  // ms after power-up before the first line
+#define BLUETOOTH_CONFIRM_TIME 3000 // ms to wait for the app to answer
+
+// HC-05 AT commands over the KEY pin (pin 34 on the module): finds the
+// module's UART rate at boot and lets BAUD:<rate> raise it at runtime.
+// Only with KEY wired: otherwise the probes would go out to the app.
+#ifndef BLUETOOTH_KEY_WIRED
+#define BLUETOOTH_KEY_WIRED false
+#endif
+#define BLUETOOTH_AT_ENABLED (BLUETOOTH_KEY_WIRED && !ESP32_BRIDGE_MODE)
+#define BLUETOOTH_KEY_PIN 40             // High = AT command mode
+#define BLUETOOTH_AT_TIMEOUT 300         // ms to wait for OK
+#define BLUETOOTH_AT_GUARD_TIME 100      // ms quiet before entering AT mode
+#define BLUETOOTH_BAUD_VERIFY_TIME 15000 // ms for the app to reconnect
+#define BLUETOOTH_QUALITY_WINDOW 1000    // ms per link quality sample
+#define BLUETOOTH_RX_ERROR_LIMIT 8       // Bad lines/frames per window
 
 // Motor Driver Pins - Driver Board 1 (Left Motors)
 #define DRIVER1_D0 22 // Front Left Motor Control 1
@@ -79,10 +147,12 @@
 #define SERVO_GRIPPER 11    // Gripper servo
 
 // HC-SR04 Ultrasonic Sensors
+// Echo pins must be pin-change interrupt capable (A8-A15 on the Mega) so the
+// ranging engine can timestamp echo edges without blocking in pulseIn()
 #define FRONT_SENSOR_TRIG 30 // Front sensor trigger pin
-#define FRONT_SENSOR_ECHO 31 // Front sensor echo pin
+#define FRONT_SENSOR_ECHO A8 // Front sensor echo pin (PCINT16)
 #define REAR_SENSOR_TRIG 32  // Rear sensor trigger pin
-#define REAR_SENSOR_ECHO 33  // Rear sensor echo pin
+#define REAR_SENSOR_ECHO A9  // Rear sensor echo pin (PCINT17)
 
 // Emergency stop button (optional)
 #define EMERGENCY_STOP_PIN 12
@@ -92,7 +162,24 @@
 
 // ========== SENSOR CONFIGURATION ==========
 
-// Sensor indices
+// Ultrasonic sensor layout - one row per HC-SR04, sized at compile time.
+// headingDeg is the direction the sensor faces: 0 = forward, 90 = right,
+// 180 = rear, 270 = left. Add side or corner sensors as extra rows.
+struct SensorMount {
+  const char *name; // Up to 7 characters
+  uint8_t trigPin;
+  uint8_t echoPin;
+  uint16_t headingDeg;
+};
+
+constexpr SensorMount SENSOR_LAYOUT[] = {
+    {"Front", FRONT_SENSOR_TRIG, FRONT_SENSOR_ECHO, 0},
+    {"Rear", REAR_SENSOR_TRIG, REAR_SENSOR_ECHO, 180}};
+
+#define SENSOR_COUNT                                                           \
+  ((int)(sizeof(SENSOR_LAYOUT) / sizeof(SENSOR_LAYOUT[0])))
+
+// Sensor indices - the first two rows of SENSOR_LAYOUT
 #define FRONT_SENSOR 0
 #define REAR_SENSOR 1
 
@@ -103,6 +190,20 @@
 #define COLLISION_DISTANCE_WARN 50 // Warning distance
 #define MAX_SENSOR_DISTANCE 200    // Maximum reliable sensor distance
 
+// Predictive braking - speed is capped so the stop distance stays at least
+// COLLISION_TTC_TARGET_MS away at the current closing speed
+#define ROBOT_FULL_SPEED_MM_S 800       // Ground speed at 100% output
+#define COLLISION_TTC_TARGET_MS 1500    // Time-to-collision the cap aims for
+#define COLLISION_TTC_EMERGENCY_MS 300  // Closer than this = emergency stop
+#define COLLISION_CLEAR_MARGIN_MM 100   // Extra clearance before un-latching
+#define COLLISION_CLEAR_HOLD_MS 1000    // Minimum emergency stop duration
+
+// Integer distance pipeline - readings are carried in millimetres
+#define CM_TO_MM(cm) ((cm) * 10)
+// Round trip at 343 m/s: 0.1715 mm per echo microsecond, as 87/512
+#define ECHO_US_TO_MM(us) ((uint16_t)(((unsigned long)(us) * 87UL) >> 9))
+#define SENSOR_NO_ECHO 0 // Distance reported for a timed-out echo
+
 // Sensor update intervals
 #if SERIAL_TESTING_MODE
 #define SENSOR_UPDATE_INTERVAL                                                 \
@@ -110,7 +211,72 @@
 #else
 #define SENSOR_UPDATE_INTERVAL 50 // Update sensors every 50ms (normal)
 #endif
-#define SENSOR_STABILIZE_COUNT 2 // Reduced for faster response
+#define SENSOR_ECHO_TIMEOUT_US 30000 // Give up on an echo after 30ms
+
+// Staggered firing - one sensor in flight at a time, chosen by due time
+#define SENSOR_AHEAD_ANGLE 45      // Within this of travel = facing ahead
+#define SENSOR_BEHIND_SLOWDOWN 3   // Others ping this much less when moving
+#define SENSOR_CROSSTALK_ANGLE 60  // Sensors this close can hear each other
+#define SENSOR_CROSSTALK_GAP_MS 20 // Quiet time for them after an echo
+
+// Streaming filter per sensor: median -> EMA, plus a closing-rate estimate
+#define SENSOR_MEDIAN_WINDOW 3  // Samples in the running median (odd)
+#define SENSOR_EMA_SHIFT 1      // EMA weight of a new median: 1/2^shift
+#define SENSOR_RATE_SHIFT 2     // Smoothing of the closing rate: 1/2^shift
+#define SENSOR_OUTLIER_MM 300   // Jump from the median treated as spurious
+#define SENSOR_OUTLIER_LIMIT 2  // Agreeing rejections before a jump is real
+
+// ========== TASK SCHEDULING ==========
+
+#define MAX_TASKS 15
+
+// Period (ms), priority (0 = most urgent) and allowed start lateness (ms)
+// for each scheduled task - tune per deployment
+#define TASK_COMMS_PERIOD 1 // Bluetooth / Serial input and TX draining
+#define TASK_COMMS_PRIORITY 0
+#define TASK_COMMS_DEADLINE 5
+#define TASK_COMMANDS_PERIOD 1 // Command queue
+#define TASK_COMMANDS_PRIORITY 0
+#define TASK_COMMANDS_DEADLINE 5
+#define TASK_MOTOR_PERIOD 10 // Motor safety timeout and emergency stop
+#define TASK_MOTOR_PRIORITY 1
+#define TASK_MOTOR_DEADLINE 10
+#define TASK_SENSOR_PERIOD 1 // Ultrasonic ranging engine
+#define TASK_SENSOR_PRIORITY 1
+#define TASK_SENSOR_DEADLINE 5
+#define TASK_COLLISION_PERIOD SENSOR_UPDATE_INTERVAL
+#define TASK_COLLISION_PRIORITY 1
+#define TASK_COLLISION_DEADLINE 20
+#define TASK_SERVO_PERIOD 10 // Trajectory sample interval
+#define TASK_SERVO_PRIORITY 2
+#define TASK_SERVO_DEADLINE 20
+#define TASK_RELAY_PERIOD 100
+#define TASK_RELAY_PRIORITY 4
+#define TASK_RELAY_DEADLINE 100
+#define TASK_STATUS_PERIOD 50 // Sensor status keeps its own send interval
+#define TASK_STATUS_PRIORITY 4
+#define TASK_STATUS_DEADLINE 100
+#define TASK_MEMORY_PERIOD 1000
+#define TASK_MEMORY_PRIORITY 5
+#define TASK_MEMORY_DEADLINE 1000
+#define TASK_CONFIG_PERIOD 10 // EEPROM write-back, one byte per run
+#define TASK_CONFIG_PRIORITY 5
+#define TASK_CONFIG_DEADLINE 1000
+#define TASK_TRACE_PERIOD 1 // Trace replay injection
+#define TASK_TRACE_PRIORITY 2
+#define TASK_TRACE_DEADLINE 5
+#define TASK_LINK_PROBE_PERIOD 1 // Link ping bursts
+#define TASK_LINK_PROBE_PRIORITY 3
+#define TASK_LINK_PROBE_DEADLINE 10
+#define TASK_MACRO_PERIOD 1 // Macro step dispatch
+#define TASK_MACRO_PRIORITY 1
+#define TASK_MACRO_DEADLINE 5
+#define TASK_REPORT_PERIOD 5 // Bulk diagnostic output, one line per run
+#define TASK_REPORT_PRIORITY 5
+#define TASK_REPORT_DEADLINE 1000
+#define TASK_WATCHDOG_PERIOD 20 // Warm restart snapshot (arm pose, config)
+#define TASK_WATCHDOG_PRIORITY 3
+#define TASK_WATCHDOG_DEADLINE 100
 
 // ========== MOTOR CONFIGURATION ==========
 
@@ -126,6 +292,20 @@
 #define FRONT_RIGHT_DIR -1
 #define REAR_RIGHT_DIR -1
 
+// Drive outputs through PORTA and the timer OCR registers on the Mega 2560
+// (falls back to digitalWrite/analogWrite on other boards)
+#define MOTOR_FAST_IO true
+
+// Motion profile - outputs slew toward the commanded speed instead of
+// stepping, to avoid current spikes on the relay rail
+#define MOTOR_RAMP_ENABLED true
+#define MOTOR_ACCEL_RATE 250 // % per second while speeding up
+#define MOTOR_DECEL_RATE 400 // % per second while slowing down
+#define MOTOR_SCURVE_ENABLED false
+#define MOTOR_JERK_RATE 2000    // S-curve: rate growth in % per second^2
+#define MOTOR_SCURVE_LANDING 8  // S-curve: rate cap per % still to go
+#define MOTOR_SCURVE_MIN_RATE 20 // S-curve: slowest approach rate (%/s)
+
 // ========== SERVO CONFIGURATION ==========
 
 // Servo indices
@@ -148,11 +328,21 @@
 #define SERVO_WRIST_TILT_DEFAULT 90
 #define SERVO_GRIPPER_DEFAULT 90
 
-// Servo movement speed (degrees per update)
+// Servo pulse range (microseconds) matching 0-180 degrees
+#define SERVO_MIN_PULSE_US 544
+#define SERVO_MAX_PULSE_US 2400
+
+// Servo movement speed (x100 degrees/second) for moves without a duration
 #define SERVO_SPEED_SLOW 1
 #define SERVO_SPEED_NORMAL 3
 #define SERVO_SPEED_FAST 5
 
+// Trajectories
+#define SERVO_MAX_MOVE_MS 10000     // Longest single move
+#define SERVO_EASING_ENABLED true   // Smoothstep instead of constant velocity
+#define SERVO_WAYPOINT_QUEUE_SIZE 6 // Poses queued behind the current move
+#define ARM_HOLD 0xFF               // Pose entry: leave this joint where it is
+
 // ========== SYSTEM STRUCTURES ==========
 
 // System state structure
@@ -167,10 +357,12 @@ struct SystemState {
 
 // Motor state structure
 struct MotorState {
-  int currentSpeed;
+  int currentSpeed; // Commanded speed (-100 to 100)
   bool isRunning;
-  unsigned long lastUpdate;
-  String name;
+  unsigned long lastUpdate; // Last time the output changed
+  int16_t rampPosition; // Output speed in 8.8 fixed point
+  uint16_t rampRate;    // S-curve: current slew rate (%/s)
+  int8_t outputSpeed;   // Speed last written to the driver
 };
 
 // Servo state structure
@@ -179,25 +371,41 @@ struct ServoState {
   int targetAngle;
   bool isMoving;
   unsigned long lastUpdate;
-  String name;
+  uint16_t startPulse;        // Trajectory segment start (us)
+  uint16_t endPulse;          // Trajectory segment end (us)
+  uint16_t currentPulse;      // Pulse last written to the servo (us)
+  unsigned long moveStart;    // micros() when the segment started
+  unsigned long moveDuration; // Segment length (us), 0 = arrived
+};
+
+// Streaming distance filter - constant memory per sensor
+struct SensorFilter {
+  uint16_t window[SENSOR_MEDIAN_WINDOW]; // Recent accepted readings (mm)
+  uint8_t sampleCount;                   // Readings in the window so far
+  uint8_t nextSample;                    // Ring slot for the next reading
+  uint8_t rejectedInRow;                 // Consecutive outliers dropped
+  uint16_t rejectedMm;                   // The last of them (mm)
+  int32_t averageQ4;            // EMA of the median, mm in 28.4 fixed point
+  int16_t closingRate;          // mm/s, positive = obstacle getting closer
+  unsigned long lastSampleTime; // millis() of the last accepted reading
 };
 
 // Sensor state structure - optimized for memory
 struct SensorState {
-  float currentDistance;
-  float lastStableDistance;
+  uint16_t currentDistanceMm; // Last raw reading
+  uint16_t stableDistanceMm;  // Filtered distance
   bool isObstacleDetected;
   bool isCollisionRisk;
   unsigned long lastUpdate;
-  int stableReadingCount;
   char name[8]; // Fixed size instead of String
   bool isActive;
+  SensorFilter filter;
 };
 
 // Sensor status structure for Flutter app
 struct SensorStatus {
-  float frontDistance;
-  float rearDistance;
+  uint16_t frontDistanceMm;
+  uint16_t rearDistanceMm;
   bool frontObstacle;
   bool rearObstacle;
   bool frontCollisionRisk;
@@ -206,13 +414,127 @@ struct SensorStatus {
   unsigned long lastUpdate;
 };
 
+// Settings kept in EEPROM across resets
+struct PersistentConfig {
+  uint8_t globalSpeed;         // Motor speed multiplier (%)
+  uint8_t collisionDistanceCm; // Stop distance
+  uint8_t warningDistanceCm;   // Obstacle warning distance
+  uint8_t servoSpeed;          // SERVO_SPEED_SLOW..SERVO_SPEED_FAST
+  uint16_t statusSendInterval; // ms between auto-sent sensor status
+  uint8_t flags;               // CONFIG_FLAG_*
+};
+
+#define CONFIG_FLAG_SENSORS_ENABLED 0x01
+#define CONFIG_FLAG_AUTO_SEND 0x02
+
+// What a warm restart resumes from, kept in RAM across a watchdog reset
+struct WarmState {
+  uint16_t magic;            // WARM_STATE_MAGIC
+  uint8_t warmBoots;         // Watchdog restarts in a row
+  unsigned long baud;        // Bluetooth UART rate, 0 if the link wasn't up
+  uint16_t armPulses[6];     // Pulse last written to each servo (us)
+  PersistentConfig config;   // Settings in effect, saved or not
+  uint16_t crc;              // CRC-16 of every byte above
+};
+
+// Command opcodes - resolved once at parse time, used for table dispatch.
+// Keep in sync with CommandProcessor::handlers in command_processor.h
+enum CommandOpcode : uint8_t {
+  OP_UNKNOWN = 0,
+
+  // Motor commands
+  OP_FORWARD,
+  OP_BACKWARD,
+  OP_LEFT,
+  OP_RIGHT,
+  OP_TANK,
+  OP_STOP,
+
+  // Servo commands
+  OP_ARM_HOME,
+  OP_ARM_PRESET,
+  OP_SERVO_MOVE, // value1 = servo (1-6), value2 = angle
+  OP_GRIPPER_OPEN,
+  OP_GRIPPER_CLOSE,
+  OP_ARM_WAYPOINT, // value1 = preset (0 = home), value2 = duration ms
+
+  // Sensor commands
+  OP_SENSOR_STATUS,
+  OP_SENSORS_ENABLE,
+  OP_SENSORS_DISABLE,
+  OP_COLLISION_DISTANCE,
+  OP_COLLISION_AGGRESSIVENESS,
+  OP_SENSOR_DETAILED,
+  OP_TEST_SENSORS,
+  OP_CALIBRATE_SENSORS,
+
+  // System commands
+  OP_STATUS,
+  OP_SPEED,
+  OP_DEBUG,
+  OP_EMERGENCY,
+  OP_PING,
+  OP_PING_BURST, // value1 = pings to send
+  OP_PING_REPLY, // value1 = seq of the robot ping being answered
+  OP_HELP,
+  OP_TEST_MOTORS,
+  OP_TEST_SERVOS,
+  OP_CALIBRATE,
+  OP_SERVO_SPEED,
+  OP_ARM_ENABLE,
+  OP_ARM_DISABLE,
+  OP_RESET,
+  OP_PERF,
+  OP_MEM,
+  OP_CONFIG,
+  OP_BENCH,
+  OP_TRACE,
+  OP_BAUD, // parameter = new UART rate, none = report
+
+  // Macro commands (parameter = macro name)
+  OP_MACRO_RECORD,
+  OP_MACRO_WAIT, // value1 = ms before the next recorded step
+  OP_MACRO_END,
+  OP_MACRO_RUN,
+  OP_MACRO_STOP,
+  OP_MACRO_DELETE,
+  OP_MACRO_LIST,
+
+  // Relay commands
+  OP_POWER_ON,
+  OP_POWER_OFF,
+  OP_POWER_TOGGLE,
+
+  OP_COUNT
+};
+
+// Command batches: @<seq>:<cmd>;<cmd>;... run in one tick, acked once
+#define BATCH_PREFIX '@'
+#define BATCH_SEPARATOR ';'
+#define BATCH_MAX_ITEMS 4 // Must fit the command queue
+#define BATCH_NONE 0      // batchSeq of a command outside a batch
+#define BATCH_MACRO 0xFFFF // batchSeq of a macro step (batches stop below)
+
+// One macro step as stored in EEPROM: a parsed command and the time to
+// wait after the previous step
+struct MacroStep {
+  uint16_t delayMs;
+  uint8_t opcode;
+  int16_t value1;
+  int16_t value2;
+};
+
 // Command structure - optimized for memory
 struct Command {
   char type[16];      // Fixed size instead of String
-  char parameter[16]; // Fixed size instead of String
+  char parameter[22]; // Text after ':', both fields (PN:seq,host_ts)
+  uint8_t opcode;     // CommandOpcode
   int value1;
   int value2;
   unsigned long timestamp;
+  unsigned long queuedAt; // micros() when queued, for latency probes
+  uint16_t batchSeq;      // Batch sequence, BATCH_NONE if single
+  uint8_t batchItem;      // Position in the batch, from 1
 };
 
 // ========== UTILITY MACROS ==========
@@ -241,6 +563,18 @@ class SystemStatus;
 class SensorManager;
 class CollisionAvoidance;
 
+// Outbound message priority classes (drained high before telemetry)
+#define TX_PRIORITY_HIGH 0      // Command acks and emergency notifications
+#define TX_PRIORITY_TELEMETRY 1 // Status, sensor data and diagnostics
+
+// Send a message over the active link (defined in robot_controller.ino)
+void sendBluetoothMessage(const char *message,
+                          uint8_t priority = TX_PRIORITY_TELEMETRY);
+
+// Line source for the BENCH report (defined in robot_controller.ino)
+bool benchmarkLine(uint16_t &cursor, uint16_t iterations, char *line,
+                   size_t lineSize);
+
 // ========== COMMAND DEFINITIONS ==========
 
 // Motor commands (shortened for memory efficiency)
@@ -257,6 +591,7 @@ class CollisionAvoidance;
 #define CMD_SERVO_MOVE "SE"
 #define CMD_GRIPPER_OPEN "GO"
 #define CMD_GRIPPER_CLOSE "GC"
+#define CMD_ARM_WAYPOINT "WP"
 
 // Sensor commands (shortened)
 #define CMD_SENSOR_STATUS "SS"
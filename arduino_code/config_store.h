@@ -0,0 +1,270 @@
+/**********************************************************************
+ *  config_store.h - Persistent Configuration Store
+ *  Keeps the runtime tunables (speed, collision distances, servo speed,
+ *  status rate) in EEPROM so they survive a reset. Records are CRC
+ *  checked and versioned, and each save goes to the next of
+ *  CONFIG_STORE_SLOTS slots so no single cell takes every write.
+ *
+ *  Slot layout (CONFIG_STORE_SLOTS back to back):
+ *    [sequence x2][version][length][PersistentConfig][CRC-16 x2]
+ *  The valid slot with the highest sequence is the current config.
+ *********************************************************************/
+
+#ifndef CONFIG_STORE_H
+#define CONFIG_STORE_H
+
+#include "collision_avoidance.h"
+#include "config.h"
+#include "memory_optimization.h"
+#include "motor_controller.h"
+#include "sensor_manager.h"
+#include "sensor_status.h"
+#include "servo_arm.h"
+#include <EEPROM.h>
+
+#define CONFIG_NO_SLOT 0xFF
+
+struct ConfigRecord {
+  uint16_t sequence; // Increments per save; wraps
+  uint8_t version;   // CONFIG_STORE_VERSION when written
+  uint8_t length;    // sizeof(PersistentConfig) when written
+  PersistentConfig config;
+  uint16_t crc; // CRC-16 of every byte above
+};
+
+class ConfigStore {
+private:
+  static PersistentConfig defaults;  // Compiled-in values, for CFG:1
+  static PersistentConfig saved;     // What the newest slot holds
+  static PersistentConfig candidate; // Latest change, waiting to settle
+  static unsigned long lastChange;
+  static uint8_t newestSlot;
+  static uint16_t sequence;
+  static unsigned int saveCount;
+
+  // Record being written, one byte per update()
+  static ConfigRecord writeRecord;
+  static uint8_t writeSlot;
+  static uint8_t writePosition;
+
+  static int slotAddress(uint8_t slot);
+  static bool readSlot(uint8_t slot, ConfigRecord &record);
+  static void apply(const PersistentConfig &config);
+  static void beginWrite(const PersistentConfig &config);
+
+public:
+  // CRC-16/CCITT-FALSE; pass the previous result to continue a CRC
+  static uint16_t crc16(const uint8_t *data, size_t length,
+                        uint16_t crc = 0xFFFF);
+
+  // Load the newest valid record and apply it. Call after the subsystems
+  // are initialised, so their values become the defaults.
+  static void init();
+
+  // Apply settings kept across a warm restart. Call after init(); any
+  // that differ from the stored record are saved as a change.
+  static void resume(const PersistentConfig &config);
+
+  // The settings in effect now
+  static void capture(PersistentConfig &config);
+
+  // Save settings that have changed and held for CONFIG_SAVE_DELAY.
+  // Never waits for the EEPROM: writes at most one byte per call.
+  static void update();
+
+  // Go back to the compiled-in settings (saved like any other change)
+  static void restoreDefaults();
+
+  // Status line: slot in use, its sequence, saves since boot, pending
+  static void getStatus(char *buffer, size_t bufferSize);
+};
+
+// Static variable definitions
+PersistentConfig ConfigStore::defaults;
+PersistentConfig ConfigStore::saved;
+PersistentConfig ConfigStore::candidate;
+unsigned long ConfigStore::lastChange = 0;
+uint8_t ConfigStore::newestSlot = CONFIG_NO_SLOT;
+uint16_t ConfigStore::sequence = 0;
+unsigned int ConfigStore::saveCount = 0;
+ConfigRecord ConfigStore::writeRecord;
+uint8_t ConfigStore::writeSlot = CONFIG_NO_SLOT;
+uint8_t ConfigStore::writePosition = sizeof(ConfigRecord);
+
+static_assert(sizeof(ConfigRecord) < 0xFF,
+              "ConfigRecord must fit the one-byte write position");
+
+// Implementation
+uint16_t ConfigStore::crc16(const uint8_t *data, size_t length,
+                            uint16_t crc) {
+  // CRC-16/CCITT-FALSE (polynomial 0x1021, initial value 0xFFFF)
+  for (size_t i = 0; i < length; i++) {
+    crc ^= (uint16_t)data[i] << 8;
+    for (uint8_t bitIndex = 0; bitIndex < 8; bitIndex++) {
+      crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : (crc << 1);
+    }
+  }
+  return crc;
+}
+
+int ConfigStore::slotAddress(uint8_t slot) {
+  return CONFIG_STORE_ADDRESS + slot * sizeof(ConfigRecord);
+}
+
+bool ConfigStore::readSlot(uint8_t slot, ConfigRecord &record) {
+  uint8_t *bytes = (uint8_t *)&record;
+  int address = slotAddress(slot);
+  for (uint8_t i = 0; i < sizeof(record); i++) {
+    bytes[i] = EEPROM.read(address + i);
+  }
+
+  // A torn write fails the CRC, leaving the previous slot as the newest
+  return record.crc == crc16(bytes, offsetof(ConfigRecord, crc)) &&
+         record.version == CONFIG_STORE_VERSION &&
+         record.length == sizeof(PersistentConfig);
+}
+
+void ConfigStore::capture(PersistentConfig &config) {
+#if ESP32_BRIDGE_MODE
+  // No sensors or arm on the bridge build: their fields keep what the
+  // newest record holds
+  config = saved;
+#else
+  config.collisionDistanceCm = SensorManager::getCollisionDistance();
+  config.warningDistanceCm = SensorManager::getWarningDistance();
+  config.servoSpeed = ServoArm::getMovementSpeed();
+  config.statusSendInterval = SensorStatusManager::getSendInterval();
+  config.flags = 0;
+  if (SensorManager::areSensorsEnabled())
+    config.flags |= CONFIG_FLAG_SENSORS_ENABLED;
+  if (SensorStatusManager::isAutoSendEnabled())
+    config.flags |= CONFIG_FLAG_AUTO_SEND;
+#endif
+  config.globalSpeed = MotorController::getGlobalSpeed();
+}
+
+void ConfigStore::apply(const PersistentConfig &config) {
+  // The setters clamp, so a record from an older build can't set
+  // anything out of range
+  MotorController::setGlobalSpeed(config.globalSpeed);
+#if !ESP32_BRIDGE_MODE
+  SensorManager::setCollisionDistance(config.collisionDistanceCm);
+  SensorManager::setWarningDistance(config.warningDistanceCm);
+  ServoArm::setMovementSpeed(config.servoSpeed);
+  SensorStatusManager::setSendInterval(config.statusSendInterval);
+
+  if (config.flags & CONFIG_FLAG_SENSORS_ENABLED) {
+    SensorManager::enableSensors();
+    CollisionAvoidance::enable();
+  } else {
+    SensorManager::disableSensors();
+    CollisionAvoidance::disable();
+  }
+
+  if (config.flags & CONFIG_FLAG_AUTO_SEND)
+    SensorStatusManager::enableAutoSend();
+  else
+    SensorStatusManager::disableAutoSend();
+#endif
+}
+
+void ConfigStore::init() {
+  capture(defaults);
+
+#if CONFIG_STORE_ENABLED
+  ConfigRecord record;
+  for (uint8_t slot = 0; slot < CONFIG_STORE_SLOTS; slot++) {
+    if (!readSlot(slot, record))
+      continue;
+    if (newestSlot == CONFIG_NO_SLOT ||
+        (int16_t)(record.sequence - sequence) > 0) {
+      newestSlot = slot;
+      sequence = record.sequence;
+      saved = record.config;
+    }
+  }
+
+  if (newestSlot != CONFIG_NO_SLOT) {
+    apply(saved);
+    DEBUG_PRINT_P("💾 Config loaded from slot ");
+    DEBUG_PRINTLN(newestSlot);
+  } else {
+    DEBUG_PRINTLN_P("💾 No stored config - using defaults");
+  }
+#endif
+
+  // Read back what the subsystems accepted, so clamping isn't a change
+  capture(saved);
+  candidate = saved;
+  lastChange = millis();
+}
+
+void ConfigStore::resume(const PersistentConfig &config) {
+  apply(config);
+  DEBUG_PRINTLN_P("💾 Config resumed from before the restart");
+}
+
+void ConfigStore::beginWrite(const PersistentConfig &config) {
+  writeSlot = newestSlot == CONFIG_NO_SLOT
+                  ? 0
+                  : (newestSlot + 1) % CONFIG_STORE_SLOTS;
+  writeRecord.sequence = sequence + 1;
+  writeRecord.version = CONFIG_STORE_VERSION;
+  writeRecord.length = sizeof(PersistentConfig);
+  writeRecord.config = config;
+  writeRecord.crc =
+      crc16((const uint8_t *)&writeRecord, offsetof(ConfigRecord, crc));
+  writePosition = 0;
+}
+
+void ConfigStore::update() {
+#if CONFIG_STORE_ENABLED
+  if (writePosition < sizeof(ConfigRecord)) {
+#if defined(__AVR__)
+    // A byte takes ~3.4ms to program; come back rather than wait
+    if (!eeprom_is_ready())
+      return;
+#endif
+    // The CRC goes last, so the slot only becomes valid once complete.
+    // update() skips bytes that already hold the value.
+    const uint8_t *bytes = (const uint8_t *)&writeRecord;
+    EEPROM.update(slotAddress(writeSlot) + writePosition,
+                  bytes[writePosition]);
+    if (++writePosition == sizeof(ConfigRecord)) {
+      newestSlot = writeSlot;
+      sequence = writeRecord.sequence;
+      saved = writeRecord.config;
+      saveCount++;
+      DEBUG_PRINT_P("💾 Config saved to slot ");
+      DEBUG_PRINTLN(newestSlot);
+    }
+    return;
+  }
+
+  PersistentConfig current = candidate;
+  capture(current);
+  unsigned long now = millis();
+
+  // Wait for the value to settle, so a slider sweep costs one write
+  if (memcmp(&current, &candidate, sizeof(current)) != 0) {
+    candidate = current;
+    lastChange = now;
+  } else if (memcmp(&candidate, &saved, sizeof(candidate)) != 0 &&
+             now - lastChange >= CONFIG_SAVE_DELAY) {
+    beginWrite(candidate);
+  }
+#endif
+}
+
+void ConfigStore::restoreDefaults() { apply(defaults); }
+
+void ConfigStore::getStatus(char *buffer, size_t bufferSize) {
+  bool pending = writePosition < sizeof(ConfigRecord) ||
+                 memcmp(&candidate, &saved, sizeof(saved)) != 0;
+  snprintf_P(buffer, bufferSize,
+             PSTR("CFG:slot=%d seq=%u saves=%u pending=%d"),
+             newestSlot == CONFIG_NO_SLOT ? -1 : newestSlot, sequence,
+             saveCount, pending ? 1 : 0);
+}
+
+#endif // CONFIG_STORE_H
@@ -0,0 +1,194 @@
+/**********************************************************************
+ *  debug_log.h - Leveled, Deferred Debug Logging
+ *  Log calls above a module's compile-time level compile to nothing.
+ *  Enabled calls store a compact binary record (message id + 16-bit
+ *  arguments) that is formatted and printed while the loop is idle.
+ *********************************************************************/
+
+#ifndef DEBUG_LOG_H
+#define DEBUG_LOG_H
+
+#include "config.h"
+#include "memory_optimization.h"
+
+#define LOG_MAX_ARGS 3
+#define LOG_LINE_LENGTH 80
+
+// Message catalogue - the text lives in flash, records carry only the id
+#define LOG_MESSAGES(X)                                                        \
+  X(LOG_MSG_MOTOR_TIMEOUT, "⚠ Motor safety timeout - stopping all motors")     \
+  X(LOG_MSG_FORWARD_BLOCKED,                                                   \
+    "⚠ Forward movement blocked by collision avoidance")                       \
+  X(LOG_MSG_BACKWARD_BLOCKED,                                                  \
+    "⚠ Backward movement blocked by collision avoidance")                      \
+  X(LOG_MSG_MOVE_FORWARD, "⬆ Moving forward at %d%%")                          \
+  X(LOG_MSG_MOVE_BACKWARD, "⬇ Moving backward at %d%%")                        \
+  X(LOG_MSG_TURN_LEFT, "⬅ Turning left at %d%%")                               \
+  X(LOG_MSG_TURN_RIGHT, "➡ Turning right at %d%%")                             \
+  X(LOG_MSG_TANK_DRIVE, "🎮 Tank drive - Left: %d%%, Right: %d%%")              \
+  X(LOG_MSG_MOTOR_OUTPUT, "🔧 Motor %d: %d%% -> PWM:%d")                        \
+  X(LOG_MSG_MOTORS_STOPPED, "⏹ All motors stopped")                            \
+  X(LOG_MSG_EMERGENCY_STOP, "🚨 EMERGENCY STOP ACTIVATED")                      \
+  X(LOG_MSG_GLOBAL_SPEED, "🚀 Global speed set to: %d%%")                       \
+  X(LOG_MSG_SERVO_ARRIVED, "🦾 Servo %d at %d°")                                \
+  X(LOG_MSG_SERVO_TARGET, "🎯 Servo %d -> %d° in %d ms")                        \
+  X(LOG_MSG_ARM_MOVE, "🦾 Arm move over %d ms")                                 \
+  X(LOG_MSG_ARM_WAYPOINT, "📍 Waypoint queued (%d pending)")                    \
+  X(LOG_MSG_ARM_HOME, "🏠 Moving arm to home position")                         \
+  X(LOG_MSG_ARM_PRESET, "📋 Moving to preset position %d")                      \
+  X(LOG_MSG_GRIPPER_OPEN, "✋ Opening gripper")                                 \
+  X(LOG_MSG_GRIPPER_CLOSE, "🤏 Closing gripper")                                \
+  X(LOG_MSG_BT_SEND, "📤 BT Send: %d bytes (priority %d)")                      \
+  X(LOG_MSG_BT_RECEIVED, "📥 BT Received: %d bytes")                            \
+  X(LOG_MSG_BT_FRAME, "📥 BT Frame: opcode %d")                                 \
+  X(LOG_MSG_EXECUTE, "⚡ Executing opcode %d")
+
+#define LOG_DEFINE_ID(id, text) id,
+enum LogMessageId : uint8_t { LOG_MESSAGES(LOG_DEFINE_ID) LOG_MESSAGE_COUNT };
+
+#define LOG_DEFINE_TEXT(id, text) const char id##_TEXT[] PROGMEM = text;
+LOG_MESSAGES(LOG_DEFINE_TEXT)
+
+#define LOG_DEFINE_ENTRY(id, text) id##_TEXT,
+const char *const LOG_MESSAGE_TEXT[] PROGMEM = {
+    LOG_MESSAGES(LOG_DEFINE_ENTRY)};
+
+// Record store and idle-time printer
+class DeferredLog {
+private:
+  static RingBuffer<LOG_BUFFER_SIZE> records;
+  static char line[LOG_LINE_LENGTH];
+  static uint8_t lineLength;
+  static uint8_t linePosition;
+  static unsigned int droppedRecords;
+
+  static void formatNextRecord();
+
+public:
+  // Store one record; dropped (and counted) if the buffer is full
+  static void push(uint8_t id, const int16_t *args, uint8_t argCount);
+
+  // Print pending output without waiting for the UART.
+  // Returns true if any bytes were written.
+  static bool drain();
+
+  // Static RAM of the record buffer and line being printed
+  static size_t getRamUsage();
+};
+
+// Compile-time switch: the disabled sink has an empty body, so calls to it
+// (and their arguments) are removed entirely by the optimiser
+template <bool Enabled> struct LogSink {
+  template <typename... Args> static void write(uint8_t id, Args... args) {
+    static_assert(sizeof...(args) <= LOG_MAX_ARGS, "Too many log arguments");
+    const int16_t values[] = {0, (int16_t)args...}; // Avoids an empty array
+    DeferredLog::push(id, values + 1, sizeof...(args));
+  }
+};
+
+template <> struct LogSink<false> {
+  template <typename... Args> static void write(uint8_t id, Args... args) {}
+};
+
+#define LOG_ENABLED(module, level)                                             \
+  (DEBUG_ENABLED && (level) <= LOG_LEVEL_##module)
+
+#define LOG_AT(module, level, id, ...)                                         \
+  LogSink<LOG_ENABLED(module, level)>::write(id, ##__VA_ARGS__)
+
+#define LOG_ERROR(module, id, ...)                                             \
+  LOG_AT(module, LOG_LEVEL_ERROR, id, ##__VA_ARGS__)
+#define LOG_WARN(module, id, ...)                                              \
+  LOG_AT(module, LOG_LEVEL_WARN, id, ##__VA_ARGS__)
+#define LOG_INFO(module, id, ...)                                              \
+  LOG_AT(module, LOG_LEVEL_INFO, id, ##__VA_ARGS__)
+#define LOG_DEBUG(module, id, ...)                                             \
+  LOG_AT(module, LOG_LEVEL_DEBUG, id, ##__VA_ARGS__)
+
+// Static variable definitions
+RingBuffer<LOG_BUFFER_SIZE> DeferredLog::records;
+char DeferredLog::line[LOG_LINE_LENGTH];
+uint8_t DeferredLog::lineLength = 0;
+uint8_t DeferredLog::linePosition = 0;
+unsigned int DeferredLog::droppedRecords = 0;
+
+// Implementation
+void DeferredLog::push(uint8_t id, const int16_t *args, uint8_t argCount) {
+  // Record layout: [id][argCount][timestamp x4][args x2 each]
+  uint8_t record[2 + sizeof(unsigned long) + LOG_MAX_ARGS * sizeof(int16_t)];
+  unsigned long timestamp = millis();
+  uint8_t length = 0;
+
+  record[length++] = id;
+  record[length++] = argCount;
+  memcpy(record + length, &timestamp, sizeof(timestamp));
+  length += sizeof(timestamp);
+  memcpy(record + length, args, argCount * sizeof(int16_t));
+  length += argCount * sizeof(int16_t);
+
+  if (!records.write(record, length) && droppedRecords != 0xFFFF) {
+    droppedRecords++;
+  }
+}
+
+void DeferredLog::formatNextRecord() {
+  linePosition = 0;
+
+  // Report losses before the records that survived them
+  if (droppedRecords > 0) {
+    lineLength = snprintf_P(line, sizeof(line),
+                            PSTR("⚠ %u log records dropped\r\n"),
+                            droppedRecords);
+    droppedRecords = 0;
+    return;
+  }
+
+  uint8_t id = records.read();
+  uint8_t argCount = records.read();
+  unsigned long timestamp;
+  int16_t args[LOG_MAX_ARGS] = {0, 0, 0};
+
+  uint8_t *bytes = (uint8_t *)&timestamp;
+  for (uint8_t i = 0; i < sizeof(timestamp); i++)
+    bytes[i] = records.read();
+
+  bytes = (uint8_t *)args;
+  for (uint8_t i = 0; i < argCount * sizeof(int16_t); i++)
+    bytes[i] = records.read();
+
+  if (id >= LOG_MESSAGE_COUNT) {
+    lineLength = 0;
+    return;
+  }
+
+  // Unused arguments are ignored by the format
+  PGM_P format = (PGM_P)pgm_read_ptr(&LOG_MESSAGE_TEXT[id]);
+  int length = snprintf_P(line, sizeof(line), PSTR("[%lu] "), timestamp);
+  length += snprintf_P(line + length, sizeof(line) - length, format,
+                       (int)args[0], (int)args[1], (int)args[2]);
+  if (length > (int)sizeof(line) - 3)
+    length = sizeof(line) - 3;
+  line[length++] = '\r';
+  line[length++] = '\n';
+  lineLength = length;
+}
+
+bool DeferredLog::drain() {
+  if (linePosition >= lineLength) {
+    if (records.isEmpty() && droppedRecords == 0)
+      return false;
+    formatNextRecord();
+  }
+
+  int space = Serial.availableForWrite();
+  bool wrote = false;
+  while (space-- > 0 && linePosition < lineLength) {
+    Serial.write(line[linePosition++]);
+    wrote = true;
+  }
+  return wrote;
+}
+
+size_t DeferredLog::getRamUsage() { return sizeof(records) + sizeof(line); }
+
+#endif // DEBUG_LOG_H
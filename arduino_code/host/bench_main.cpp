@@ -0,0 +1,54 @@
+/**********************************************************************
+ *  bench_main.cpp - Host Benchmark Runner
+ *  Boots the firmware on the shim, then runs the BENCH report on the
+ *  real clock (one case per REPORT task run) and prints its lines:
+ *    BENCH:<case> ns=<per call> stack=<bytes> heap=<bytes allocated>
+ *  Host numbers rank changes against each other; for AVR cycles use
+ *  simavr_bench.sh.
+ *
+ *  Usage: robot_bench [iterations]
+ *********************************************************************/
+
+#include "sketch.h"
+
+// Long enough for the link to come up, so BENCH output is sent
+#define BENCH_BOOT_MS 3000
+
+int main(int argc, char **argv) {
+  uint16_t iterations = argc > 1 ? atoi(argv[1]) : 0;
+
+  setup();
+  runFor(BENCH_BOOT_MS);
+  Serial1.takeOutput();
+
+  Shim::useRealTime(true);
+  Report::start("BENCH", Benchmark::reportLine, iterations);
+  while (Report::isActive()) {
+    loop();
+  }
+  Shim::useRealTime(false);
+  runFor(BENCH_BOOT_MS); // Drain the queued lines
+
+  std::string output = Serial1.takeOutput();
+  int cases = 0;
+  size_t start = 0;
+  while (start < output.size()) {
+    size_t end = output.find('\n', start);
+    if (end == std::string::npos)
+      end = output.size();
+    std::string line = output.substr(start, end - start);
+    if (!line.empty() && line.back() == '\r')
+      line.pop_back();
+    if (line.compare(0, 6, "BENCH:") == 0) {
+      printf("%s\n", line.c_str());
+      cases++;
+    }
+    start = end + 1;
+  }
+
+  if (cases == 0) {
+    fprintf(stderr, "no BENCH output\n");
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,65 @@
+/**********************************************************************
+ *  bridge_check.cpp - Host Check of the TTGO T-Call Bridge Build
+ *  Boots controller/new_motor on the shim and drives it over Serial1
+ *  the way the ESP32 does: a drive command must reach the motors (no
+ *  sensors to veto it) and stop soon after the ESP32 stops repeating it,
+ *  commands for hardware the build doesn't have must fail, and a
+ *  setting change must reach EEPROM once.
+ *
+ *  Usage: bridge_check
+ *  Prints what went wrong; exits 1 on a failed check.
+ *********************************************************************/
+
+#define HOST_BRIDGE_SKETCH
+#include "sketch.h"
+
+#define BRIDGE_BOOT_MS 1500
+#define BRIDGE_STOP_MS 1000 // A lost link must stop the robot within this
+#define BRIDGE_SAVE_MS (CONFIG_SAVE_DELAY + 1000)
+
+static int failures = 0;
+
+static void check(bool passed, const char *what) {
+  printf("%s: %s\n", passed ? "OK" : "FAIL", what);
+  if (!passed)
+    failures++;
+}
+
+static bool sent(const std::string &output, const char *line) {
+  return output.find(std::string(line) + "\r\n") != std::string::npos;
+}
+
+int main() {
+  setup();
+  runFor(BRIDGE_BOOT_MS);
+  check(sent(Serial1.takeOutput(), "MEGA_READY"), "MEGA_READY sent");
+
+  Serial1.inject("F:60\n");
+  runFor(200);
+  check(Shim::getPwm(DRIVER1_EN1) > 0, "F:60 drives the motors");
+  check(sent(Serial1.takeOutput(), "OK_F"), "F:60 acknowledged");
+
+  runFor(BRIDGE_STOP_MS);
+  check(Shim::getPwm(DRIVER1_EN1) == 0, "silence stops the motors");
+
+  const char *unfitted[] = {"SEN", "SE:1,90", "PON", "CD:20"};
+  for (const char *command : unfitted) {
+    Serial1.inject(command);
+    Serial1.inject("\n");
+    runFor(100);
+    std::string name(command, strcspn(command, ":"));
+    check(sent(Serial1.takeOutput(), ("ERROR_" + name).c_str()), command);
+  }
+
+  // Only the motor speed is kept; a change is saved once and then rests
+  Serial1.inject("SP:50\n");
+  runFor(BRIDGE_SAVE_MS);
+  Serial1.takeOutput();
+  Serial1.inject("CFG\n");
+  runFor(100);
+  std::string config = Serial1.takeOutput();
+  check(config.find("saves=1 pending=0") != std::string::npos,
+        "SP:50 saved once");
+
+  return failures > 0 ? 1 : 0;
+}
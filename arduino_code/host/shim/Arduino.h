@@ -0,0 +1,239 @@
+/**********************************************************************
+ *  Arduino.h - Host Build Shim
+ *  Just enough of the Arduino core for the firmware headers to build
+ *  unmodified with a desktop compiler (see host/CMakeLists.txt):
+ *  millis()/micros() on a simulated or real clock, pins with HC-SR04
+ *  echoes, Serial ports backed by memory, EEPROM in RAM and flash
+ *  strings as plain strings. __AVR__ stays undefined, so the headers
+ *  take their portable paths (no registers, sleep or watchdog).
+ *
+ *  The Shim namespace at the end is for the host programs only.
+ *********************************************************************/
+
+#ifndef HOST_SHIM_ARDUINO_H
+#define HOST_SHIM_ARDUINO_H
+
+// Standard library first: the min/max macros below would break it
+#include <ctype.h>
+#include <math.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include <deque>
+#include <string>
+
+typedef uint8_t byte;
+typedef bool boolean;
+typedef uint16_t word;
+
+// ========== FLASH STRINGS ==========
+// One address space on the host: flash is ordinary read-only data
+
+#define PROGMEM
+#define PGM_P const char *
+#define PSTR(s) (s)
+
+class __FlashStringHelper;
+#define F(s) (reinterpret_cast<const __FlashStringHelper *>(PSTR(s)))
+
+#define pgm_read_byte(p) (*(const uint8_t *)(p))
+#define pgm_read_word(p) (*(const uint16_t *)(p))
+#define pgm_read_dword(p) (*(const uint32_t *)(p))
+#define pgm_read_ptr(p) (*(void *const *)(p))
+
+#define memcpy_P memcpy
+#define snprintf_P snprintf
+#define strcasecmp_P strcasecmp
+#define strcmp_P strcmp
+#define strcpy_P strcpy
+#define strlen_P strlen
+#define strncasecmp_P strncasecmp
+#define strncat_P strncat
+#define strncmp_P strncmp
+#define strncpy_P strncpy
+#define vsnprintf_P vsnprintf
+
+char *itoa(int value, char *text, int base);
+char *ltoa(long value, char *text, int base);
+char *utoa(unsigned int value, char *text, int base);
+char *ultoa(unsigned long value, char *text, int base);
+char *dtostrf(double value, signed char width, unsigned char precision,
+              char *text);
+
+// ========== CORE ==========
+
+#define HIGH 0x1
+#define LOW 0x0
+
+#define INPUT 0x0
+#define OUTPUT 0x1
+#define INPUT_PULLUP 0x2
+
+#define CHANGE 1
+#define FALLING 2
+#define RISING 3
+
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+#define LED_BUILTIN 13
+#define NUM_DIGITAL_PINS 70
+
+// Mega 2560 analog pins
+#define A0 54
+#define A1 55
+#define A2 56
+#define A3 57
+#define A4 58
+#define A5 59
+#define A6 60
+#define A7 61
+#define A8 62
+#define A9 63
+#define A10 64
+#define A11 65
+#define A12 66
+#define A13 67
+#define A14 68
+#define A15 69
+
+#define min(a, b) ((a) < (b) ? (a) : (b))
+#define max(a, b) ((a) > (b) ? (a) : (b))
+#define constrain(amt, low, high)                                              \
+  ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+#define sq(x) ((x) * (x))
+
+#define bit(b) (1UL << (b))
+#define _BV(b) (1 << (b))
+#define lowByte(w) ((uint8_t)((w) & 0xff))
+#define highByte(w) ((uint8_t)((w) >> 8))
+#define bitRead(value, b) (((value) >> (b)) & 0x01)
+#define bitSet(value, b) ((value) |= (1UL << (b)))
+#define bitClear(value, b) ((value) &= ~(1UL << (b)))
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+void analogWrite(uint8_t pin, int value);
+int analogRead(uint8_t pin);
+unsigned long pulseIn(uint8_t pin, uint8_t state,
+                      unsigned long timeout = 1000000UL);
+
+#define digitalPinToInterrupt(pin) (pin)
+void attachInterrupt(uint8_t interrupt, void (*isr)(), int mode);
+void detachInterrupt(uint8_t interrupt);
+inline void interrupts() {}
+inline void noInterrupts() {}
+
+long map(long value, long fromLow, long fromHigh, long toLow, long toHigh);
+long random(long howBig);
+long random(long howSmall, long howBig);
+void randomSeed(unsigned long seed);
+
+// ========== SERIAL ==========
+
+class Print {
+public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t *buffer, size_t size);
+  size_t write(const char *text) {
+    return write((const uint8_t *)text, strlen(text));
+  }
+
+  size_t print(const __FlashStringHelper *text);
+  size_t print(const char *text);
+  size_t print(char c);
+  size_t print(unsigned char value, int base = DEC);
+  size_t print(int value, int base = DEC);
+  size_t print(unsigned int value, int base = DEC);
+  size_t print(long value, int base = DEC);
+  size_t print(unsigned long value, int base = DEC);
+  size_t print(double value, int digits = 2);
+
+  size_t println();
+  template <typename T> size_t println(T value) {
+    size_t n = print(value);
+    return n + println();
+  }
+  template <typename T> size_t println(T value, int format) {
+    size_t n = print(value, format);
+    return n + println();
+  }
+};
+
+// A UART whose receive side is fed by the host program and whose
+// transmit side is collected for it to read back
+class HardwareSerial : public Print {
+private:
+  std::deque<uint8_t> input;
+  std::string output;
+  FILE *echo;
+  unsigned long baud;
+
+public:
+  HardwareSerial() : echo(nullptr), baud(0) {}
+
+  void begin(unsigned long rate) { baud = rate; }
+  void begin(unsigned long rate, uint8_t) { baud = rate; }
+  void end() { baud = 0; }
+  int available() { return (int)input.size(); }
+  int availableForWrite() { return 63; } // Drains instantly
+  int peek() { return input.empty() ? -1 : input.front(); }
+  int read();
+  void flush() {}
+  size_t write(uint8_t c) override;
+  using Print::write;
+  operator bool() { return true; }
+
+  // Host side
+  void inject(const char *text);
+  void inject(const uint8_t *data, size_t size);
+  std::string takeOutput();
+  void echoTo(FILE *stream) { echo = stream; }
+  unsigned long getBaud() const { return baud; }
+};
+
+extern HardwareSerial Serial;
+extern HardwareSerial Serial1;
+extern HardwareSerial Serial2;
+extern HardwareSerial Serial3;
+
+// ========== HOST CONTROL ==========
+
+namespace Shim {
+// The clock starts simulated: every millis()/micros() call moves it
+// SHIM_CALL_US forward, so busy-waits end and a run repeats exactly.
+// Real time is for timing measurements.
+#define SHIM_CALL_US 2
+void useRealTime(bool real);
+void advance(unsigned long us);
+
+// HC-SR04 model: a trigger pulse on trigPin answers on echoPin with a
+// pulse as long as the round trip to the set distance (0 = no echo)
+void connectEcho(uint8_t trigPin, uint8_t echoPin);
+void setEchoDistance(uint8_t echoPin, unsigned int mm);
+
+void setDigitalInput(uint8_t pin, uint8_t value);
+void setAnalogInput(uint8_t pin, int value);
+int getPwm(uint8_t pin); // Last analogWrite() value
+
+// Bytes malloc/new handed out since start, also what the firmware's
+// MemoryMonitor::getHeapUsed() reports
+unsigned long heapAllocated();
+} // namespace Shim
+
+#endif // HOST_SHIM_ARDUINO_H
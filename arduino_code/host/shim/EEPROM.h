@@ -0,0 +1,29 @@
+/**********************************************************************
+ *  EEPROM.h - Host Build Shim
+ *  The Mega's 4KB EEPROM in RAM, erased (0xFF) at start.
+ *********************************************************************/
+
+#ifndef HOST_SHIM_EEPROM_H
+#define HOST_SHIM_EEPROM_H
+
+#include <Arduino.h>
+
+#define E2END 0xFFF
+
+class EEPROMClass {
+private:
+  uint8_t cells[E2END + 1];
+
+public:
+  EEPROMClass() { memset(cells, 0xFF, sizeof(cells)); }
+
+  uint8_t read(int address) { return cells[address & E2END]; }
+  void write(int address, uint8_t value) { cells[address & E2END] = value; }
+  void update(int address, uint8_t value) { write(address, value); }
+  uint8_t &operator[](int address) { return cells[address & E2END]; }
+  uint16_t length() { return E2END + 1; }
+};
+
+extern EEPROMClass EEPROM;
+
+#endif // HOST_SHIM_EEPROM_H
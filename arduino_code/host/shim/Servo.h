@@ -0,0 +1,35 @@
+/**********************************************************************
+ *  Servo.h - Host Build Shim
+ *  Keeps the last pulse written, nothing more.
+ *********************************************************************/
+
+#ifndef HOST_SHIM_SERVO_H
+#define HOST_SHIM_SERVO_H
+
+#include <Arduino.h>
+
+class Servo {
+private:
+  int8_t pin;
+  int pulse;
+
+public:
+  Servo() : pin(-1), pulse(1500) {}
+
+  uint8_t attach(int servoPin) { return attach(servoPin, 544, 2400); }
+  uint8_t attach(int servoPin, int, int) {
+    pin = servoPin;
+    return 0;
+  }
+  void detach() { pin = -1; }
+  bool attached() { return pin >= 0; }
+
+  void write(int angle) {
+    pulse = map(constrain(angle, 0, 180), 0, 180, 544, 2400);
+  }
+  void writeMicroseconds(int us) { pulse = us; }
+  int read() { return map(pulse, 544, 2400, 0, 180); }
+  int readMicroseconds() { return pulse; }
+};
+
+#endif // HOST_SHIM_SERVO_H
@@ -0,0 +1,479 @@
+/**********************************************************************
+ *  arduino_shim.cpp - Host Build Shim
+ *  Clock, pins, HC-SR04 echoes, Serial ports, EEPROM and the heap
+ *  symbols MemoryMonitor reads. See Arduino.h.
+ *********************************************************************/
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include <Arduino.h>
+#include <EEPROM.h>
+
+HardwareSerial Serial;
+HardwareSerial Serial1;
+HardwareSerial Serial2;
+HardwareSerial Serial3;
+EEPROMClass EEPROM;
+
+// What avr-libc's malloc keeps; MemoryMonitor reads them directly.
+// __brkval moves up by every allocation and never back, so the heap a
+// piece of code used is the difference across it.
+char __heap_start;
+char *__malloc_heap_start = &__heap_start;
+char *__brkval = nullptr;
+
+namespace {
+
+// ========== CLOCK ==========
+
+bool realTime = false;
+unsigned long simulatedUs = 0;
+unsigned long realBaseUs = 0; // Simulated time when real time started
+std::chrono::steady_clock::time_point realStart;
+
+// ========== PINS AND ECHOES ==========
+
+#define ECHO_DELAY_US 460 // Trigger fall to echo rise on an HC-SR04
+#define ECHO_MAX_MODELS 8
+
+struct EchoModel {
+  uint8_t trigPin;
+  uint8_t echoPin;
+  unsigned int distance; // mm, 0 = no echo
+};
+
+struct PinEdge {
+  unsigned long at;
+  uint8_t pin;
+  uint8_t level;
+};
+
+uint8_t levels[NUM_DIGITAL_PINS];
+int pwm[NUM_DIGITAL_PINS];
+int analogInputs[16];
+void (*isrs[NUM_DIGITAL_PINS])();
+int isrModes[NUM_DIGITAL_PINS];
+
+EchoModel echoModels[ECHO_MAX_MODELS];
+uint8_t echoModelCount = 0;
+std::vector<PinEdge> pendingEdges;
+bool firingEdges = false;
+
+// ========== HEAP ==========
+
+unsigned long allocated = 0;
+int internalDepth = 0; // Shim bookkeeping isn't the firmware's heap
+
+struct InternalScope {
+  InternalScope() { internalDepth++; }
+  ~InternalScope() { internalDepth--; }
+};
+
+void noteAllocation(size_t size) {
+  if (internalDepth > 0 || size == 0)
+    return;
+  allocated += size;
+  __brkval = (char *)((uintptr_t)__malloc_heap_start + allocated);
+}
+
+unsigned long now() {
+  if (!realTime)
+    return simulatedUs;
+  auto elapsed = std::chrono::steady_clock::now() - realStart;
+  return realBaseUs +
+         (unsigned long)std::chrono::duration_cast<std::chrono::microseconds>(
+             elapsed)
+             .count();
+}
+
+void setLevel(uint8_t pin, uint8_t level) {
+  if (pin >= NUM_DIGITAL_PINS || levels[pin] == level)
+    return;
+  levels[pin] = level;
+  int mode = isrModes[pin];
+  bool fire = mode == CHANGE || (mode == RISING && level == HIGH) ||
+              (mode == FALLING && level == LOW);
+  if (isrs[pin] && fire)
+    isrs[pin]();
+}
+
+// Apply the echo edges that are due, in order. An ISR reading micros()
+// lands back here, so the guard keeps it from recursing.
+void fireEdges() {
+  if (firingEdges)
+    return;
+  firingEdges = true;
+  while (!pendingEdges.empty()) {
+    size_t next = 0;
+    for (size_t i = 1; i < pendingEdges.size(); i++) {
+      if (pendingEdges[i].at < pendingEdges[next].at)
+        next = i;
+    }
+    if (pendingEdges[next].at > now())
+      break;
+    PinEdge edge = pendingEdges[next];
+    pendingEdges.erase(pendingEdges.begin() + next);
+    setLevel(edge.pin, edge.level);
+  }
+  firingEdges = false;
+}
+
+void tick(unsigned long us) {
+  if (!realTime)
+    simulatedUs += us;
+  fireEdges();
+}
+
+EchoModel *findEcho(uint8_t pin, bool byTrigger) {
+  for (uint8_t i = 0; i < echoModelCount; i++) {
+    if ((byTrigger ? echoModels[i].trigPin : echoModels[i].echoPin) == pin)
+      return &echoModels[i];
+  }
+  return nullptr;
+}
+
+// Round trip at 343 m/s: 5.83us per mm, the 58us/cm of the datasheet
+unsigned long echoMicros(unsigned int distance) {
+  return (unsigned long)distance * 58 / 10;
+}
+
+char *formatNumber(unsigned long value, char *text, int base,
+                   bool negative) {
+  char digits[sizeof(unsigned long) * 8 + 2];
+  int length = 0;
+  do {
+    int digit = value % base;
+    digits[length++] = digit < 10 ? '0' + digit : 'a' + digit - 10;
+    value /= base;
+  } while (value > 0);
+
+  char *out = text;
+  if (negative)
+    *out++ = '-';
+  while (length > 0)
+    *out++ = digits[--length];
+  *out = '\0';
+  return text;
+}
+
+} // namespace
+
+// ========== HEAP COUNTING ==========
+// glibc lets a program replace malloc; these count and hand on to it
+
+#if defined(__GLIBC__)
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *pointer, size_t size);
+void __libc_free(void *pointer);
+
+void *malloc(size_t size) {
+  noteAllocation(size);
+  return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size) {
+  noteAllocation(count * size);
+  return __libc_calloc(count, size);
+}
+
+void *realloc(void *pointer, size_t size) {
+  noteAllocation(size);
+  return __libc_realloc(pointer, size);
+}
+
+void free(void *pointer) { __libc_free(pointer); }
+}
+#endif
+
+// ========== CORE ==========
+
+unsigned long millis() {
+  tick(SHIM_CALL_US);
+  return now() / 1000;
+}
+
+unsigned long micros() {
+  tick(SHIM_CALL_US);
+  return now();
+}
+
+void delay(unsigned long ms) { delayMicroseconds(ms * 1000); }
+
+void delayMicroseconds(unsigned int us) {
+  if (realTime) {
+    std::this_thread::sleep_for(std::chrono::microseconds(us));
+    fireEdges();
+    return;
+  }
+  // Step so echoes that fall inside the delay still fire in order
+  unsigned long end = simulatedUs + us;
+  while (simulatedUs < end) {
+    tick(min(end - simulatedUs, 100UL));
+  }
+}
+
+void yield() {}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+  if (pin < NUM_DIGITAL_PINS && mode == INPUT_PULLUP)
+    levels[pin] = HIGH;
+}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+  if (pin >= NUM_DIGITAL_PINS)
+    return;
+  uint8_t level = value ? HIGH : LOW;
+  bool trigFall = levels[pin] == HIGH && level == LOW;
+  levels[pin] = level;
+
+  EchoModel *echo = trigFall ? findEcho(pin, true) : nullptr;
+  if (echo && echo->distance > 0) {
+    InternalScope scope;
+    unsigned long rise = now() + ECHO_DELAY_US;
+    pendingEdges.push_back({rise, echo->echoPin, HIGH});
+    pendingEdges.push_back(
+        {rise + echoMicros(echo->distance), echo->echoPin, LOW});
+  }
+}
+
+int digitalRead(uint8_t pin) {
+  fireEdges();
+  return pin < NUM_DIGITAL_PINS ? levels[pin] : LOW;
+}
+
+void analogWrite(uint8_t pin, int value) {
+  if (pin >= NUM_DIGITAL_PINS)
+    return;
+  pwm[pin] = value;
+  levels[pin] = value > 0 ? HIGH : LOW;
+}
+
+int analogRead(uint8_t pin) {
+  if (pin >= A0)
+    pin -= A0;
+  return pin < 16 ? analogInputs[pin] : 0;
+}
+
+unsigned long pulseIn(uint8_t pin, uint8_t state, unsigned long timeout) {
+  EchoModel *echo = findEcho(pin, false);
+  if (state != HIGH || !echo || echo->distance == 0) {
+    delayMicroseconds(timeout);
+    return 0;
+  }
+  unsigned long width = echoMicros(echo->distance);
+  if (width > timeout) {
+    delayMicroseconds(timeout);
+    return 0;
+  }
+  delayMicroseconds(ECHO_DELAY_US + width);
+  return width;
+}
+
+void attachInterrupt(uint8_t interrupt, void (*isr)(), int mode) {
+  if (interrupt < NUM_DIGITAL_PINS) {
+    isrs[interrupt] = isr;
+    isrModes[interrupt] = mode;
+  }
+}
+
+void detachInterrupt(uint8_t interrupt) {
+  if (interrupt < NUM_DIGITAL_PINS)
+    isrs[interrupt] = nullptr;
+}
+
+long map(long value, long fromLow, long fromHigh, long toLow, long toHigh) {
+  return (value - fromLow) * (toHigh - toLow) / (fromHigh - fromLow) + toLow;
+}
+
+// Fixed sequence (a 32-bit LCG), so simulated runs repeat
+static unsigned long randomState = 1;
+
+long random(long howBig) {
+  if (howBig <= 0)
+    return 0;
+  randomState = (randomState * 1103515245UL + 12345UL) & 0xFFFFFFFFUL;
+  return (long)((randomState >> 8) % (unsigned long)howBig);
+}
+
+long random(long howSmall, long howBig) {
+  if (howSmall >= howBig)
+    return howSmall;
+  return howSmall + random(howBig - howSmall);
+}
+
+void randomSeed(unsigned long seed) {
+  if (seed != 0)
+    randomState = seed;
+}
+
+char *itoa(int value, char *text, int base) {
+  return ltoa(value, text, base);
+}
+
+char *ltoa(long value, char *text, int base) {
+  bool negative = value < 0 && base == 10;
+  unsigned long magnitude = negative ? 0UL - (unsigned long)value
+                                     : (unsigned long)value;
+  if (base != 10)
+    magnitude &= 0xFFFFFFFFUL; // Two's complement at the AVR's long width
+  return formatNumber(magnitude, text, base, negative);
+}
+
+char *utoa(unsigned int value, char *text, int base) {
+  return formatNumber(value, text, base, false);
+}
+
+char *ultoa(unsigned long value, char *text, int base) {
+  return formatNumber(value, text, base, false);
+}
+
+char *dtostrf(double value, signed char width, unsigned char precision,
+              char *text) {
+  sprintf(text, "%*.*f", width, precision, value);
+  return text;
+}
+
+// ========== SERIAL ==========
+
+size_t Print::write(const uint8_t *buffer, size_t size) {
+  for (size_t i = 0; i < size; i++) {
+    write(buffer[i]);
+  }
+  return size;
+}
+
+size_t Print::print(const __FlashStringHelper *text) {
+  return print(reinterpret_cast<const char *>(text));
+}
+
+size_t Print::print(const char *text) { return write(text); }
+
+size_t Print::print(char c) { return write((uint8_t)c); }
+
+size_t Print::print(unsigned char value, int base) {
+  return print((unsigned long)value, base);
+}
+
+size_t Print::print(int value, int base) { return print((long)value, base); }
+
+size_t Print::print(unsigned int value, int base) {
+  return print((unsigned long)value, base);
+}
+
+size_t Print::print(long value, int base) {
+  char text[sizeof(long) * 8 + 2];
+  return print(ltoa(value, text, base));
+}
+
+size_t Print::print(unsigned long value, int base) {
+  char text[sizeof(long) * 8 + 2];
+  return print(ultoa(value, text, base));
+}
+
+size_t Print::print(double value, int digits) {
+  char text[48];
+  snprintf(text, sizeof(text), "%.*f", digits, value);
+  return print(text);
+}
+
+size_t Print::println() { return write((const uint8_t *)"\r\n", 2); }
+
+int HardwareSerial::read() {
+  if (input.empty())
+    return -1;
+  uint8_t c = input.front();
+  input.pop_front();
+  return c;
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+  InternalScope scope;
+  output.push_back((char)c);
+  if (echo)
+    fputc(c, echo);
+  return 1;
+}
+
+void HardwareSerial::inject(const char *text) {
+  inject((const uint8_t *)text, strlen(text));
+}
+
+void HardwareSerial::inject(const uint8_t *data, size_t size) {
+  InternalScope scope;
+  input.insert(input.end(), data, data + size);
+}
+
+std::string HardwareSerial::takeOutput() {
+  InternalScope scope;
+  std::string taken;
+  taken.swap(output);
+  return taken;
+}
+
+// ========== HOST CONTROL ==========
+
+void Shim::useRealTime(bool real) {
+  if (real == realTime)
+    return;
+  if (real) {
+    realBaseUs = simulatedUs;
+    realStart = std::chrono::steady_clock::now();
+  } else {
+    simulatedUs = now();
+  }
+  realTime = real;
+}
+
+void Shim::advance(unsigned long us) {
+  if (realTime) {
+    delayMicroseconds(us);
+    return;
+  }
+  unsigned long end = simulatedUs + us;
+  while (simulatedUs < end) {
+    tick(min(end - simulatedUs, 100UL));
+  }
+}
+
+void Shim::connectEcho(uint8_t trigPin, uint8_t echoPin) {
+  if (findEcho(trigPin, true) || echoModelCount == ECHO_MAX_MODELS)
+    return;
+  echoModels[echoModelCount++] = {trigPin, echoPin, 0};
+}
+
+void Shim::setEchoDistance(uint8_t echoPin, unsigned int mm) {
+  EchoModel *echo = findEcho(echoPin, false);
+  if (echo)
+    echo->distance = mm;
+}
+
+void Shim::setDigitalInput(uint8_t pin, uint8_t value) {
+  setLevel(pin, value ? HIGH : LOW);
+}
+
+void Shim::setAnalogInput(uint8_t pin, int value) {
+  if (pin >= A0)
+    pin -= A0;
+  if (pin < 16)
+    analogInputs[pin] = value;
+}
+
+int Shim::getPwm(uint8_t pin) {
+  return pin < NUM_DIGITAL_PINS ? pwm[pin] : 0;
+}
+
+unsigned long Shim::heapAllocated() { return allocated; }
+
+// Last in the file, so it runs after the Serial ports are constructed:
+// what the C++ runtime and the shim allocated before main() is not the
+// firmware's heap
+static struct HeapBaseline {
+  HeapBaseline() {
+    allocated = 0;
+    __brkval = nullptr;
+  }
+} heapBaseline;
@@ -0,0 +1,26 @@
+#!/bin/sh
+# Cycle counts for the BENCH cases on a simulated Mega 2560.
+#
+# Builds the firmware with BENCH_CYCLE_COUNT (benchmark.h), which runs
+# every case once at the end of setup(), prints the BENCH lines with
+# cycles=<per call> on Serial and halts; simavr then exits.
+#
+# Needs arduino-cli with the arduino:avr core, and simavr.
+#   host/simavr_bench.sh [build dir]
+set -e
+
+HOST_DIR=$(cd "$(dirname "$0")" && pwd)
+FIRMWARE_DIR=$(dirname "$HOST_DIR")
+BUILD_DIR=${1:-$FIRMWARE_DIR/../_simavr_build}
+
+# arduino-cli wants the main .ino named after its folder
+SKETCH_DIR=$BUILD_DIR/robot_controller
+mkdir -p "$SKETCH_DIR"
+cp "$FIRMWARE_DIR"/*.h "$FIRMWARE_DIR"/robot_controller.ino "$SKETCH_DIR"
+
+arduino-cli compile --fqbn arduino:avr:mega \
+  --build-property "compiler.cpp.extra_flags=-DBENCH_CYCLE_COUNT=1" \
+  --output-dir "$BUILD_DIR/out" "$SKETCH_DIR"
+
+simavr -m atmega2560 -f 16000000 "$BUILD_DIR/out/robot_controller.ino.elf" |
+  grep "BENCH:"
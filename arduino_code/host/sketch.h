@@ -0,0 +1,39 @@
+/**********************************************************************
+ *  sketch.h - The Firmware as One Host Translation Unit
+ *  Does what the Arduino builder does to robot_controller.ino: includes
+ *  Arduino.h, declares the sketch's functions ahead of their use and
+ *  then compiles the sketch itself. Each host program includes this
+ *  once, so it can reach the firmware's classes directly.
+ *
+ *  With HOST_BRIDGE_SKETCH the sketch is controller/new_motor instead.
+ *********************************************************************/
+
+#ifndef HOST_SKETCH_H
+#define HOST_SKETCH_H
+
+#include <Arduino.h>
+
+void setup();
+void loop();
+void printBanner();
+void sendBootReport();
+void initializeSystem();
+void handleSerialCommands();
+void registerTasks();
+void memoryTask();
+
+#ifdef HOST_BRIDGE_SKETCH
+#include "../../controller/new_motor/new_motor.ino"
+#else
+#include "../robot_controller.ino"
+#endif
+
+// Run the scheduler for ms of simulated time
+inline void runFor(unsigned long ms) {
+  unsigned long start = millis();
+  while (millis() - start < ms) {
+    loop();
+  }
+}
+
+#endif // HOST_SKETCH_H
@@ -0,0 +1,151 @@
+/**********************************************************************
+ *  trace_replay.cpp - Host Trace Replay
+ *  Replays a captured command trace through the firmware on the
+ *  simulated clock, so a run repeats exactly, and checks what the robot
+ *  answers against what it said when the trace was recorded.
+ *
+ *  The trace file is the TR: lines of a TRACE:4 dump (other lines, such
+ *  as the rest of an app log, are skipped). Every recorded outbound line
+ *  must come back in the same order; other output in between is fine.
+ *  Lines that carry the time (PONG) or belong to the TRACE commands
+ *  that framed the recording can't repeat and are not checked.
+ *
+ *  Usage: trace_replay <trace file> [speed]
+ *  Prints the TRACE: report and any mismatch; exits 1 on a mismatch.
+ *********************************************************************/
+
+#include <fstream>
+#include <vector>
+
+#include "sketch.h"
+
+#define REPLAY_BOOT_MS 3000
+#define REPLAY_STEP_MS 100
+#define REPLAY_MAX_MS 600000UL // Give up on a replay that never reports
+
+static bool readTrace(const char *path, std::vector<uint8_t> &trace) {
+  std::ifstream file(path);
+  if (!file)
+    return false;
+
+  std::string line;
+  while (std::getline(file, line)) {
+    size_t start = line.find("TR:");
+    if (start == std::string::npos)
+      continue;
+    for (size_t i = start + 3; i + 1 < line.size(); i += 2) {
+      if (!isxdigit(line[i]) || !isxdigit(line[i + 1]))
+        break;
+      trace.push_back((uint8_t)strtoul(line.substr(i, 2).c_str(), nullptr,
+                                       16));
+    }
+  }
+  return true;
+}
+
+static bool isCheckable(const std::string &line) {
+  return line.compare(0, 5, "PONG:") != 0 &&
+         line.compare(0, 6, "TRACE:") != 0 &&
+         line.compare(0, 8, "OK_TRACE") != 0;
+}
+
+// The outbound records, in the order the robot sent them
+static std::vector<std::string> recordedOutput(
+    const std::vector<uint8_t> &trace) {
+  std::vector<std::string> lines;
+  size_t position = 0;
+  while (position + TRACE_HEADER_LENGTH <= trace.size()) {
+    uint8_t size = trace[position + 3];
+    if (trace[position] == TRACE_OUTBOUND) {
+      std::string line(trace.begin() + position + TRACE_HEADER_LENGTH,
+                       trace.begin() + position + TRACE_HEADER_LENGTH + size);
+      if (isCheckable(line))
+        lines.push_back(line);
+    }
+    position += TRACE_HEADER_LENGTH + size;
+  }
+  return lines;
+}
+
+static std::vector<std::string> splitLines(const std::string &text) {
+  std::vector<std::string> lines;
+  size_t start = 0;
+  while (start < text.size()) {
+    size_t end = text.find('\n', start);
+    if (end == std::string::npos)
+      end = text.size();
+    std::string line = text.substr(start, end - start);
+    if (!line.empty() && line.back() == '\r')
+      line.pop_back();
+    if (!line.empty())
+      lines.push_back(line);
+    start = end + 1;
+  }
+  return lines;
+}
+
+int main(int argc, char **argv) {
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s <trace file> [speed]\n", argv[0]);
+    return 2;
+  }
+  uint8_t speed = argc > 2 ? atoi(argv[2]) : 1;
+
+  std::vector<uint8_t> trace;
+  if (!readTrace(argv[1], trace)) {
+    fprintf(stderr, "%s: can't read\n", argv[1]);
+    return 2;
+  }
+
+  setup();
+  runFor(REPLAY_BOOT_MS);
+  Serial1.takeOutput();
+
+  if (!CommandTrace::load(trace.data(), trace.size())) {
+    fprintf(stderr, "%s: not a valid trace (%u bytes)\n", argv[1],
+            (unsigned)trace.size());
+    return 2;
+  }
+  CommandTrace::startReplay(speed);
+
+  std::vector<std::string> output;
+  bool reported = false;
+  for (unsigned long elapsed = 0; !reported && elapsed < REPLAY_MAX_MS;
+       elapsed += REPLAY_STEP_MS) {
+    runFor(REPLAY_STEP_MS);
+    for (const std::string &line : splitLines(Serial1.takeOutput())) {
+      output.push_back(line);
+      // The last line of the report
+      reported = reported || line.compare(0, 15, "TRACE:REJECTED ") == 0;
+    }
+  }
+  runFor(REPLAY_STEP_MS); // ESTOP follows REJECTED
+  for (const std::string &line : splitLines(Serial1.takeOutput())) {
+    output.push_back(line);
+  }
+
+  for (const std::string &line : output) {
+    if (line.compare(0, 6, "TRACE:") == 0)
+      printf("%s\n", line.c_str());
+  }
+  if (!reported) {
+    printf("FAIL: the replay never reported\n");
+    return 1;
+  }
+
+  // Each expected line must turn up after the previous one
+  std::vector<std::string> expected = recordedOutput(trace);
+  size_t next = 0;
+  for (const std::string &line : output) {
+    if (next < expected.size() && line == expected[next])
+      next++;
+  }
+  if (next < expected.size()) {
+    printf("FAIL: %u of %u recorded lines repeated; missing \"%s\"\n",
+           (unsigned)next, (unsigned)expected.size(),
+           expected[next].c_str());
+    return 1;
+  }
+  printf("OK: %u recorded lines repeated\n", (unsigned)expected.size());
+  return 0;
+}
@@ -0,0 +1,153 @@
+/**********************************************************************
+ *  link_probe.h - Bluetooth Link Round-Trip Probe
+ *  Robot-initiated pings for measuring the link itself: PB:n sends n
+ *  numbered pings back to back, the app answers each with PR:<seq>, and
+ *  the round-trip time and its jitter go into PERF histograms. The end
+ *  of a burst reports losses and the achieved ping rate.
+ *
+ *  Line formats:
+ *    PI:<seq>      robot -> app ping
+ *    PR:<seq>      app -> robot reply (as soon as PI arrives)
+ *    PB:n=<sent> lost=<n> ms=<burst time> rate=<replies/s>
+ *********************************************************************/
+
+#ifndef LINK_PROBE_H
+#define LINK_PROBE_H
+
+#include "bluetooth_handler.h"
+#include "config.h"
+#include "memory_optimization.h"
+#include "perf_monitor.h"
+
+#define LINK_PROBE_WINDOW 8        // Pings in flight at once
+#define LINK_PROBE_TIMEOUT 2000    // ms before a ping counts as lost
+#define LINK_PROBE_MAX_BURST 1000  // Pings per PB command
+#define LINK_PROBE_FREE 0xFFFFFFFF // Window slot not in use
+
+class LinkProbe {
+private:
+  static unsigned long sentAt[LINK_PROBE_WINDOW]; // micros(), by seq
+  static uint16_t slotSeq[LINK_PROBE_WINDOW];     // Ping each slot holds
+  static uint16_t nextSeq;
+  static uint16_t toSend;
+  static uint16_t burstSent;
+  static uint16_t burstLost;
+  static uint16_t inFlight;
+  static unsigned long burstStart;
+  static unsigned long lastRtt;
+  static bool burstActive;
+
+  static void finishBurst();
+
+public:
+  // Queue a burst of count pings (replaces a running burst)
+  static void startBurst(uint16_t count);
+
+  // An app reply (PR:<seq>) arrived
+  static void onReply(uint16_t seq);
+
+  // Send pings as the window and TX queue allow, expire lost ones.
+  // Call every tick.
+  static void update();
+};
+
+// Static variable definitions
+unsigned long LinkProbe::sentAt[LINK_PROBE_WINDOW];
+uint16_t LinkProbe::slotSeq[LINK_PROBE_WINDOW];
+uint16_t LinkProbe::nextSeq = 0;
+uint16_t LinkProbe::toSend = 0;
+uint16_t LinkProbe::burstSent = 0;
+uint16_t LinkProbe::burstLost = 0;
+uint16_t LinkProbe::inFlight = 0;
+unsigned long LinkProbe::burstStart = 0;
+unsigned long LinkProbe::lastRtt = 0;
+bool LinkProbe::burstActive = false;
+
+// Implementation
+void LinkProbe::startBurst(uint16_t count) {
+  for (uint8_t i = 0; i < LINK_PROBE_WINDOW; i++) {
+    sentAt[i] = LINK_PROBE_FREE;
+  }
+  toSend = constrain(count, 1, LINK_PROBE_MAX_BURST);
+  burstSent = 0;
+  burstLost = 0;
+  inFlight = 0;
+  lastRtt = 0;
+  burstStart = millis();
+  burstActive = true;
+}
+
+void LinkProbe::onReply(uint16_t seq) {
+  // A reply to a ping already counted as lost may arrive after its slot
+  // was reused; only the ping the slot holds now counts
+  uint8_t slot = seq % LINK_PROBE_WINDOW;
+  if (!burstActive || sentAt[slot] == LINK_PROBE_FREE ||
+      slotSeq[slot] != seq)
+    return;
+
+  unsigned long rtt = micros() - sentAt[slot];
+  sentAt[slot] = LINK_PROBE_FREE;
+  inFlight--;
+
+  PerfMonitor::record(PROBE_LINK_RTT, rtt);
+  if (lastRtt != 0) {
+    PerfMonitor::record(PROBE_LINK_JITTER,
+                        rtt > lastRtt ? rtt - lastRtt : lastRtt - rtt);
+  }
+  lastRtt = rtt;
+}
+
+void LinkProbe::update() {
+  if (!burstActive)
+    return;
+
+  // Expire pings that never came back
+  unsigned long now = micros();
+  for (uint8_t i = 0; i < LINK_PROBE_WINDOW; i++) {
+    if (sentAt[i] != LINK_PROBE_FREE &&
+        now - sentAt[i] > LINK_PROBE_TIMEOUT * 1000UL) {
+      sentAt[i] = LINK_PROBE_FREE;
+      inFlight--;
+      burstLost++;
+    }
+  }
+
+  // Keep the window full; high priority so acks don't queue behind
+  // telemetry and skew the round trip
+  while (toSend > 0 && inFlight < LINK_PROBE_WINDOW) {
+    uint8_t slot = nextSeq % LINK_PROBE_WINDOW;
+    if (sentAt[slot] != LINK_PROBE_FREE)
+      break;
+
+    char line[12];
+    snprintf_P(line, sizeof(line), PSTR("PI:%u"), nextSeq);
+    if (BluetoothHandler::sendMessage(line, TX_PRIORITY_HIGH) != TX_QUEUED)
+      break; // Link busy - try next tick
+
+    sentAt[slot] = micros();
+    slotSeq[slot] = nextSeq;
+    nextSeq++;
+    toSend--;
+    inFlight++;
+    burstSent++;
+  }
+
+  if (toSend == 0 && inFlight == 0) {
+    finishBurst();
+  }
+}
+
+void LinkProbe::finishBurst() {
+  burstActive = false;
+
+  unsigned long elapsed = max(millis() - burstStart, 1UL);
+  uint16_t replies = burstSent - burstLost;
+  MessageHandle message;
+  if (message) {
+    message.printf_P(PSTR("PB:n=%u lost=%u ms=%lu rate=%lu/s"), burstSent,
+                     burstLost, elapsed, replies * 1000UL / elapsed);
+    BluetoothHandler::sendMessage(message.get(), TX_PRIORITY_HIGH);
+  }
+}
+
+#endif // LINK_PROBE_H
@@ -0,0 +1,498 @@
+/**********************************************************************
+ *  macro_engine.h - On-Board Command Macros
+ *  Named command sequences kept in EEPROM and played back by the robot
+ *  with their own timing, so a pick-and-place cycle is one command from
+ *  the app instead of a stream of them. Steps go through the command
+ *  queue like any other command; E, a collision stop or a step that
+ *  fails ends the run at once.
+ *
+ *  Slot layout (MACRO_SLOTS back to back):
+ *    [name x MACRO_NAME_LENGTH][step count][CRC-16 x2][MacroStep x n]
+ *  The CRC covers the name, the count and the recorded steps.
+ *
+ *  Recording never waits for the EEPROM: headers and steps are queued
+ *  and update() programs one byte per call, like ConfigStore. The header
+ *  that seals a recording goes last, once its steps are written.
+ *********************************************************************/
+
+#ifndef MACRO_ENGINE_H
+#define MACRO_ENGINE_H
+
+#include "bluetooth_handler.h"
+#include "config.h"
+#include "config_store.h"
+#include "memory_optimization.h"
+#include <EEPROM.h>
+
+#define MACRO_NO_SLOT 0xFF
+#define MACRO_WRITE_QUEUE 4 // Headers and steps waiting for the EEPROM
+
+struct MacroHeader {
+  char name[MACRO_NAME_LENGTH];
+  uint8_t stepCount; // Over MACRO_MAX_STEPS while being recorded
+  uint16_t crc;
+};
+
+// One header or step on its way to the EEPROM
+struct MacroWrite {
+  int address;
+  uint8_t length;
+  uint8_t data[sizeof(MacroHeader)];
+};
+
+static_assert(sizeof(MacroStep) <= sizeof(MacroHeader),
+              "A macro step doesn't fit a MacroWrite");
+
+#define MACRO_SLOT_SIZE                                                    \
+  (sizeof(MacroHeader) + MACRO_MAX_STEPS * sizeof(MacroStep))
+
+static_assert(CONFIG_STORE_ADDRESS + CONFIG_STORE_SLOTS * sizeof(ConfigRecord)
+                  <= MACRO_STORE_ADDRESS,
+              "Macro store overlaps the config slots");
+#if defined(E2END)
+static_assert(MACRO_STORE_ADDRESS + MACRO_SLOTS * MACRO_SLOT_SIZE <=
+                  E2END + 1,
+              "Macro store doesn't fit the EEPROM");
+#endif
+
+class MacroEngine {
+private:
+  // Recording
+  static uint8_t recordSlot;
+  static uint8_t recordCount;
+  static uint16_t recordDelay; // ms to wait before the next recorded step
+  static char recordName[MACRO_NAME_LENGTH];
+
+  // Queued EEPROM writes, and the recording waiting to be sealed
+  static MacroWrite writeQueue[MACRO_WRITE_QUEUE];
+  static uint8_t writeHead;
+  static uint8_t writeCount;
+  static uint8_t writePosition; // Next byte of the oldest write
+  static uint8_t sealSlot;
+  static uint8_t sealCount;
+  static bool sealQueued;
+
+  // Playback
+  static uint8_t runSlot;
+  static uint8_t runCount;
+  static uint8_t runStep; // Next step to queue
+  static unsigned long runStart;
+  static unsigned long nextStepAt;
+
+  static int headerAddress(uint8_t slot);
+  static int stepAddress(uint8_t slot, uint8_t step);
+  static void readBytes(int address, void *data, size_t length);
+  static bool queueWrite(int address, const void *data, uint8_t length);
+  static void serviceWrites();
+  static uint16_t slotCrc(uint8_t slot, const MacroHeader &header);
+  static bool readHeader(uint8_t slot, MacroHeader &header);
+  static uint8_t findSlot(const char *name);
+  static void copyName(char *name, const char *source);
+  static void endRun(const char *reason); // nullptr = completed
+
+public:
+  // Begin recording into the macro of that name (replacing it) or a free
+  // slot. Returns false if every slot holds another macro.
+  static bool startRecording(const char *name);
+  static bool isRecording();
+
+  // Motion, arm and power commands can be recorded; the rest still run
+  static bool isRecordable(uint8_t opcode);
+
+  // Store a step, after the waits added since the last one. False when
+  // the macro is full or too many writes are waiting (isFull() tells).
+  static bool recordStep(const Command &cmd);
+  static void addDelay(uint16_t ms);
+  static bool isFull();
+
+  // End the recording; returns its step count, -1 if not recording. It
+  // is sealed in the background and MACRO_SAVED:<name> sent when done.
+  static int finishRecording();
+
+  // EEPROM writes still pending; MREC, MRUN and MDEL wait for them
+  static bool isSaving();
+
+  // Start playing a macro; false if unknown or something else is running
+  static bool run(const char *name);
+  static bool isRunning();
+
+  // Stop playback now; reason goes into the MACRO_ABORT line
+  static void abort(PGM_P reason);
+
+  // A queued step has run; failed if its handler reported an error
+  static void onStepDone(const Command &cmd, bool failed);
+
+  static bool remove(const char *name);
+
+  // One MACRO: line per stored macro, then the engine state; cursor is
+  // the slot (REPORT source for MLIST)
+  static bool listLine(uint16_t &cursor, uint16_t argument, char *buffer,
+                       size_t bufferSize);
+
+  // Write one queued EEPROM byte and queue the next step when it is
+  // due. Call every tick.
+  static void update();
+};
+
+// Static variable definitions
+uint8_t MacroEngine::recordSlot = MACRO_NO_SLOT;
+uint8_t MacroEngine::recordCount = 0;
+uint16_t MacroEngine::recordDelay = 0;
+char MacroEngine::recordName[MACRO_NAME_LENGTH];
+MacroWrite MacroEngine::writeQueue[MACRO_WRITE_QUEUE];
+uint8_t MacroEngine::writeHead = 0;
+uint8_t MacroEngine::writeCount = 0;
+uint8_t MacroEngine::writePosition = 0;
+uint8_t MacroEngine::sealSlot = MACRO_NO_SLOT;
+uint8_t MacroEngine::sealCount = 0;
+bool MacroEngine::sealQueued = false;
+uint8_t MacroEngine::runSlot = MACRO_NO_SLOT;
+uint8_t MacroEngine::runCount = 0;
+uint8_t MacroEngine::runStep = 0;
+unsigned long MacroEngine::runStart = 0;
+unsigned long MacroEngine::nextStepAt = 0;
+
+// Implementation
+int MacroEngine::headerAddress(uint8_t slot) {
+  return MACRO_STORE_ADDRESS + slot * MACRO_SLOT_SIZE;
+}
+
+int MacroEngine::stepAddress(uint8_t slot, uint8_t step) {
+  return headerAddress(slot) + sizeof(MacroHeader) + step * sizeof(MacroStep);
+}
+
+void MacroEngine::readBytes(int address, void *data, size_t length) {
+  uint8_t *bytes = (uint8_t *)data;
+  for (size_t i = 0; i < length; i++) {
+    bytes[i] = EEPROM.read(address + i);
+  }
+}
+
+bool MacroEngine::queueWrite(int address, const void *data,
+                             uint8_t length) {
+  if (writeCount == MACRO_WRITE_QUEUE)
+    return false;
+
+  MacroWrite &write =
+      writeQueue[(writeHead + writeCount) % MACRO_WRITE_QUEUE];
+  write.address = address;
+  write.length = length;
+  memcpy(write.data, data, length);
+  writeCount++;
+  return true;
+}
+
+void MacroEngine::serviceWrites() {
+  if (writeCount == 0) {
+    if (sealSlot == MACRO_NO_SLOT)
+      return;
+
+    if (sealQueued) {
+      // The header is in: the macro is valid from here on
+      sealSlot = MACRO_NO_SLOT;
+      sealQueued = false;
+      MessageHandle message;
+      if (message) {
+        message.printf_P(PSTR("MACRO_SAVED:%s"), recordName);
+        BluetoothHandler::sendMessage(message.get(), TX_PRIORITY_HIGH);
+      }
+      return;
+    }
+
+    // Every step is written now, so the CRC can read them back. An
+    // empty recording leaves the slot invalid, which deletes the macro.
+    MacroHeader header;
+    copyName(header.name, recordName);
+    header.stepCount = sealCount;
+    header.crc = slotCrc(sealSlot, header);
+    sealQueued = queueWrite(headerAddress(sealSlot), &header, sizeof(header));
+    return;
+  }
+
+#if defined(__AVR__)
+  // A byte takes ~3.4ms to program; come back rather than wait
+  if (!eeprom_is_ready())
+    return;
+#endif
+  // update() skips bytes that already hold the value
+  MacroWrite &write = writeQueue[writeHead];
+  EEPROM.update(write.address + writePosition, write.data[writePosition]);
+  if (++writePosition == write.length) {
+    writePosition = 0;
+    writeHead = (writeHead + 1) % MACRO_WRITE_QUEUE;
+    writeCount--;
+  }
+}
+
+bool MacroEngine::isSaving() {
+  return writeCount > 0 || sealSlot != MACRO_NO_SLOT;
+}
+
+uint16_t MacroEngine::slotCrc(uint8_t slot, const MacroHeader &header) {
+  uint16_t crc = ConfigStore::crc16((const uint8_t *)&header,
+                                    offsetof(MacroHeader, crc));
+  for (uint8_t step = 0; step < header.stepCount; step++) {
+    MacroStep stored;
+    readBytes(stepAddress(slot, step), &stored, sizeof(stored));
+    crc = ConfigStore::crc16((const uint8_t *)&stored, sizeof(stored), crc);
+  }
+  return crc;
+}
+
+bool MacroEngine::readHeader(uint8_t slot, MacroHeader &header) {
+  readBytes(headerAddress(slot), &header, sizeof(header));
+  header.name[MACRO_NAME_LENGTH - 1] = '\0';
+
+  // Erased EEPROM and a recording cut short both fail here
+  return header.stepCount > 0 && header.stepCount <= MACRO_MAX_STEPS &&
+         header.crc == slotCrc(slot, header);
+}
+
+void MacroEngine::copyName(char *name, const char *source) {
+  strncpy(name, source, MACRO_NAME_LENGTH - 1);
+  name[MACRO_NAME_LENGTH - 1] = '\0';
+}
+
+uint8_t MacroEngine::findSlot(const char *name) {
+  char wanted[MACRO_NAME_LENGTH];
+  copyName(wanted, name);
+
+  MacroHeader header;
+  for (uint8_t slot = 0; slot < MACRO_SLOTS; slot++) {
+    if (readHeader(slot, header) && strcmp(header.name, wanted) == 0)
+      return slot;
+  }
+  return MACRO_NO_SLOT;
+}
+
+bool MacroEngine::startRecording(const char *name) {
+  if (name[0] == '\0' || isRunning() || isSaving())
+    return false;
+
+  uint8_t slot = findSlot(name);
+  if (slot == MACRO_NO_SLOT) {
+    MacroHeader header;
+    for (slot = 0; slot < MACRO_SLOTS; slot++) {
+      if (!readHeader(slot, header))
+        break;
+    }
+    if (slot == MACRO_SLOTS)
+      return false;
+  }
+
+  // Mark the slot as being written until finishRecording() seals it
+  MacroHeader header;
+  copyName(header.name, name);
+  header.stepCount = 0xFF;
+  header.crc = 0;
+  queueWrite(headerAddress(slot), &header, sizeof(header));
+
+  copyName(recordName, name);
+  recordSlot = slot;
+  recordCount = 0;
+  recordDelay = 0;
+  return true;
+}
+
+bool MacroEngine::isRecording() { return recordSlot != MACRO_NO_SLOT; }
+
+bool MacroEngine::isRecordable(uint8_t opcode) {
+  switch (opcode) {
+  case OP_FORWARD:
+  case OP_BACKWARD:
+  case OP_LEFT:
+  case OP_RIGHT:
+  case OP_TANK:
+  case OP_STOP:
+  case OP_ARM_HOME:
+  case OP_ARM_PRESET:
+  case OP_SERVO_MOVE:
+  case OP_GRIPPER_OPEN:
+  case OP_GRIPPER_CLOSE:
+  case OP_ARM_WAYPOINT:
+  case OP_SPEED:
+  case OP_SERVO_SPEED:
+  case OP_POWER_ON:
+  case OP_POWER_OFF:
+    return true;
+  default:
+    return false;
+  }
+}
+
+bool MacroEngine::recordStep(const Command &cmd) {
+  if (!isRecording() || recordCount >= MACRO_MAX_STEPS)
+    return false;
+
+  MacroStep step;
+  step.delayMs = recordDelay;
+  step.opcode = cmd.opcode;
+  step.value1 = cmd.value1;
+  step.value2 = cmd.value2;
+  if (!queueWrite(stepAddress(recordSlot, recordCount), &step, sizeof(step)))
+    return false; // Still writing earlier steps
+
+  recordCount++;
+  recordDelay = 0;
+  return true;
+}
+
+bool MacroEngine::isFull() { return recordCount >= MACRO_MAX_STEPS; }
+
+void MacroEngine::addDelay(uint16_t ms) {
+  recordDelay = min((unsigned long)recordDelay + ms, 0xFFFFUL);
+}
+
+int MacroEngine::finishRecording() {
+  if (!isRecording())
+    return -1;
+
+  // serviceWrites() seals the slot once the steps ahead of it are in
+  sealSlot = recordSlot;
+  sealCount = recordCount;
+  recordSlot = MACRO_NO_SLOT;
+  return recordCount;
+}
+
+bool MacroEngine::run(const char *name) {
+  if (isRunning() || isRecording() || isSaving())
+    return false;
+
+  uint8_t slot = findSlot(name);
+  MacroHeader header;
+  if (slot == MACRO_NO_SLOT || !readHeader(slot, header))
+    return false;
+
+  MacroStep first;
+  readBytes(stepAddress(slot, 0), &first, sizeof(first));
+
+  runSlot = slot;
+  runCount = header.stepCount;
+  runStep = 0;
+  runStart = millis();
+  nextStepAt = runStart + first.delayMs;
+  return true;
+}
+
+bool MacroEngine::isRunning() { return runSlot != MACRO_NO_SLOT; }
+
+void MacroEngine::endRun(const char *reason) {
+  MacroHeader header;
+  readBytes(headerAddress(runSlot), &header, sizeof(header));
+  header.name[MACRO_NAME_LENGTH - 1] = '\0';
+  unsigned long elapsed = millis() - runStart;
+  runSlot = MACRO_NO_SLOT;
+
+  // ms is the cycle time, from MRUN to the end of the last handler
+  MessageHandle message;
+  if (message) {
+    if (reason) {
+      message.printf_P(PSTR("MACRO_ABORT:%s,%u,%s ms=%lu"), header.name,
+                       runStep, reason, elapsed);
+    } else {
+      message.printf_P(PSTR("MACRO_DONE:%s ms=%lu"), header.name, elapsed);
+    }
+    BluetoothHandler::sendMessage(message.get(), TX_PRIORITY_HIGH);
+  }
+}
+
+void MacroEngine::abort(PGM_P reason) {
+  if (!isRunning())
+    return;
+
+  // Steps still in the command queue are skipped once the run is over
+  char text[12];
+  strncpy_P(text, reason, sizeof(text) - 1);
+  text[sizeof(text) - 1] = '\0';
+  endRun(text);
+}
+
+void MacroEngine::onStepDone(const Command &cmd, bool failed) {
+  if (!isRunning())
+    return;
+
+  if (failed) {
+    abort(PSTR("FAILED"));
+  } else if (cmd.batchItem == runCount) {
+    endRun(nullptr);
+  }
+}
+
+bool MacroEngine::remove(const char *name) {
+  if (isSaving())
+    return false;
+
+  uint8_t slot = findSlot(name);
+  if (slot == MACRO_NO_SLOT || slot == runSlot)
+    return false;
+
+  // A zero step count never validates
+  EEPROM.update(headerAddress(slot) + offsetof(MacroHeader, stepCount), 0);
+  return true;
+}
+
+bool MacroEngine::listLine(uint16_t &cursor, uint16_t argument,
+                           char *buffer, size_t bufferSize) {
+  MacroHeader header;
+  while (cursor < MACRO_SLOTS) {
+    uint8_t slot = cursor++;
+    if (readHeader(slot, header)) {
+      snprintf_P(buffer, bufferSize, PSTR("MACRO:%u %s steps=%u"), slot,
+                 header.name, header.stepCount);
+      return true;
+    }
+  }
+
+  // The state line follows the last slot
+  if (cursor++ > MACRO_SLOTS)
+    return false;
+
+  if (isRecording()) {
+    snprintf_P(buffer, bufferSize, PSTR("MACRO:RECORDING %s steps=%u"),
+               recordName, recordCount);
+  } else if (isSaving()) {
+    snprintf_P(buffer, bufferSize, PSTR("MACRO:SAVING %s"), recordName);
+  } else if (isRunning()) {
+    snprintf_P(buffer, bufferSize, PSTR("MACRO:RUNNING step=%u/%u"),
+               runStep, runCount);
+  } else {
+    snprintf_P(buffer, bufferSize, PSTR("MACRO:IDLE"));
+  }
+  return true;
+}
+
+void MacroEngine::update() {
+  serviceWrites();
+
+  if (!isRunning() || runStep >= runCount)
+    return;
+  if ((long)(millis() - nextStepAt) < 0)
+    return;
+
+  MacroStep step;
+  readBytes(stepAddress(runSlot, runStep), &step, sizeof(step));
+
+  Command cmd;
+  strcpy_P(cmd.type, PSTR("MACRO"));
+  cmd.parameter[0] = '\0';
+  cmd.opcode = step.opcode;
+  cmd.value1 = step.value1;
+  cmd.value2 = step.value2;
+  cmd.timestamp = millis();
+  cmd.batchSeq = BATCH_MACRO;
+  cmd.batchItem = runStep + 1;
+
+  extern bool addFrameCommandToQueue(const Command &cmd);
+  if (!addFrameCommandToQueue(cmd))
+    return; // Queue full - try again next tick
+
+  // Scheduled from the previous step's due time, so late dispatch of one
+  // step doesn't push back the rest of the cycle
+  if (++runStep < runCount) {
+    MacroStep next;
+    readBytes(stepAddress(runSlot, runStep), &next, sizeof(next));
+    nextStepAt += next.delayMs;
+  }
+}
+
+#endif // MACRO_ENGINE_H
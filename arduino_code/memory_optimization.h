@@ -12,7 +12,15 @@
 // Memory optimization settings
 #define MAX_MESSAGE_LENGTH 192 // Increased for JSON sensor status messages
 #define MAX_COMMAND_LENGTH 32
+#define MAX_LINE_LENGTH 64   // Input line; room for a command batch
 #define COMMAND_QUEUE_SIZE 5 // Reduced from 10
+#define COMMAND_QUEUE_COALESCE true // Latest setpoint replaces a pending one
+#define TX_HIGH_BUFFER_SIZE 192      // Acks, also those held during AT probing
+#define TX_TELEMETRY_BUFFER_SIZE 256 // Status and sensor telemetry
+#define LOG_BUFFER_SIZE 192          // Deferred debug log records
+#define MESSAGE_SMALL_LENGTH 64 // Acks, errors, events
+#define MESSAGE_SMALL_SLOTS 3
+#define MESSAGE_LARGE_SLOTS 2 // MAX_MESSAGE_LENGTH - status and telemetry
 
 // Flash string macros to save RAM
 #define F_READY PSTR("ROBOT_READY")
@@ -23,111 +31,314 @@
 #define F_EMERGENCY_STOP PSTR("EMERGENCY_STOP")
 #define F_EMERGENCY_CLEARED PSTR("EMERGENCY_STOP_CLEARED")
 
-// Optimized message buffer management
+#define MESSAGE_SLOT_COUNT (MESSAGE_SMALL_SLOTS + MESSAGE_LARGE_SLOTS)
+#define MESSAGE_NO_SLOT 0xFF
+
+static_assert(MESSAGE_SLOT_COUNT <= 8, "Message slot mask holds 8 slots");
+
+// Slab pool of message buffers - small slots for acks, large ones for
+// status and telemetry. Use through MessageHandle, never directly.
 class MessageBuffer {
 private:
-  static char buffer[MAX_MESSAGE_LENGTH];
-  static bool inUse;
+  static char smallSlots[MESSAGE_SMALL_SLOTS][MESSAGE_SMALL_LENGTH];
+  static char largeSlots[MESSAGE_LARGE_SLOTS][MAX_MESSAGE_LENGTH];
+  static uint8_t slotsInUse; // Bit per slot, small slots first
+  static uint8_t peakInUse;
+  static unsigned int failedAllocations;
+
+  static uint8_t claimSlot(uint8_t first, uint8_t count);
 
 public:
-  static char *getBuffer() {
-    if (!inUse) {
-      inUse = true;
-      memset(buffer, 0, MAX_MESSAGE_LENGTH);
-      return buffer;
-    }
-    return nullptr; // Buffer busy
-  }
+  // Smallest free slot that holds length bytes; MESSAGE_NO_SLOT if none
+  static uint8_t acquire(size_t length);
+  static void release(uint8_t slot);
+
+  static char *getSlot(uint8_t slot);
+  static size_t getSlotSize(uint8_t slot);
+
+  // Diagnostics
+  static uint8_t getSlotsInUse();
+  static uint8_t getPeakSlotsInUse();
+  static unsigned int getFailedAllocations();
+  static size_t getRamUsage(); // Static RAM of all slots
+};
 
-  static void releaseBuffer() { inUse = false; }
+// Scoped message buffer - the slot goes back to the pool on every return
+// path. Test it before use: the pool can be exhausted.
+class MessageHandle {
+private:
+  uint8_t slot;
+
+public:
+  explicit MessageHandle(size_t length = MESSAGE_SMALL_LENGTH)
+      : slot(MessageBuffer::acquire(length)) {}
+  ~MessageHandle() { MessageBuffer::release(slot); }
+
+  MessageHandle(const MessageHandle &) = delete;
+  MessageHandle &operator=(const MessageHandle &) = delete;
 
-  static bool isAvailable() { return !inUse; }
+  explicit operator bool() const { return slot != MESSAGE_NO_SLOT; }
+
+  char *get() const { return MessageBuffer::getSlot(slot); }
+  size_t size() const { return MessageBuffer::getSlotSize(slot); }
+
+  // Format into the buffer; returns the length written (truncated to fit)
+  int printf_P(PGM_P format, ...) {
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf_P(get(), size(), format, args);
+    va_end(args);
+    return min(length, (int)size() - 1);
+  }
 };
 
 // Static allocations
-char MessageBuffer::buffer[MAX_MESSAGE_LENGTH];
-bool MessageBuffer::inUse = false;
+char MessageBuffer::smallSlots[MESSAGE_SMALL_SLOTS][MESSAGE_SMALL_LENGTH];
+char MessageBuffer::largeSlots[MESSAGE_LARGE_SLOTS][MAX_MESSAGE_LENGTH];
+uint8_t MessageBuffer::slotsInUse = 0;
+uint8_t MessageBuffer::peakInUse = 0;
+unsigned int MessageBuffer::failedAllocations = 0;
+
+uint8_t MessageBuffer::claimSlot(uint8_t first, uint8_t count) {
+  for (uint8_t slot = first; slot < first + count; slot++) {
+    if (!(slotsInUse & (1 << slot))) {
+      slotsInUse |= 1 << slot;
+      uint8_t used = __builtin_popcount(slotsInUse);
+      if (used > peakInUse)
+        peakInUse = used;
+      return slot;
+    }
+  }
+  return MESSAGE_NO_SLOT;
+}
+
+uint8_t MessageBuffer::acquire(size_t length) {
+  uint8_t slot = MESSAGE_NO_SLOT;
+  if (length <= MESSAGE_SMALL_LENGTH) {
+    slot = claimSlot(0, MESSAGE_SMALL_SLOTS);
+  }
+  // Small requests spill into the large slots rather than fail
+  if (slot == MESSAGE_NO_SLOT && length <= MAX_MESSAGE_LENGTH) {
+    slot = claimSlot(MESSAGE_SMALL_SLOTS, MESSAGE_LARGE_SLOTS);
+  }
+
+  if (slot == MESSAGE_NO_SLOT) {
+    if (failedAllocations != 0xFFFF)
+      failedAllocations++;
+    return MESSAGE_NO_SLOT;
+  }
+
+  // Callers always write a terminated string, so only clear the first byte
+  getSlot(slot)[0] = '\0';
+  return slot;
+}
+
+void MessageBuffer::release(uint8_t slot) {
+  if (slot < MESSAGE_SLOT_COUNT)
+    slotsInUse &= ~(1 << slot);
+}
+
+char *MessageBuffer::getSlot(uint8_t slot) {
+  if (slot < MESSAGE_SMALL_SLOTS)
+    return smallSlots[slot];
+  if (slot < MESSAGE_SLOT_COUNT)
+    return largeSlots[slot - MESSAGE_SMALL_SLOTS];
+  return nullptr;
+}
+
+size_t MessageBuffer::getSlotSize(uint8_t slot) {
+  if (slot < MESSAGE_SMALL_SLOTS)
+    return MESSAGE_SMALL_LENGTH;
+  return slot < MESSAGE_SLOT_COUNT ? MAX_MESSAGE_LENGTH : 0;
+}
+
+uint8_t MessageBuffer::getSlotsInUse() {
+  return __builtin_popcount(slotsInUse);
+}
+
+uint8_t MessageBuffer::getPeakSlotsInUse() { return peakInUse; }
+
+unsigned int MessageBuffer::getFailedAllocations() {
+  return failedAllocations;
+}
+
+size_t MessageBuffer::getRamUsage() {
+  return sizeof(smallSlots) + sizeof(largeSlots);
+}
 
 // Optimized string formatting functions
-inline void formatFloat(float value, char *buffer, size_t bufferSize,
-                        int decimals = 1) {
-  dtostrf(value, 0, decimals, buffer);
+// Millimetres as centimetres with one decimal ("12.3") - no float maths
+inline void formatDistance(uint16_t distanceMm, char *buffer,
+                           size_t bufferSize) {
+  snprintf_P(buffer, bufferSize, PSTR("%u.%u"), distanceMm / 10,
+             distanceMm % 10);
 }
 
 inline void formatInt(int value, char *buffer, size_t bufferSize) {
   itoa(value, buffer, 10);
 }
 
-inline void formatCollisionMessage(const char *sensor, float distance,
+inline void formatCollisionMessage(const char *sensor, uint16_t distanceMm,
                                    char *buffer, size_t bufferSize) {
   char distStr[8];
-  formatFloat(distance, distStr, sizeof(distStr), 1);
+  formatDistance(distanceMm, distStr, sizeof(distStr));
   snprintf_P(buffer, bufferSize, PSTR("COLLISION_WARNING:%s:%s"), sensor,
              distStr);
 }
 
-inline void formatSensorStatus(float front, float rear, char *buffer,
-                               size_t bufferSize) {
+inline void formatSensorStatus(uint16_t frontMm, uint16_t rearMm,
+                               char *buffer, size_t bufferSize) {
   char frontStr[8], rearStr[8];
-  formatFloat(front, frontStr, sizeof(frontStr), 1);
-  formatFloat(rear, rearStr, sizeof(rearStr), 1);
+  formatDistance(frontMm, frontStr, sizeof(frontStr));
+  formatDistance(rearMm, rearStr, sizeof(rearStr));
   snprintf_P(buffer, bufferSize, PSTR("SENSOR:%s:%s"), frontStr, rearStr);
 }
 
 // Memory monitoring
+#define STACK_CANARY 0xC5 // Fill value for RAM the stack has never reached
+
+#if defined(__AVR__)
+extern char __data_start; // First byte of .data (start of static RAM)
+extern char __heap_start; // End of static RAM (.bss, then .noinit)
+extern char __stack;      // Top of RAM (RAMEND)
+
+// Paint every byte between the statics and the stack with the canary. Runs
+// from .init3, before .data/.bss are set up or main() is called, so nothing
+// above the statics is in use yet; naked because there is no frame to return
+// through. The statics end after .noinit, which has to survive a reset.
+void paintStack() __attribute__((naked, used, section(".init3")));
+void paintStack() {
+  for (char *p = &__heap_start; p <= &__stack; p++) {
+    *p = STACK_CANARY;
+  }
+}
+#endif
+
 class MemoryMonitor {
 private:
-  static int lastFreeMemory;
+  static int lastFreeMemory; // Lowest free RAM reported so far
+  static int repaintedLow;   // Low-water mark before the last repaint
   static unsigned long lastCheck;
   static const int LOW_MEMORY_THRESHOLD = 400;
   static const int CRITICAL_MEMORY_THRESHOLD = 200;
 
 public:
   static void init() {
-    lastFreeMemory = getFreeMemory();
-    
+    lastFreeMemory = INT16_MAX; // Nothing reported yet
     lastCheck = millis();
   }
 
   static int getFreeMemory() {
     char top;
     extern char *__brkval;
-    extern char __bss_end;
-    return __brkval ? &top - __brkval : &top - &__bss_end;
+    extern char __heap_start;
+    return __brkval ? &top - __brkval : &top - &__heap_start;
   }
 
+  // Canary bytes above the heap that the stack has not overwritten since
+  // boot or the last repaintFreeMemory(). Scans the free region, so call
+  // it from status reports, not hot paths.
+  static int getUntouchedMemory() {
+#if defined(__AVR__)
+    extern char *__brkval;
+    const char *p = __brkval ? __brkval : &__heap_start;
+    int untouched = 0;
+    while (p <= &__stack && (uint8_t)*p == STACK_CANARY) {
+      p++;
+      untouched++;
+    }
+    return untouched;
+#else
+    return getFreeMemory();
+#endif
+  }
+
+  // Smallest free RAM there has ever been between the heap and the stack
+  static int getMinimumFreeMemory() {
+    return min(getUntouchedMemory(), repaintedLow);
+  }
+
+  // Restore the canary below the caller's frame, so getUntouchedMemory()
+  // measures only the stack used from here on (e.g. by one benchmark).
+  // The lifetime low-water mark is kept.
+  static void repaintFreeMemory() {
+#if defined(__AVR__)
+    repaintedLow = getMinimumFreeMemory();
+    extern char *__brkval;
+    char top;
+    char *p = __brkval ? __brkval : &__heap_start;
+    char *end = &top - 32; // Stay clear of this frame and the call above
+    while (p < end) {
+      *p++ = STACK_CANARY;
+    }
+#endif
+  }
+
+  // Deepest the stack has grown since reset (bytes)
+  static int getStackPeak() {
+#if defined(__AVR__)
+    return getStackAvailable() - getHeapUsed() - getMinimumFreeMemory();
+#else
+    return 0;
+#endif
+  }
+
+  // RAM between the statics and the top of RAM, shared by heap and stack
+  static int getStackAvailable() {
+#if defined(__AVR__)
+    return &__stack - &__heap_start + 1;
+#else
+    return 0;
+#endif
+  }
+
+  // .data + .bss: every global and static the firmware declares
+  static int getStaticRamUsed() {
+#if defined(__AVR__)
+    return &__heap_start - &__data_start;
+#else
+    return 0;
+#endif
+  }
+
+  // Warns when free RAM reaches a new low. Uses the stack high-water mark,
+  // so a deep call that has already returned is still caught.
   static bool checkMemory() {
     unsigned long now = millis();
     if (now - lastCheck > 5000) { // Check every 5 seconds
-      int currentMemory = getFreeMemory();
+      int lowestMemory = getMinimumFreeMemory();
+      bool newLow = lowestMemory < lastFreeMemory;
+      if (newLow)
+        lastFreeMemory = lowestMemory;
+      lastCheck = now;
 
-      if (currentMemory < CRITICAL_MEMORY_THRESHOLD) {
-        Serial.print(F("🚨 CRITICAL: Memory "));
-        Serial.print(currentMemory);
-        Serial.println(F(" bytes"));
+      if (lowestMemory < CRITICAL_MEMORY_THRESHOLD) {
+        if (newLow) {
+          Serial.print(F("🚨 CRITICAL: Memory "));
+          Serial.print(lowestMemory);
+          Serial.println(F(" bytes"));
+        }
         return false; // Critical
-      } else if (currentMemory < LOW_MEMORY_THRESHOLD) {
+      } else if (lowestMemory < LOW_MEMORY_THRESHOLD && newLow) {
         Serial.print(F("⚠ WARNING: Low memory:  "));
-        Serial.print(currentMemory);
+        Serial.print(lowestMemory);
         Serial.println(F(" bytes"));
       }
-
-      lastFreeMemory = currentMemory;
-      lastCheck = now;
     }
     return true; // OK
   }
 
-  static void forceGarbageCollection() {
-    // Force string cleanup by creating and destroying a small string
-    String temp = "";
-    temp.reserve(1);
-    temp = "";
+  // Bytes handed out by malloc so far; stays 0 while nothing allocates
+  static int getHeapUsed() {
+    extern char *__brkval;
+    extern char *__malloc_heap_start;
+    return __brkval ? __brkval - __malloc_heap_start : 0;
   }
 };
 
 // Static initializations
 int MemoryMonitor::lastFreeMemory = 0;
+int MemoryMonitor::repaintedLow = INT16_MAX;
 unsigned long MemoryMonitor::lastCheck = 0;
 
 // Optimized debug macros using less memory
@@ -146,30 +357,156 @@ unsigned long MemoryMonitor::lastCheck = 0;
 #define DEBUG_PRINT_VAL(name, val)
 #endif
 
-// Stack-based temporary string for one-time use
-template <size_t SIZE> class TempString {
+// Bounded string builder over caller-owned storage (stack array, pool slot
+// or static buffer) - never touches the heap. Text that does not fit is
+// cut off, always terminated, and flagged by isTruncated().
+class StringBuilder {
 private:
-  char buffer[SIZE];
+  char *buffer;
+  size_t capacity;
+  size_t length;
+  bool truncated;
+
+  void advance(int written) {
+    if (written < 0)
+      return;
+    if ((size_t)written >= capacity - length) {
+      length = capacity - 1;
+      truncated = true;
+    } else {
+      length += written;
+    }
+  }
 
 public:
-  TempString() { buffer[0] = '\0'; }
+  StringBuilder(char *storage, size_t size)
+      : buffer(storage), capacity(size), length(0), truncated(false) {
+    buffer[0] = '\0';
+  }
 
-  char *get() { return buffer; }
-  size_t size() const { return SIZE; }
+  StringBuilder(const StringBuilder &) = delete;
+  StringBuilder &operator=(const StringBuilder &) = delete;
+
+  void clear() {
+    length = 0;
+    truncated = false;
+    buffer[0] = '\0';
+  }
+
+  StringBuilder &append(const char *text) {
+    while (*text != '\0') {
+      if (length >= capacity - 1) {
+        truncated = true;
+        break;
+      }
+      buffer[length++] = *text++;
+    }
+    buffer[length] = '\0';
+    return *this;
+  }
+
+  // Append a flash string (PSTR / F_* constants)
+  StringBuilder &append_P(PGM_P text) {
+    char c;
+    while ((c = pgm_read_byte(text++)) != '\0') {
+      if (length >= capacity - 1) {
+        truncated = true;
+        break;
+      }
+      buffer[length++] = c;
+    }
+    buffer[length] = '\0';
+    return *this;
+  }
+
+  StringBuilder &append(long value) {
+    appendf_P(PSTR("%ld"), value);
+    return *this;
+  }
+
+  StringBuilder &appendf_P(PGM_P format, ...) {
+    va_list args;
+    va_start(args, format);
+    vappendf_P(format, args);
+    va_end(args);
+    return *this;
+  }
 
+  // For forwarding a caller's variadic arguments
+  StringBuilder &vappendf_P(PGM_P format, va_list args) {
+    advance(vsnprintf_P(buffer + length, capacity - length, format, args));
+    return *this;
+  }
+
+  // Replace the contents
   void printf(const char *format, ...) {
     va_list args;
     va_start(args, format);
-    vsnprintf(buffer, SIZE, format, args);
+    clear();
+    advance(vsnprintf(buffer, capacity, format, args));
     va_end(args);
   }
 
   void printf_P(PGM_P format, ...) {
     va_list args;
     va_start(args, format);
-    vsnprintf_P(buffer, SIZE, format, args);
+    clear();
+    advance(vsnprintf_P(buffer, capacity, format, args));
     va_end(args);
   }
+
+  char *get() { return buffer; }
+  const char *c_str() const { return buffer; }
+  size_t size() const { return capacity; }
+  size_t getLength() const { return length; }
+  bool isTruncated() const { return truncated; }
+};
+
+// Stack-based temporary string for one-time use
+template <size_t SIZE> class TempString : public StringBuilder {
+private:
+  char storage[SIZE];
+
+public:
+  TempString() : StringBuilder(storage, SIZE) {}
+};
+
+// Fixed-size byte FIFO; writes are all-or-nothing so queued messages are
+// never truncated. Not interrupt-safe - use from the main loop only.
+template <uint16_t SIZE> class RingBuffer {
+private:
+  uint8_t buffer[SIZE];
+  uint16_t head;
+  uint16_t tail;
+  uint16_t count;
+
+public:
+  RingBuffer() : head(0), tail(0), count(0) {}
+
+  uint16_t available() const { return count; }
+  uint16_t freeSpace() const { return SIZE - count; }
+  bool isEmpty() const { return count == 0; }
+
+  bool write(const uint8_t *data, uint16_t length) {
+    if (length > freeSpace())
+      return false;
+
+    for (uint16_t i = 0; i < length; i++) {
+      buffer[head] = data[i];
+      head = (head + 1) % SIZE;
+    }
+    count += length;
+    return true;
+  }
+
+  uint8_t read() {
+    uint8_t value = buffer[tail];
+    tail = (tail + 1) % SIZE;
+    count--;
+    return value;
+  }
+
+  void clear() { head = tail = count = 0; }
 };
 
 #endif // MEMORY_OPTIMIZATION_H 
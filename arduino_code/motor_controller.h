@@ -7,6 +7,8 @@
 #define MOTOR_CONTROLLER_H
 
 #include "config.h"
+#include "debug_log.h"
+#include "motor_io.h"
 #include "utils.h"
 
 class MotorController {
@@ -14,13 +16,17 @@ private:
   static MotorState motors[4];
   static int globalSpeedMultiplier;
   static unsigned long lastCommandTime;
+  static unsigned long lastRampUpdate;
   static bool safetyStopActive;
+  static int8_t forwardLimit;  // Max forward travel output (%)
+  static int8_t backwardLimit; // Max backward travel output (%)
 
   // Private helper methods
   static void setIndividualMotorSpeed(int motorIndex, int speed);
-  static void getMotorPins(int motorIndex, int &d0Pin, int &d1Pin,
-                           int &enablePin);
-  static void updateMotorHardware(int motorIndex);
+  static void updateOutputs();
+  static void updateRamp(int motorIndex, unsigned long elapsedUs);
+  static int limitedSpeed(int motorIndex);
+  static void runFor(unsigned long duration);
 
 public:
   // Initialize motor controller
@@ -47,10 +53,20 @@ public:
   static int getGlobalSpeed();
 
   // Status and diagnostics
-  static void getStatus(String &statusString);
   static void getStatus(char *buffer, size_t bufferSize);
+
+  // Static RAM of the per-motor state
+  static size_t getRamUsage();
   static bool isAnyMotorRunning();
   static int getMotorSpeed(int motorIndex);
+  static int getOutputSpeed(int motorIndex);
+
+  // Ground travel being driven (% output, positive = forward)
+  static int getTravelSpeed();
+
+  // Cap forward/backward travel (% output) without changing the command.
+  // Outputs ramp down to a lowered cap; 100 removes it.
+  static void setTravelLimits(int forward, int backward);
 
   // Safety functions
   static void enableSafetyStop();
@@ -65,38 +81,36 @@ public:
 
 // Implementation
 MotorState MotorController::motors[4] = {
-    {0, false, 0}, // Front Left
-    {0, false, 0}, // Rear Left
-    {0, false, 0}, // Front Right
-    {0, false, 0}  // Rear Right
+    {0, false, 0, 0, 0, 0}, // Front Left
+    {0, false, 0, 0, 0, 0}, // Rear Left
+    {0, false, 0, 0, 0, 0}, // Front Right
+    {0, false, 0, 0, 0, 0}  // Rear Right
 };
 
+// Wheel direction that drives the robot forward, indexed by motor
+const int8_t MOTOR_FORWARD_DIR[4] = {FRONT_LEFT_DIR, REAR_LEFT_DIR,
+                                     FRONT_RIGHT_DIR, REAR_RIGHT_DIR};
+
+// One percent of speed in ramp fixed point, and the microseconds it takes
+// to move one fixed-point step at 1%/s
+#define MOTOR_RAMP_ONE 256
+#define MOTOR_RAMP_US_PER_STEP (1000000UL / MOTOR_RAMP_ONE)
+#define MOTOR_RAMP_MAX_ELAPSED_US 100000UL // Cap after a stalled loop
+
 int MotorController::globalSpeedMultiplier = 60;
 unsigned long MotorController::lastCommandTime = 0;
+unsigned long MotorController::lastRampUpdate = 0;
 bool MotorController::safetyStopActive = false;
+int8_t MotorController::forwardLimit = 100;
+int8_t MotorController::backwardLimit = 100;
 
 void MotorController::init() {
   DEBUG_PRINTLN("🚗 Initializing Motor Controller...");
 
-  // Initialize all motor pins
-  pinMode(DRIVER1_D0, OUTPUT);
-  pinMode(DRIVER1_D1, OUTPUT);
-  pinMode(DRIVER1_D2, OUTPUT);
-  pinMode(DRIVER1_D3, OUTPUT);
-
-  pinMode(DRIVER2_D0, OUTPUT);
-  pinMode(DRIVER2_D1, OUTPUT);
-  pinMode(DRIVER2_D2, OUTPUT);
-  pinMode(DRIVER2_D3, OUTPUT);
-
-  // Initialize PWM enable pins
-  pinMode(DRIVER1_EN1, OUTPUT);
-  pinMode(DRIVER1_EN2, OUTPUT);
-  pinMode(DRIVER2_EN1, OUTPUT);
-  pinMode(DRIVER2_EN2, OUTPUT);
-
-  // Stop all motors initially
+  // Initialize all motor pins with the motors stopped
+  MotorIO::init();
   stopAll();
+  lastRampUpdate = micros();
 
   // Reset timers
   lastCommandTime = millis();
@@ -106,22 +120,105 @@ void MotorController::init() {
   DEBUG_PRINTLN("   Driver 1 (Left): D0=22, D1=23, D2=24, D3=25");
   DEBUG_PRINTLN("   Driver 2 (Right): D0=26, D1=27, D2=28, D3=29");
   DEBUG_PRINTLN("   PWM Enable: EN1=2, EN2=3, EN3=4, EN4=5");
+  DEBUG_PRINTLN(MOTOR_IO_REGISTERS ? "   Output: PORTA + timer OCR registers"
+                                   : "   Output: digitalWrite/analogWrite");
 }
 
 void MotorController::update() {
   // Check for safety timeout
   if (millis() - lastCommandTime > COMMAND_TIMEOUT && lastCommandTime != 0) {
     if (!safetyStopActive) {
-      DEBUG_PRINTLN("⚠ Motor safety timeout - stopping all motors");
+      LOG_WARN(MOTOR, LOG_MSG_MOTOR_TIMEOUT);
       stopAll();
       safetyStopActive = true;
     }
   }
 
-  // Update motor states
+  // Advance the motion ramps; hardware is only touched on output changes
+  unsigned long now = micros();
+  unsigned long elapsed = now - lastRampUpdate;
+  lastRampUpdate = now;
+  if (elapsed > MOTOR_RAMP_MAX_ELAPSED_US) {
+    elapsed = MOTOR_RAMP_MAX_ELAPSED_US;
+  }
+
   for (int i = 0; i < 4; i++) {
-    motors[i].lastUpdate = millis();
+    updateRamp(i, elapsed);
   }
+  updateOutputs();
+}
+
+void MotorController::updateRamp(int motorIndex, unsigned long elapsedUs) {
+  MotorState &motor = motors[motorIndex];
+  int16_t target = limitedSpeed(motorIndex) * MOTOR_RAMP_ONE;
+  int16_t position = motor.rampPosition;
+
+#if MOTOR_RAMP_ENABLED
+  if (position == target) {
+    motor.rampRate = 0;
+    return;
+  }
+
+  // Moving away from zero is acceleration; anything toward zero is braking
+  bool accelerating = (position >= 0 && target > position) ||
+                      (position <= 0 && target < position);
+  uint16_t rate = accelerating ? MOTOR_ACCEL_RATE : MOTOR_DECEL_RATE;
+
+#if MOTOR_SCURVE_ENABLED
+  // Build the slew rate up gradually, then ease into the target
+  uint32_t growth = (uint32_t)MOTOR_JERK_RATE * elapsedUs / 1000000UL;
+  uint32_t eased = motor.rampRate + growth + 1;
+  uint32_t landing = (uint32_t)abs(target - position) / MOTOR_RAMP_ONE *
+                     MOTOR_SCURVE_LANDING;
+  if (eased < rate)
+    rate = eased;
+  if (landing < rate)
+    rate = max(landing, (uint32_t)MOTOR_SCURVE_MIN_RATE);
+  motor.rampRate = rate;
+#endif
+
+  int32_t step = (uint32_t)rate * elapsedUs / MOTOR_RAMP_US_PER_STEP;
+  if (step < 1)
+    step = 1;
+
+  int32_t delta = (int32_t)target - position;
+  int32_t next;
+  if (abs(delta) <= step) {
+    next = target;
+  } else {
+    next = position + (delta > 0 ? step : -step);
+  }
+
+  // Reversing: come to rest first, then accelerate the other way
+  if ((position > 0 && next < 0) || (position < 0 && next > 0)) {
+    next = 0;
+  }
+  motor.rampPosition = next;
+#else
+  motor.rampPosition = target;
+#endif
+}
+
+int MotorController::limitedSpeed(int motorIndex) {
+  // Work in travel terms so one limit covers wheels mounted either way
+  int8_t direction = MOTOR_FORWARD_DIR[motorIndex];
+  int travel = motors[motorIndex].currentSpeed * direction;
+  travel = constrain(travel, -backwardLimit, forwardLimit);
+  return travel * direction;
+}
+
+void MotorController::setTravelLimits(int forward, int backward) {
+  forwardLimit = constrain(forward, 0, 100);
+  backwardLimit = constrain(backward, 0, 100);
+}
+
+int MotorController::getTravelSpeed() {
+  // Turning wheels cancel out, leaving the straight-line component
+  int total = 0;
+  for (int i = 0; i < 4; i++) {
+    total += motors[i].outputSpeed * MOTOR_FORWARD_DIR[i];
+  }
+  return total / 4;
 }
 
 void MotorController::moveForward(int speed) {
@@ -130,13 +227,11 @@ void MotorController::moveForward(int speed) {
   // Check collision avoidance if enabled
   extern bool checkCollisionSafety(bool movingForward);
   if (!checkCollisionSafety(true)) {
-    DEBUG_PRINTLN("⚠ Forward movement blocked by collision avoidance");
+    LOG_WARN(MOTOR, LOG_MSG_FORWARD_BLOCKED);
     return;
   }
 
-  if (DEBUG_MOTOR) {
-    DEBUG_PRINTLN("⬆ Moving forward at " + String(speed) + "%");
-  }
+  LOG_INFO(MOTOR, LOG_MSG_MOVE_FORWARD, speed);
 
   setIndividualMotorSpeed(FRONT_LEFT, speed * FRONT_LEFT_DIR);
   setIndividualMotorSpeed(REAR_LEFT, speed * REAR_LEFT_DIR);
@@ -152,13 +247,11 @@ void MotorController::moveBackward(int speed) {
   // Check collision avoidance if enabled
   extern bool checkCollisionSafety(bool movingForward);
   if (!checkCollisionSafety(false)) {
-    DEBUG_PRINTLN("⚠ Backward movement blocked by collision avoidance");
+    LOG_WARN(MOTOR, LOG_MSG_BACKWARD_BLOCKED);
     return;
   }
 
-  if (DEBUG_MOTOR) {
-    DEBUG_PRINTLN("⬇ Moving backward at " + String(speed) + "%");
-  }
+  LOG_INFO(MOTOR, LOG_MSG_MOVE_BACKWARD, speed);
 
   setIndividualMotorSpeed(FRONT_LEFT, -speed * FRONT_LEFT_DIR);
   setIndividualMotorSpeed(REAR_LEFT, -speed * REAR_LEFT_DIR);
@@ -171,9 +264,7 @@ void MotorController::moveBackward(int speed) {
 void MotorController::turnLeft(int speed) {
   speed = CONSTRAIN_SPEED(speed);
 
-  if (DEBUG_MOTOR) {
-    DEBUG_PRINTLN("⬅ Turning left at " + String(speed) + "%");
-  }
+  LOG_INFO(MOTOR, LOG_MSG_TURN_LEFT, speed);
 
   setIndividualMotorSpeed(FRONT_LEFT, -speed * FRONT_LEFT_DIR);
   setIndividualMotorSpeed(REAR_LEFT, -speed * REAR_LEFT_DIR);
@@ -186,9 +277,7 @@ void MotorController::turnLeft(int speed) {
 void MotorController::turnRight(int speed) {
   speed = CONSTRAIN_SPEED(speed);
 
-  if (DEBUG_MOTOR) {
-    DEBUG_PRINTLN("➡ Turning right at " + String(speed) + "%");
-  }
+  LOG_INFO(MOTOR, LOG_MSG_TURN_RIGHT, speed);
 
   setIndividualMotorSpeed(FRONT_LEFT, speed * FRONT_LEFT_DIR);
   setIndividualMotorSpeed(REAR_LEFT, speed * REAR_LEFT_DIR);
@@ -202,10 +291,7 @@ void MotorController::tankDrive(int leftSpeed, int rightSpeed) {
   leftSpeed = CONSTRAIN_SPEED(leftSpeed);
   rightSpeed = CONSTRAIN_SPEED(rightSpeed);
 
-  if (DEBUG_MOTOR) {
-    DEBUG_PRINTLN("🎮 Tank drive - Left: " + String(leftSpeed) +
-                  "%, Right: " + String(rightSpeed) + "%");
-  }
+  LOG_INFO(MOTOR, LOG_MSG_TANK_DRIVE, leftSpeed, rightSpeed);
 
   setIndividualMotorSpeed(FRONT_LEFT, leftSpeed * FRONT_LEFT_DIR);
   setIndividualMotorSpeed(REAR_LEFT, leftSpeed * REAR_LEFT_DIR);
@@ -236,79 +322,49 @@ void MotorController::setIndividualMotorSpeed(int motorIndex, int speed) {
         (adjustedSpeed > 0) ? MIN_SPEED_THRESHOLD : -MIN_SPEED_THRESHOLD;
   }
 
-  // Update motor state
+  // Update motor state; update() ramps the output toward it
   motors[motorIndex].currentSpeed = adjustedSpeed;
   motors[motorIndex].isRunning = (adjustedSpeed != 0);
-  motors[motorIndex].lastUpdate = millis();
-
-  // Update hardware
-  updateMotorHardware(motorIndex);
 }
 
-void MotorController::updateMotorHardware(int motorIndex) {
-  int d0Pin, d1Pin, enablePin;
-  getMotorPins(motorIndex, d0Pin, d1Pin, enablePin);
+void MotorController::updateOutputs() {
+  int8_t speeds[4];
+  int8_t directions[4];
+  bool directionChanged = false;
 
-  int speed = motors[motorIndex].currentSpeed;
+  for (int i = 0; i < 4; i++) {
+    // Round the ramp position to a whole percent
+    int16_t position = motors[i].rampPosition;
+    int speed = (position >= 0) ? position + MOTOR_RAMP_ONE / 2
+                                : position - MOTOR_RAMP_ONE / 2;
+    speeds[i] = speed / MOTOR_RAMP_ONE;
+
+    int previous = motors[i].outputSpeed;
+    directions[i] = (speeds[i] > 0) - (speeds[i] < 0);
+    if (directions[i] != (previous > 0) - (previous < 0)) {
+      directionChanged = true;
+    }
+  }
 
-  if (speed == 0) {
-    // Stop motor
-    digitalWrite(d0Pin, LOW);
-    digitalWrite(d1Pin, LOW);
-    analogWrite(enablePin, 0);
-    return;
+  // Latch every direction change together (both LOW = stopped)
+  if (directionChanged) {
+    MotorIO::setDirections(directions);
   }
 
-  // Calculate PWM value
-  int pwmValue = MAP_SPEED_TO_PWM(speed);
+  for (int i = 0; i < 4; i++) {
+    int previous = motors[i].outputSpeed;
+    if (speeds[i] == previous)
+      continue;
 
-  // Set direction
-  if (speed > 0) {
-    digitalWrite(d0Pin, HIGH);
-    digitalWrite(d1Pin, LOW);
-  } else {
-    digitalWrite(d0Pin, LOW);
-    digitalWrite(d1Pin, HIGH);
-  }
+    motors[i].outputSpeed = speeds[i];
+    motors[i].lastUpdate = millis();
 
-  // Set PWM speed
-  analogWrite(enablePin, pwmValue);
-
-  if (DEBUG_MOTOR) {
-    DEBUG_PRINT_P("🔧 Motor ");
-    DEBUG_PRINT(getMotorName(motorIndex));
-    DEBUG_PRINT_P(": ");
-    DEBUG_PRINT(speed);
-    DEBUG_PRINT_P("% -> PWM:");
-    DEBUG_PRINT(pwmValue);
-    DEBUG_PRINT_P(", DIR:");
-    DEBUG_PRINTLN(speed > 0 ? "FWD" : "REV");
-  }
-}
+    uint8_t pwmValue = MAP_SPEED_TO_PWM(speeds[i]);
+    if (pwmValue != MAP_SPEED_TO_PWM(previous)) {
+      MotorIO::setDuty(i, pwmValue);
+    }
 
-void MotorController::getMotorPins(int motorIndex, int &d0Pin, int &d1Pin,
-                                   int &enablePin) {
-  switch (motorIndex) {
-  case FRONT_LEFT:
-    d0Pin = DRIVER1_D0;
-    d1Pin = DRIVER1_D1;
-    enablePin = DRIVER1_EN1;
-    break;
-  case REAR_LEFT:
-    d0Pin = DRIVER1_D2;
-    d1Pin = DRIVER1_D3;
-    enablePin = DRIVER1_EN2;
-    break;
-  case FRONT_RIGHT:
-    d0Pin = DRIVER2_D0;
-    d1Pin = DRIVER2_D1;
-    enablePin = DRIVER2_EN1;
-    break;
-  case REAR_RIGHT:
-    d0Pin = DRIVER2_D2;
-    d1Pin = DRIVER2_D3;
-    enablePin = DRIVER2_EN2;
-    break;
+    LOG_DEBUG(MOTOR, LOG_MSG_MOTOR_OUTPUT, i, speeds[i], pwmValue);
   }
 }
 
@@ -318,21 +374,25 @@ void MotorController::stopAll() {
   }
   safetyStopActive = false;
 
-  if (DEBUG_MOTOR) {
-    DEBUG_PRINTLN("⏹ All motors stopped");
-  }
+  LOG_DEBUG(MOTOR, LOG_MSG_MOTORS_STOPPED);
 }
 
 void MotorController::emergencyStop() {
-  DEBUG_PRINTLN("🚨 EMERGENCY STOP ACTIVATED");
+  LOG_ERROR(MOTOR, LOG_MSG_EMERGENCY_STOP);
   stopAll();
+
+  // No deceleration ramp for an emergency - cut the outputs now
+  for (int i = 0; i < 4; i++) {
+    motors[i].rampPosition = 0;
+    motors[i].rampRate = 0;
+  }
+  updateOutputs();
   safetyStopActive = true;
 }
 
 void MotorController::setGlobalSpeed(int speed) {
   globalSpeedMultiplier = constrain(speed, 20, 100);
-  DEBUG_PRINTLN("🚀 Global speed set to: " + String(globalSpeedMultiplier) +
-                "%");
+  LOG_INFO(MOTOR, LOG_MSG_GLOBAL_SPEED, globalSpeedMultiplier);
 }
 
 int MotorController::getGlobalSpeed() { return globalSpeedMultiplier; }
@@ -353,9 +413,9 @@ void MotorController::testMotor(int motorIndex, int speed, int duration) {
   DEBUG_PRINT_P("%");
 
   setIndividualMotorSpeed(motorIndex, speed);
-  delay(duration);
+  runFor(duration);
   setIndividualMotorSpeed(motorIndex, 0);
-  delay(500);
+  runFor(500);
 
   DEBUG_PRINTLN_P(" - Complete");
 }
@@ -384,23 +444,29 @@ bool MotorController::isAnyMotorRunning() {
   return false;
 }
 
-int MotorController::getMotorSpeed(int motorIndex) {
+int MotorController::getOutputSpeed(int motorIndex) {
   if (motorIndex >= 0 && motorIndex < 4) {
-    return motors[motorIndex].currentSpeed;
+    return motors[motorIndex].outputSpeed;
   }
   return 0;
 }
 
-void MotorController::getStatus(String &statusString) {
-  statusString = "Motors: ";
-  for (int i = 0; i < 4; i++) {
-    statusString +=
-        String(getMotorName(i)) + ":" + String(motors[i].currentSpeed) + "%";
-    if (i < 3)
-      statusString += ", ";
+// Blocking wait for the test routines that keeps the ramps running
+void MotorController::runFor(unsigned long duration) {
+  extern void kickWatchdog();
+  unsigned long start = millis();
+  while (millis() - start < duration) {
+    update();
+    kickWatchdog();
+    delay(TASK_MOTOR_PERIOD);
   }
-  statusString += " | Speed: " + String(globalSpeedMultiplier) + "%";
-  statusString += " | Safety: " + String(safetyStopActive ? "ACTIVE" : "OK");
+}
+
+int MotorController::getMotorSpeed(int motorIndex) {
+  if (motorIndex >= 0 && motorIndex < 4) {
+    return motors[motorIndex].currentSpeed;
+  }
+  return 0;
 }
 
 void MotorController::getStatus(char *buffer, size_t bufferSize) {
@@ -427,34 +493,36 @@ void MotorController::testMovementPatterns() {
 
   DEBUG_PRINTLN("  → Forward");
   moveForward(testSpeed);
-  delay(testDuration);
+  runFor(testDuration);
   stopAll();
-  delay(500);
+  runFor(500);
 
   DEBUG_PRINTLN("  → Backward");
   moveBackward(testSpeed);
-  delay(testDuration);
+  runFor(testDuration);
   stopAll();
-  delay(500);
+  runFor(500);
 
   DEBUG_PRINTLN("  → Left Turn");
   turnLeft(testSpeed);
-  delay(testDuration);
+  runFor(testDuration);
   stopAll();
-  delay(500);
+  runFor(500);
 
   DEBUG_PRINTLN("  → Right Turn");
   turnRight(testSpeed);
-  delay(testDuration);
+  runFor(testDuration);
   stopAll();
-  delay(500);
+  runFor(500);
 
   DEBUG_PRINTLN("  → Tank Drive Test");
   tankDrive(testSpeed, -testSpeed);
-  delay(testDuration);
+  runFor(testDuration);
   stopAll();
 
   DEBUG_PRINTLN("✅ Movement pattern test complete");
 }
 
+size_t MotorController::getRamUsage() { return sizeof(motors); }
+
 #endif // MOTOR_CONTROLLER_H
\ No newline at end of file
@@ -0,0 +1,149 @@
+/**********************************************************************
+ *  motor_io.h - Motor Driver Output Backend
+ *  Compile-time selected pin I/O for MotorController: direct PORTA and
+ *  timer OCR register writes on the Mega 2560, Arduino API elsewhere
+ *********************************************************************/
+
+#ifndef MOTOR_IO_H
+#define MOTOR_IO_H
+
+#include "config.h"
+
+// Driver pins per motor, indexed by FRONT_LEFT..REAR_RIGHT
+struct MotorPinMap {
+  uint8_t d0;
+  uint8_t d1;
+  uint8_t enable;
+};
+
+constexpr MotorPinMap MOTOR_PIN_MAP[4] = {
+    {DRIVER1_D0, DRIVER1_D1, DRIVER1_EN1}, // Front Left
+    {DRIVER1_D2, DRIVER1_D3, DRIVER1_EN2}, // Rear Left
+    {DRIVER2_D0, DRIVER2_D1, DRIVER2_EN1}, // Front Right
+    {DRIVER2_D2, DRIVER2_D3, DRIVER2_EN2}  // Rear Right
+};
+
+#if MOTOR_FAST_IO && defined(__AVR_ATmega2560__)
+#define MOTOR_IO_REGISTERS 1
+#else
+#define MOTOR_IO_REGISTERS 0
+#endif
+
+#if MOTOR_IO_REGISTERS
+// Timer output compare channels wired to the enable pins
+enum MotorPwmChannel : uint8_t {
+  MOTOR_PWM_OC3A, // Pin 5
+  MOTOR_PWM_OC3B, // Pin 2
+  MOTOR_PWM_OC3C, // Pin 3
+  MOTOR_PWM_OC0B, // Pin 4
+  MOTOR_PWM_UNSUPPORTED
+};
+
+constexpr MotorPwmChannel motorPwmChannel(uint8_t pin) {
+  return pin == 5   ? MOTOR_PWM_OC3A
+         : pin == 2 ? MOTOR_PWM_OC3B
+         : pin == 3 ? MOTOR_PWM_OC3C
+         : pin == 4 ? MOTOR_PWM_OC0B
+                    : MOTOR_PWM_UNSUPPORTED;
+}
+
+// Digital pins 22-29 are PA0-PA7
+constexpr bool isPortAPin(uint8_t pin) { return pin >= 22 && pin <= 29; }
+constexpr uint8_t portABit(uint8_t pin) { return 1 << (pin - 22); }
+
+constexpr bool motorPinsSupported(uint8_t motor) {
+  return isPortAPin(MOTOR_PIN_MAP[motor].d0) &&
+         isPortAPin(MOTOR_PIN_MAP[motor].d1) &&
+         motorPwmChannel(MOTOR_PIN_MAP[motor].enable) != MOTOR_PWM_UNSUPPORTED;
+}
+
+static_assert(motorPinsSupported(0) && motorPinsSupported(1) &&
+                  motorPinsSupported(2) && motorPinsSupported(3),
+              "MOTOR_FAST_IO needs direction pins 22-29 and enable pins 2-5; "
+              "set MOTOR_FAST_IO to false for other wiring");
+#endif
+
+class MotorIO {
+public:
+  // Configure the driver pins with every motor stopped
+  static void init();
+
+  // Apply all four directions (-1, 0, 1) together
+  static void setDirections(const int8_t *directions);
+
+  // Set one motor's PWM duty (0-255); 0 holds the enable pin low
+  static void setDuty(uint8_t motor, uint8_t duty);
+};
+
+// Implementation
+void MotorIO::init() {
+  for (uint8_t i = 0; i < 4; i++) {
+    pinMode(MOTOR_PIN_MAP[i].d0, OUTPUT);
+    pinMode(MOTOR_PIN_MAP[i].d1, OUTPUT);
+    pinMode(MOTOR_PIN_MAP[i].enable, OUTPUT);
+    setDuty(i, 0);
+  }
+
+  const int8_t stopped[4] = {0, 0, 0, 0};
+  setDirections(stopped);
+}
+
+#if MOTOR_IO_REGISTERS
+void MotorIO::setDirections(const int8_t *directions) {
+  uint8_t bits = 0;
+  for (uint8_t i = 0; i < 4; i++) {
+    if (directions[i] > 0)
+      bits |= portABit(MOTOR_PIN_MAP[i].d0);
+    else if (directions[i] < 0)
+      bits |= portABit(MOTOR_PIN_MAP[i].d1);
+  }
+
+  // PORTA belongs to the motor drivers, so one write latches all wheels
+  PORTA = bits;
+}
+
+// Duty 0 disconnects the compare output and drives the pin low, so a stopped
+// motor never sees the one-tick spike fast PWM produces at OCR = 0
+#define MOTOR_PWM_WRITE(ocr, tccr, com, port, bit)                             \
+  do {                                                                         \
+    if (duty == 0) {                                                           \
+      tccr &= ~_BV(com);                                                       \
+      port &= ~_BV(bit);                                                       \
+    } else {                                                                   \
+      ocr = duty;                                                              \
+      tccr |= _BV(com);                                                        \
+    }                                                                          \
+  } while (0)
+
+void MotorIO::setDuty(uint8_t motor, uint8_t duty) {
+  switch (motorPwmChannel(MOTOR_PIN_MAP[motor].enable)) {
+  case MOTOR_PWM_OC3A:
+    MOTOR_PWM_WRITE(OCR3A, TCCR3A, COM3A1, PORTE, PE3);
+    break;
+  case MOTOR_PWM_OC3B:
+    MOTOR_PWM_WRITE(OCR3B, TCCR3A, COM3B1, PORTE, PE4);
+    break;
+  case MOTOR_PWM_OC3C:
+    MOTOR_PWM_WRITE(OCR3C, TCCR3A, COM3C1, PORTE, PE5);
+    break;
+  case MOTOR_PWM_OC0B:
+    MOTOR_PWM_WRITE(OCR0B, TCCR0A, COM0B1, PORTG, PG5);
+    break;
+  default:
+    break;
+  }
+}
+#else
+void MotorIO::setDirections(const int8_t *directions) {
+  for (uint8_t i = 0; i < 4; i++) {
+    digitalWrite(MOTOR_PIN_MAP[i].d0, directions[i] > 0 ? HIGH : LOW);
+    digitalWrite(MOTOR_PIN_MAP[i].d1, directions[i] < 0 ? HIGH : LOW);
+  }
+}
+
+void MotorIO::setDuty(uint8_t motor, uint8_t duty) {
+  analogWrite(MOTOR_PIN_MAP[motor].enable, duty);
+}
+#endif
+
+#endif // MOTOR_IO_H
@@ -0,0 +1,118 @@
+/**********************************************************************
+ *  perf_monitor.h - Latency Probes and Histograms
+ *  micros()-based timing of scheduled tasks, command handling and
+ *  Bluetooth output, reported by the PERF command
+ *********************************************************************/
+
+#ifndef PERF_MONITOR_H
+#define PERF_MONITOR_H
+
+#include "config.h"
+#include "memory_optimization.h"
+
+// Probe ids - fixed probes first, then one per scheduled task
+#define PROBE_CMD_QUEUE 0 // Command queued -> handler starts
+#define PROBE_CMD_EXEC 1  // Handler start -> handler done (ack queued)
+#define PROBE_TX 2        // Time spent inside sendMessage()
+#define PROBE_LINK_RTT 3    // Robot ping -> app reply (PB bursts)
+#define PROBE_LINK_JITTER 4 // Change in RTT between consecutive replies
+#define PROBE_TASK_BASE 5
+#define PERF_PROBE_COUNT (PROBE_TASK_BASE + MAX_TASKS)
+
+// Histogram buckets grow by 4x: <16us, <64us, ... <65.5ms, and the rest
+#define PERF_BUCKET_COUNT 8
+#define PERF_FIRST_BUCKET_SHIFT 4
+
+struct PerfProbe {
+  unsigned long count;
+  unsigned long total; // us, for the mean
+  unsigned long minimum;
+  unsigned long maximum;
+  uint16_t buckets[PERF_BUCKET_COUNT]; // Saturating counts
+};
+
+class PerfMonitor {
+private:
+#if PERF_MONITOR_ENABLED
+  static PerfProbe probes[PERF_PROBE_COUNT];
+#endif
+
+  static uint8_t bucketFor(unsigned long elapsed);
+
+public:
+  // Clear all statistics
+  static void reset();
+
+  // Record one sample (microseconds) against a probe
+  static void record(uint8_t probe, unsigned long elapsed);
+
+  // Format one probe as a compact line; returns false if it has no samples
+  static bool formatProbe(uint8_t probe, const char *name, char *buffer,
+                          size_t bufferSize);
+
+  // Static RAM of the probe table (0 when the probes are compiled out)
+  static size_t getRamUsage();
+};
+
+// Implementation
+#if PERF_MONITOR_ENABLED
+PerfProbe PerfMonitor::probes[PERF_PROBE_COUNT];
+
+void PerfMonitor::reset() { memset(probes, 0, sizeof(probes)); }
+
+uint8_t PerfMonitor::bucketFor(unsigned long elapsed) {
+  uint8_t bucket = 0;
+  elapsed >>= PERF_FIRST_BUCKET_SHIFT;
+  while (elapsed && bucket < PERF_BUCKET_COUNT - 1) {
+    elapsed >>= 2;
+    bucket++;
+  }
+  return bucket;
+}
+
+void PerfMonitor::record(uint8_t probe, unsigned long elapsed) {
+  if (probe >= PERF_PROBE_COUNT)
+    return;
+
+  PerfProbe &p = probes[probe];
+  if (p.count == 0 || elapsed < p.minimum)
+    p.minimum = elapsed;
+  if (elapsed > p.maximum)
+    p.maximum = elapsed;
+  p.count++;
+  p.total += elapsed;
+
+  uint8_t bucket = bucketFor(elapsed);
+  if (p.buckets[bucket] != 0xFFFF)
+    p.buckets[bucket]++;
+}
+
+bool PerfMonitor::formatProbe(uint8_t probe, const char *name, char *buffer,
+                              size_t bufferSize) {
+  if (probe >= PERF_PROBE_COUNT || probes[probe].count == 0)
+    return false;
+
+  const PerfProbe &p = probes[probe];
+  const uint16_t *b = p.buckets;
+  snprintf_P(buffer, bufferSize,
+             PSTR("PERF:%s n=%lu min=%lu avg=%lu max=%lu "
+                  "h=%u,%u,%u,%u,%u,%u,%u,%u"),
+             name, p.count, p.minimum, p.total / p.count, p.maximum, b[0],
+             b[1], b[2], b[3], b[4], b[5], b[6], b[7]);
+  return true;
+}
+
+size_t PerfMonitor::getRamUsage() { return sizeof(probes); }
+#else
+// Probes compile away when instrumentation is disabled
+void PerfMonitor::reset() {}
+uint8_t PerfMonitor::bucketFor(unsigned long elapsed) { return 0; }
+void PerfMonitor::record(uint8_t probe, unsigned long elapsed) {}
+bool PerfMonitor::formatProbe(uint8_t probe, const char *name, char *buffer,
+                              size_t bufferSize) {
+  return false;
+}
+size_t PerfMonitor::getRamUsage() { return 0; }
+#endif
+
+#endif // PERF_MONITOR_H
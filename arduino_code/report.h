@@ -0,0 +1,98 @@
+/**********************************************************************
+ *  report.h - Bulk Diagnostic Output
+ *  Multi-line replies (HELP, PERF, MEM, TRACE:4, MLIST, BENCH) are
+ *  streamed from the REPORT task one line per run, and only once the
+ *  telemetry queue has room for a full line, so a long dump at a slow
+ *  link rate takes as long as the link needs without holding up the
+ *  other tasks. The command's OK_<name> goes out once the last line
+ *  has left the queue, so it can't overtake them.
+ *
+ *  A report is a line source and a cursor it advances; one report runs
+ *  at a time, and asking for another meanwhile gets ERROR_<name>.
+ *********************************************************************/
+
+#ifndef REPORT_H
+#define REPORT_H
+
+#include "bluetooth_handler.h"
+#include "config.h"
+#include "memory_optimization.h"
+
+// Write the line at cursor into buffer and move cursor past it; false
+// once there are no more lines. argument is the one given to start().
+typedef bool (*ReportSource)(uint16_t &cursor, uint16_t argument,
+                             char *buffer, size_t bufferSize);
+
+class Report {
+private:
+  static ReportSource source;
+  static const char *responseName;
+  static uint16_t cursor;
+  static uint16_t argument;
+  static bool inBatch; // Its OK is covered by the batch ACK
+
+public:
+  // Start streaming a report; false if one is already running
+  static bool start(const char *response, ReportSource lineSource,
+                    uint16_t sourceArgument = 0);
+
+  static bool isActive();
+
+  // Send the next line if the telemetry queue has room (REPORT task)
+  static void update();
+};
+
+// Static variable definitions
+ReportSource Report::source = nullptr;
+const char *Report::responseName = nullptr;
+uint16_t Report::cursor = 0;
+uint16_t Report::argument = 0;
+bool Report::inBatch = false;
+
+// Implementation
+bool Report::start(const char *response, ReportSource lineSource,
+                   uint16_t sourceArgument) {
+  if (responseName)
+    return false;
+
+  source = lineSource;
+  responseName = response;
+  cursor = 0;
+  argument = sourceArgument;
+  inBatch = BluetoothHandler::inResponseBatch();
+  return true;
+}
+
+bool Report::isActive() { return responseName != nullptr; }
+
+void Report::update() {
+  if (!responseName)
+    return;
+
+  // Acks jump the telemetry queue, so the OK waits until it is empty
+  if (!source) {
+    if (BluetoothHandler::getTelemetryFree() == TX_TELEMETRY_BUFFER_SIZE) {
+      if (!inBatch) {
+        BluetoothHandler::sendResponse(responseName);
+      }
+      responseName = nullptr;
+    }
+    return;
+  }
+
+  // Any line fits once there is room for the longest one
+  if (BluetoothHandler::getTelemetryFree() < MAX_MESSAGE_LENGTH + 2)
+    return;
+
+  MessageHandle message(MAX_MESSAGE_LENGTH);
+  if (!message)
+    return;
+
+  if (source(cursor, argument, message.get(), message.size())) {
+    BluetoothHandler::sendMessage(message.get());
+  } else {
+    source = nullptr;
+  }
+}
+
+#endif // REPORT_H
@@ -11,40 +11,66 @@
  *  - System status and safety
  *********************************************************************/
 
+#include "benchmark.h"
+#include "binary_protocol.h"
 #include "bluetooth_handler.h"
 #include "collision_avoidance.h"
 #include "command_processor.h"
 #include "config.h"
+#include "config_store.h"
+#include "link_probe.h"
+#include "macro_engine.h"
 #include "memory_optimization.h"
 #include "motor_controller.h"
 #include "relay_controller.h"
+#include "report.h"
 #include "sensor_manager.h"
 #include "sensor_status.h"
 #include "servo_arm.h"
 #include "system_status.h"
+#include "task_scheduler.h"
+#include "trace.h"
+#include "watchdog.h"
 
 // Global system state
 SystemState systemState;
 
-// Forward declarations for circular dependency resolution
-void sendBluetoothMessage(const char *message);
-
 // Function to handle command queue from Bluetooth (solves circular dependency)
-void addCommandToQueue(const char *cmd) { CommandProcessor::addCommand(cmd); }
+bool addCommandToQueue(const char *cmd) {
+  return CommandProcessor::addCommand(cmd);
+}
+
+// Function to queue a decoded binary frame (solves circular dependency)
+bool addFrameCommandToQueue(const Command &cmd) {
+  return CommandProcessor::addCommand(cmd);
+}
 
 // Function to send Bluetooth messages (solves circular dependency)
-void sendBluetoothMessage(const char *message) {
+void sendBluetoothMessage(const char *message, uint8_t priority) {
 #if SERIAL_TESTING_MODE
   // In testing mode, send to Serial Monitor with shorter prefix
   Serial.print(F("📤 "));
   Serial.println(message);
 #else
-  BluetoothHandler::sendMessage(message);
+  BluetoothHandler::sendMessage(message, priority);
 #endif
 }
 
+// Function to run the next benchmark case (solves circular dependency)
+bool benchmarkLine(uint16_t &cursor, uint16_t iterations, char *line,
+                   size_t lineSize) {
+  return Benchmark::reportLine(cursor, iterations, line, lineSize);
+}
+
 // Function for emergency motor stop (solves circular dependency)
-void emergencyStopAllMotors() { MotorController::emergencyStop(); }
+void emergencyStopAllMotors() {
+  MotorController::emergencyStop();
+  MacroEngine::abort(PSTR("COLLISION"));
+}
+
+// Function to feed the watchdog from blocking loops (solves circular
+// dependency)
+void kickWatchdog() { Watchdog::kick(); }
 
 // Function to check collision safety (solves circular dependency)
 bool checkCollisionSafety(bool movingForward) {
@@ -52,23 +78,17 @@ bool checkCollisionSafety(bool movingForward) {
 }
 
 void setup() {
+  // Reset cause and the warm restart snapshot, before any subsystem starts
+  Watchdog::init();
+
   // Initialize serial for debugging
   Serial.begin(115200);
-  delay(2000);
-
-  Serial.println(F("==============================================="));
-  Serial.println(F("4WD Robot with 6-Servo Arm - Bluetooth Control"));
-  Serial.println(F("+ HC-SR04 Collision Avoidance System"));
-  Serial.println(F("Version: 2.1 - Memory Optimized"));
-
-#if SERIAL_TESTING_MODE
-  Serial.println(F("MODE: Serial Monitor Testing"));
-  Serial.println(F("Send commands via Serial Monitor"));
-#else
-  Serial.println(F("MODE: Bluetooth Operation"));
-#endif
 
-  Serial.println(F("==============================================="));
+  if (Watchdog::isWarmBoot()) {
+    Serial.println(F("♻ Watchdog reset - warm restart"));
+  } else {
+    printBanner();
+  }
 
   // Initialize memory monitor first
   MemoryMonitor::init();
@@ -84,7 +104,9 @@ void setup() {
   systemState.isReady = true;
   systemState.startTime = millis();
 
-  Serial.println(F("✅ System Ready!"));
+  Serial.print(F("✅ System Ready in "));
+  Serial.print(systemState.startTime);
+  Serial.println(F(" ms"));
 
 #if SERIAL_TESTING_MODE
   Serial.println(F("📝 Use Serial Monitor to send commands"));
@@ -101,20 +123,50 @@ void setup() {
   Serial.println(F("ROBOT_READY - You can now send commands!"));
 #else
   sendBluetoothMessage("ROBOT_READY");
+#endif
+  sendBootReport();
+
+#if BENCH_CYCLE_COUNT
+  // Simulator build (host/simavr_bench.sh): time the cases once and stop
+  Benchmark::runAll(0);
+  Benchmark::halt();
 #endif
 }
 
-void loop() {
-  // Monitor memory first to detect issues early
-  if (!MemoryMonitor::checkMemory()) {
-    // Critical memory situation - force garbage collection
-    MemoryMonitor::forceGarbageCollection();
-    delay(100); // Give system time to recover
+void printBanner() {
+  Serial.println(F("==============================================="));
+  Serial.println(F("4WD Robot with 6-Servo Arm - Bluetooth Control"));
+  Serial.println(F("+ HC-SR04 Collision Avoidance System"));
+  Serial.println(F("Version: 2.1 - Memory Optimized"));
+
+#if SERIAL_TESTING_MODE
+  Serial.println(F("MODE: Serial Monitor Testing"));
+  Serial.println(F("Send commands via Serial Monitor"));
+#else
+  Serial.println(F("MODE: Bluetooth Operation"));
+#endif
+
+  Serial.println(F("==============================================="));
+}
+
+// Longer than the high priority queue takes, so it goes with telemetry
+void sendBootReport() {
+  MessageHandle message(MAX_MESSAGE_LENGTH);
+  if (message) {
+    Watchdog::getBootReport(message.get(), message.size());
+    sendBluetoothMessage(message.get());
   }
+}
 
-  // Update system status
-  // SystemStatus::update();  // Temporarily disabled for compilation
+void loop() {
+  // Run whichever task is due next; idles until then
+  TaskScheduler::run();
+}
+
+// ========== SCHEDULED TASKS ==========
 
+// Input from the active link, plus draining queued output
+void commsTask() {
 #if SERIAL_TESTING_MODE
   // Handle Serial Monitor commands in testing mode
   handleSerialCommands();
@@ -122,53 +174,78 @@ void loop() {
   // Handle Bluetooth communication in normal mode
   BluetoothHandler::update();
 #endif
+}
 
-  // Process any received commands (do this frequently)
-  CommandProcessor::processQueue();
-
-  // Update motor controller (handles safety timeouts)
+// Motor safety timeout plus the system-wide stop conditions
+void motorTask() {
   MotorController::update();
 
-  // Update servo arm
-  ServoArm::update();
-
-  // Update relay controller
-  RelayController::update();
-
-  // Update sensors less frequently to improve responsiveness and save memory
-  static unsigned long lastSensorUpdate = 0;
-  if (millis() - lastSensorUpdate >= SENSOR_UPDATE_INTERVAL) {
-    SensorManager::update();
-    CollisionAvoidance::update();
-    lastSensorUpdate = millis();
-  }
-
-  // Update sensor status even less frequently to save memory
-  static unsigned long lastStatusUpdate = 0;
-  if (millis() - lastStatusUpdate >= STATUS_SEND_INTERVAL) {
-    SensorStatusManager::update();
-    lastStatusUpdate = millis();
-  }
-
   // Safety check - stop all if timeout or collision risk
   // if (SystemStatus::isCommandTimeout()) {  // Temporarily disabled
   if (false) {
     MotorController::stopAll();
     ServoArm::stopAll();
   }
+}
 
-  // Additional safety check for collision avoidance
-  if (CollisionAvoidance::isEmergencyStopActive()) {
-    MotorController::stopAll();
-  }
+void memoryTask() {
+  // Update system status
+  // SystemStatus::update();  // Temporarily disabled for compilation
 
-  // Increased delay to reduce loop frequency and save processing power
-  delay(10); // Increased from 5ms
+  // Nothing allocates after setup(), so there is no heap to clean up -
+  // a critical reading means the stack has grown into the statics
+  MemoryMonitor::checkMemory();
+}
+
+void registerTasks() {
+  TaskScheduler::addTask(commsTask, PSTR("COMMS"), TASK_COMMS_PERIOD,
+                         TASK_COMMS_PRIORITY, TASK_COMMS_DEADLINE);
+  TaskScheduler::addTask(CommandProcessor::processQueue, PSTR("COMMANDS"),
+                         TASK_COMMANDS_PERIOD, TASK_COMMANDS_PRIORITY,
+                         TASK_COMMANDS_DEADLINE);
+  TaskScheduler::addTask(motorTask, PSTR("MOTOR"), TASK_MOTOR_PERIOD,
+                         TASK_MOTOR_PRIORITY, TASK_MOTOR_DEADLINE);
+  // The ranging engine publishes finished echoes each run and starts a new
+  // cycle on its own SENSOR_UPDATE_INTERVAL
+  TaskScheduler::addTask(SensorManager::update, PSTR("SENSOR"),
+                         TASK_SENSOR_PERIOD, TASK_SENSOR_PRIORITY,
+                         TASK_SENSOR_DEADLINE);
+  TaskScheduler::addTask(CollisionAvoidance::update, PSTR("COLLISION"),
+                         TASK_COLLISION_PERIOD, TASK_COLLISION_PRIORITY,
+                         TASK_COLLISION_DEADLINE);
+  TaskScheduler::addTask(ServoArm::update, PSTR("SERVO"), TASK_SERVO_PERIOD,
+                         TASK_SERVO_PRIORITY, TASK_SERVO_DEADLINE);
+  TaskScheduler::addTask(RelayController::update, PSTR("RELAY"),
+                         TASK_RELAY_PERIOD, TASK_RELAY_PRIORITY,
+                         TASK_RELAY_DEADLINE);
+  TaskScheduler::addTask(SensorStatusManager::update, PSTR("STATUS"),
+                         TASK_STATUS_PERIOD, TASK_STATUS_PRIORITY,
+                         TASK_STATUS_DEADLINE);
+  TaskScheduler::addTask(memoryTask, PSTR("MEMORY"), TASK_MEMORY_PERIOD,
+                         TASK_MEMORY_PRIORITY, TASK_MEMORY_DEADLINE);
+  TaskScheduler::addTask(LinkProbe::update, PSTR("LINK_PROBE"),
+                         TASK_LINK_PROBE_PERIOD, TASK_LINK_PROBE_PRIORITY,
+                         TASK_LINK_PROBE_DEADLINE);
+  TaskScheduler::addTask(CommandTrace::update, PSTR("TRACE"),
+                         TASK_TRACE_PERIOD, TASK_TRACE_PRIORITY,
+                         TASK_TRACE_DEADLINE);
+  TaskScheduler::addTask(ConfigStore::update, PSTR("CONFIG"),
+                         TASK_CONFIG_PERIOD, TASK_CONFIG_PRIORITY,
+                         TASK_CONFIG_DEADLINE);
+  TaskScheduler::addTask(MacroEngine::update, PSTR("MACRO"),
+                         TASK_MACRO_PERIOD, TASK_MACRO_PRIORITY,
+                         TASK_MACRO_DEADLINE);
+  TaskScheduler::addTask(Report::update, PSTR("REPORT"),
+                         TASK_REPORT_PERIOD, TASK_REPORT_PRIORITY,
+                         TASK_REPORT_DEADLINE);
+  TaskScheduler::addTask(Watchdog::update, PSTR("WATCHDOG"),
+                         TASK_WATCHDOG_PERIOD, TASK_WATCHDOG_PRIORITY,
+                         TASK_WATCHDOG_DEADLINE);
 }
 
 // Serial command handler for testing mode - optimized for memory
 void handleSerialCommands() {
-  static char serialBuffer[MAX_COMMAND_LENGTH];
+  static char serialBuffer[MAX_LINE_LENGTH];
   static int bufferIndex = 0;
 
   while (Serial.available()) {
@@ -186,14 +263,12 @@ void handleSerialCommands() {
         // SystemStatus::updateLastCommand();  // Temporarily disabled
 
         // Add command to processing queue
+        CommandTrace::recordInbound(serialBuffer);
         CommandProcessor::addCommand(serialBuffer);
 
         // Clear buffer
         bufferIndex = 0;
         memset(serialBuffer, 0, sizeof(serialBuffer));
-
-        // Small delay to let command process
-        delay(10);
       }
     } else if (c != '\0' && c != '\r') {
       if (bufferIndex == 0 && c == ' ') {
@@ -201,7 +276,7 @@ void handleSerialCommands() {
         continue;
       }
 
-      if (bufferIndex < MAX_COMMAND_LENGTH - 1) {
+      if (bufferIndex < MAX_LINE_LENGTH - 1) {
         serialBuffer[bufferIndex++] = c;
       } else {
         // Buffer overflow protection
@@ -219,34 +294,49 @@ void initializeSystem() {
   // Initialize system status
   // SystemStatus::init();  // Temporarily disabled for compilation
 
-  // Initialize relay controller first (power management)
+  // Nothing here waits: anything slow (Bluetooth settle, servo homing,
+  // the first sensor scan) finishes in its task after setup returns.
+  // A warm restart skips those too and picks up the arm pose, settings
+  // and link rate from before the reset. Motion is never resumed.
+  // Motors first, so they are stopped before anything else can run.
+  bool warm = Watchdog::isWarmBoot();
+  const WarmState &resume = Watchdog::getWarmState();
+  MotorController::init();
+
+  // Initialize relay controller (power management)
   RelayController::init();
 
+  // Sensors and collision avoidance before anything can move the robot
+  SensorManager::init();
+  CollisionAvoidance::init();
+
+  // Initialize servo arm (homing continues in the servo task)
+  ServoArm::init(warm ? resume.armPulses : nullptr);
+
 #if !SERIAL_TESTING_MODE
   // Initialize Bluetooth communication only in normal mode
-  BluetoothHandler::init();
+  BluetoothHandler::init(warm ? resume.baud : 0);
 #else
   Serial.println(F("📝 Bluetooth disabled - Serial testing mode"));
 #endif
 
-  // Initialize motor controller
-  MotorController::init();
-
-  // Initialize servo arm
-  ServoArm::init();
-
-  // Initialize sensor manager
-  SensorManager::init();
-
-  // Initialize collision avoidance
-  CollisionAvoidance::init();
-
   // Initialize sensor status manager
   SensorStatusManager::init();
 
+  // Replace the defaults above with the settings saved in EEPROM
+  ConfigStore::init();
+  if (warm) {
+    ConfigStore::resume(resume.config);
+  }
+
   // Initialize command processor (last, as it may depend on others)
   CommandProcessor::init();
 
+  // Hand the subsystem updates to the scheduler, which feeds the
+  // watchdog once every one of them has run
+  registerTasks();
+  Watchdog::start(TaskScheduler::getTaskCount());
+
   Serial.println(F("✅ All subsystems initialized"));
 
   // Final memory check after initialization
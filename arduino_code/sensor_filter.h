@@ -0,0 +1,149 @@
+/**********************************************************************
+ *  sensor_filter.h - Streaming Ultrasonic Distance Filter
+ *  Per-sensor running median (rejects single spurious echoes), an
+ *  exponential moving average on top of it, and a closing-rate
+ *  estimate, all in integer millimetres with constant memory. A jump
+ *  that persists restarts the filter at the new distance rather than
+ *  working its way through the median and average.
+ *********************************************************************/
+
+#ifndef SENSOR_FILTER_H
+#define SENSOR_FILTER_H
+
+#include "config.h"
+
+static_assert(SENSOR_MEDIAN_WINDOW % 2 == 1 && SENSOR_MEDIAN_WINDOW <= 7,
+              "SENSOR_MEDIAN_WINDOW must be odd and at most 7");
+
+class SensorFilterStage {
+private:
+  static uint16_t median(const SensorFilter &filter);
+
+  // Start over from one reading, as if it had always been there
+  static void reseed(SensorFilter &filter, uint16_t distanceMm,
+                     unsigned long now);
+
+public:
+  // Forget all history
+  static void reset(SensorFilter &filter);
+
+  // Feed one valid reading. Returns false if it was rejected as an outlier.
+  // A reading closer than the median and within nearMm (the warning
+  // range) is never rejected.
+  static bool addSample(SensorFilter &filter, uint16_t distanceMm,
+                        unsigned long now, uint16_t nearMm);
+
+  // Filtered distance (mm), SENSOR_NO_ECHO before the first reading
+  static uint16_t getDistance(const SensorFilter &filter);
+
+  // Closing rate (mm/s), positive while the obstacle gets closer
+  static int16_t getClosingRate(const SensorFilter &filter);
+};
+
+// Implementation
+void SensorFilterStage::reset(SensorFilter &filter) {
+  memset(&filter, 0, sizeof(filter));
+}
+
+uint16_t SensorFilterStage::median(const SensorFilter &filter) {
+  // Insertion sort of a copy - the window is a handful of samples
+  uint16_t sorted[SENSOR_MEDIAN_WINDOW];
+  uint8_t count = filter.sampleCount;
+  for (uint8_t i = 0; i < count; i++) {
+    uint16_t value = filter.window[i];
+    uint8_t j = i;
+    while (j > 0 && sorted[j - 1] > value) {
+      sorted[j] = sorted[j - 1];
+      j--;
+    }
+    sorted[j] = value;
+  }
+  return sorted[count / 2];
+}
+
+void SensorFilterStage::reseed(SensorFilter &filter, uint16_t distanceMm,
+                               unsigned long now) {
+  for (uint8_t i = 0; i < SENSOR_MEDIAN_WINDOW; i++) {
+    filter.window[i] = distanceMm;
+  }
+  filter.sampleCount = SENSOR_MEDIAN_WINDOW;
+  filter.nextSample = 0;
+  filter.rejectedInRow = 0;
+  filter.averageQ4 = (int32_t)distanceMm << 4;
+  filter.closingRate = 0; // A jump is a new obstacle, not motion
+  filter.lastSampleTime = now;
+}
+
+bool SensorFilterStage::addSample(SensorFilter &filter, uint16_t distanceMm,
+                                  unsigned long now, uint16_t nearMm) {
+  if (filter.sampleCount > 0) {
+    uint16_t current = median(filter);
+    uint16_t jump = distanceMm > current ? distanceMm - current
+                                         : current - distanceMm;
+    if (jump > SENSOR_OUTLIER_MM) {
+      // Something new close ahead is acted on at once, even if it turns
+      // out to be a stray echo
+      if (distanceMm < current && distanceMm <= nearMm) {
+        reseed(filter, distanceMm, now);
+        return true;
+      }
+
+      // A lone reading far from the median is usually a stray echo. Once
+      // SENSOR_OUTLIER_LIMIT of them in a row agree, the jump is real.
+      uint16_t spread = distanceMm > filter.rejectedMm
+                            ? distanceMm - filter.rejectedMm
+                            : filter.rejectedMm - distanceMm;
+      if (filter.rejectedInRow > 0 && spread > SENSOR_OUTLIER_MM)
+        filter.rejectedInRow = 0; // Disagrees with the last one: start over
+      if (filter.rejectedInRow < SENSOR_OUTLIER_LIMIT) {
+        filter.rejectedInRow++;
+        filter.rejectedMm = distanceMm;
+        return false;
+      }
+      reseed(filter, distanceMm, now);
+      return true;
+    }
+  }
+  filter.rejectedInRow = 0;
+
+  filter.window[filter.nextSample] = distanceMm;
+  filter.nextSample = (filter.nextSample + 1) % SENSOR_MEDIAN_WINDOW;
+  if (filter.sampleCount < SENSOR_MEDIAN_WINDOW)
+    filter.sampleCount++;
+
+  int32_t medianQ4 = (int32_t)median(filter) << 4;
+  if (filter.sampleCount == 1) {
+    // First reading seeds the average instead of ramping up from zero
+    filter.averageQ4 = medianQ4;
+    filter.closingRate = 0;
+    filter.lastSampleTime = now;
+    return true;
+  }
+
+  int32_t previousQ4 = filter.averageQ4;
+  filter.averageQ4 += (medianQ4 - previousQ4) >> SENSOR_EMA_SHIFT;
+
+  unsigned long elapsed = now - filter.lastSampleTime;
+  if (elapsed > 0) {
+    // Shrinking distance is a positive closing rate
+    int32_t rate = ((previousQ4 - filter.averageQ4) * 1000L / (long)elapsed) >>
+                   4;
+    rate = constrain(rate, -32000L, 32000L);
+    filter.closingRate += (int16_t)((rate - filter.closingRate) >>
+                                    SENSOR_RATE_SHIFT);
+  }
+  filter.lastSampleTime = now;
+  return true;
+}
+
+uint16_t SensorFilterStage::getDistance(const SensorFilter &filter) {
+  if (filter.sampleCount == 0)
+    return SENSOR_NO_ECHO;
+  return (uint16_t)((filter.averageQ4 + 8) >> 4); // Rounded
+}
+
+int16_t SensorFilterStage::getClosingRate(const SensorFilter &filter) {
+  return filter.closingRate;
+}
+
+#endif // SENSOR_FILTER_H
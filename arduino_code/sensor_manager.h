@@ -1,43 +1,104 @@
 /**********************************************************************
  *  sensor_manager.h - HC-SR04 Ultrasonic Sensor Management
- *  Handles front and rear ultrasonic sensors for collision detection
+ *  Handles the ultrasonic sensors in SENSOR_LAYOUT for collision
+ *  detection, firing them one at a time on a staggered schedule
  *********************************************************************/
 
 #ifndef SENSOR_MANAGER_H
 #define SENSOR_MANAGER_H
 
 #include "config.h"
+#include "memory_optimization.h"
+#include "sensor_filter.h"
+
+// Echo capture states shared between the main loop and the echo ISR
+#define ECHO_IDLE 0
+#define ECHO_WAIT_RISE 1
+#define ECHO_WAIT_FALL 2
+#define ECHO_DONE 3
+
+#define NO_ACTIVE_SENSOR -1
+
+static_assert(SENSOR_COUNT >= 2 && SENSOR_COUNT <= 8,
+              "SENSOR_LAYOUT needs front and rear rows and at most 8 sensors");
 
 class SensorManager {
 private:
-  static SensorState sensors[2];
+  static SensorState sensors[SENSOR_COUNT];
   static bool sensorsEnabled;
-  static unsigned long lastSensorUpdate;
-  static float collisionDistance;
-  static float warningDistance;
+  static uint16_t collisionDistanceMm;
+  static uint16_t warningDistanceMm;
+
+  // Non-blocking ranging engine - one sensor in flight at a time
+  static int activeSensor;
+  static unsigned long pingStartTime;
+  static volatile uint8_t echoState;
+  static volatile unsigned long echoStartTime;
+  static volatile unsigned long echoEndTime;
+#if defined(__AVR__)
+  static volatile uint8_t *echoInputRegister;
+  static uint8_t echoBitMask;
+#else
+  static int echoPin;
+#endif
+
+  // Staggered firing schedule
+  static unsigned long lastPingTime[SENSOR_COUNT];
+  static unsigned long quietUntil[SENSOR_COUNT]; // Crosstalk hold-off
+  static uint8_t crosstalkMask[SENSOR_COUNT];    // Bit per neighbour
+  static unsigned long nextScanTime;             // Nothing is due before
+  static int8_t travelDirection;                 // 1, -1 or 0 (stationary)
 
   // Private helper methods
-  static float readDistance(int trigPin, int echoPin);
+  static uint16_t readDistance(int trigPin, int echoPin);
   static void updateSensorState(int sensorIndex);
-  static bool isValidReading(float distance);
-  static void stabilizeReading(int sensorIndex, float newReading);
+  static void processReading(int sensorIndex, uint16_t distanceMm);
+  static bool isValidReading(uint16_t distanceMm);
+  static void filterReading(int sensorIndex, uint16_t newReadingMm);
+  static void getSensorPins(int sensorIndex, int &trigPin, int &echoPin);
+
+  // Ranging engine helpers
+  static void attachEchoInterrupt(int echoPin);
+  static void startPing(int sensorIndex);
+  static void servicePing();
+  static int nextSensorDue(unsigned long now);
+  static unsigned long pingPeriod(int sensorIndex);
+  static uint16_t headingDifference(uint16_t a, uint16_t b);
 
 public:
   // Initialize sensor manager
   static void init();
 
-  // Update - call this in main loop
+  // Update - call this in main loop (never blocks on an echo)
   static void update();
 
+  // Echo edge handler - called from the pin-change interrupt
+  static void handleEchoEdge();
+  static bool isRangingInProgress();
+
+  // Ping the sensors facing the direction of travel more often
+  // (travelSpeed is signed, e.g. MotorController::getTravelSpeed())
+  static void setTravelDirection(int travelSpeed);
+
+  // Sensor table
+  static int getSensorCount();
+
+  // Static RAM of the sensor state and scheduling tables
+  static size_t getRamUsage();
+  static bool isFacing(int sensorIndex, bool forward);
+
   // Sensor control
   static void enableSensors();
   static void disableSensors();
   static bool areSensorsEnabled();
 
-  // Distance readings
-  static float getFrontDistance();
-  static float getRearDistance();
-  static float getDistance(int sensorIndex);
+  // Distance readings (mm, SENSOR_NO_ECHO if none)
+  static uint16_t getFrontDistanceMm();
+  static uint16_t getRearDistanceMm();
+  static uint16_t getDistanceMm(int sensorIndex);
+
+  // Closing rate from the filter (mm/s, positive = getting closer)
+  static int16_t getClosingRate(int sensorIndex);
 
   // Obstacle detection
   static bool isFrontObstacleDetected();
@@ -49,15 +110,15 @@ public:
   static bool isRearCollisionRisk();
   static bool isCollisionRisk(int sensorIndex);
 
-  // Configuration
-  static void setCollisionDistance(float distance);
-  static void setWarningDistance(float distance);
-  static float getCollisionDistance();
-  static float getWarningDistance();
+  // Configuration (cm, as used by commands)
+  static void setCollisionDistance(int distanceCm);
+  static void setWarningDistance(int distanceCm);
+  static int getCollisionDistance();
+  static int getWarningDistance();
 
   // Status and diagnostics
   static void getSensorStatus(SensorStatus &status);
-  static void getDetailedStatus(String &statusString);
+  static void getDetailedStatus(char *buffer, size_t bufferSize);
   static bool areSensorsHealthy();
 
   // Calibration and testing
@@ -72,90 +133,308 @@ public:
 };
 
 // Implementation
-SensorState SensorManager::sensors[2] = {
-    {0.0, 0.0, false, false, 0, 0, "Front", true},
-    {0.0, 0.0, false, false, 0, 0, "Rear", true}};
+SensorState SensorManager::sensors[SENSOR_COUNT];
 
 bool SensorManager::sensorsEnabled = true;
-unsigned long SensorManager::lastSensorUpdate = 0;
-float SensorManager::collisionDistance = COLLISION_DISTANCE_STOP;
-float SensorManager::warningDistance = COLLISION_DISTANCE_WARN;
+uint16_t SensorManager::collisionDistanceMm =
+    CM_TO_MM(COLLISION_DISTANCE_STOP);
+uint16_t SensorManager::warningDistanceMm = CM_TO_MM(COLLISION_DISTANCE_WARN);
+
+int SensorManager::activeSensor = NO_ACTIVE_SENSOR;
+unsigned long SensorManager::pingStartTime = 0;
+volatile uint8_t SensorManager::echoState = ECHO_IDLE;
+volatile unsigned long SensorManager::echoStartTime = 0;
+volatile unsigned long SensorManager::echoEndTime = 0;
+#if defined(__AVR__)
+volatile uint8_t *SensorManager::echoInputRegister = nullptr;
+uint8_t SensorManager::echoBitMask = 0;
+
+// All pin-change vectors share one handler; only the active echo pin matters
+ISR(PCINT0_vect) { SensorManager::handleEchoEdge(); }
+ISR(PCINT1_vect, ISR_ALIASOF(PCINT0_vect));
+ISR(PCINT2_vect, ISR_ALIASOF(PCINT0_vect));
+#else
+int SensorManager::echoPin = -1;
+
+void sensorEchoISR() { SensorManager::handleEchoEdge(); }
+#endif
+
+unsigned long SensorManager::lastPingTime[SENSOR_COUNT];
+unsigned long SensorManager::quietUntil[SENSOR_COUNT];
+uint8_t SensorManager::crosstalkMask[SENSOR_COUNT];
+unsigned long SensorManager::nextScanTime = 0;
+int8_t SensorManager::travelDirection = 0;
 
 void SensorManager::init() {
   DEBUG_PRINTLN("📡 Initializing Sensor Manager...");
 
-  // Initialize sensor pins
-  pinMode(FRONT_SENSOR_TRIG, OUTPUT);
-  pinMode(FRONT_SENSOR_ECHO, INPUT);
-  pinMode(REAR_SENSOR_TRIG, OUTPUT);
-  pinMode(REAR_SENSOR_ECHO, INPUT);
+  unsigned long now = millis();
+
+  // Initialize sensor pins and states
+  for (int i = 0; i < SENSOR_COUNT; i++) {
+    pinMode(SENSOR_LAYOUT[i].trigPin, OUTPUT);
+    pinMode(SENSOR_LAYOUT[i].echoPin, INPUT);
+    attachEchoInterrupt(SENSOR_LAYOUT[i].echoPin);
 
-  // Initialize sensor states
-  for (int i = 0; i < 2; i++) {
-    sensors[i].currentDistance = 0.0;
-    sensors[i].lastStableDistance = 0.0;
+    strncpy(sensors[i].name, SENSOR_LAYOUT[i].name,
+            sizeof(sensors[i].name) - 1);
+    sensors[i].name[sizeof(sensors[i].name) - 1] = '\0';
+    sensors[i].currentDistanceMm = 0;
+    sensors[i].stableDistanceMm = 0;
     sensors[i].isObstacleDetected = false;
     sensors[i].isCollisionRisk = false;
     sensors[i].lastUpdate = 0;
-    sensors[i].stableReadingCount = 0;
     sensors[i].isActive = true;
+    SensorFilterStage::reset(sensors[i].filter);
+
+    // Neighbours facing nearly the same way can hear each other's pings
+    crosstalkMask[i] = 0;
+    for (int j = 0; j < SENSOR_COUNT; j++) {
+      if (j != i && headingDifference(SENSOR_LAYOUT[i].headingDeg,
+                                      SENSOR_LAYOUT[j].headingDeg) <=
+                        SENSOR_CROSSTALK_ANGLE) {
+        crosstalkMask[i] |= 1 << j;
+      }
+    }
+    lastPingTime[i] = now - SENSOR_UPDATE_INTERVAL; // Due straight away
+    quietUntil[i] = now;
   }
 
   sensorsEnabled = true;
-  lastSensorUpdate = millis();
+  nextScanTime = now;
+  travelDirection = 0;
+  activeSensor = NO_ACTIVE_SENSOR;
+  echoState = ECHO_IDLE;
 
-  // Initial sensor reading
-  delay(100);
-  update();
+  // No blocking first reading: every sensor is due, so the sensor task
+  // starts the scan on its first run
 
   DEBUG_PRINTLN("✅ Sensor Manager initialized");
   DEBUG_PRINTLN("📍 Sensor Configuration:");
-  DEBUG_PRINTLN("   Front Sensor: Trig=" + String(FRONT_SENSOR_TRIG) +
-                ", Echo=" + String(FRONT_SENSOR_ECHO));
-  DEBUG_PRINTLN("   Rear Sensor: Trig=" + String(REAR_SENSOR_TRIG) +
-                ", Echo=" + String(REAR_SENSOR_ECHO));
-  DEBUG_PRINTLN("   Collision Distance: " + String(collisionDistance) + "cm");
-  DEBUG_PRINTLN("   Warning Distance: " + String(warningDistance) + "cm");
+  for (int i = 0; i < SENSOR_COUNT; i++) {
+    DEBUG_PRINT_P("   ");
+    DEBUG_PRINT(sensors[i].name);
+    DEBUG_PRINT_P(" Sensor: Trig=");
+    DEBUG_PRINT(SENSOR_LAYOUT[i].trigPin);
+    DEBUG_PRINT_P(", Echo=");
+    DEBUG_PRINT(SENSOR_LAYOUT[i].echoPin);
+    DEBUG_PRINT_P(", Heading=");
+    DEBUG_PRINTLN(SENSOR_LAYOUT[i].headingDeg);
+  }
+  DEBUG_PRINT_P("   Collision Distance: ");
+  DEBUG_PRINT(collisionDistanceMm);
+  DEBUG_PRINTLN_P("mm");
+  DEBUG_PRINT_P("   Warning Distance: ");
+  DEBUG_PRINT(warningDistanceMm);
+  DEBUG_PRINTLN_P("mm");
 }
 
 void SensorManager::update() {
   if (!sensorsEnabled)
     return;
 
+  // Publish a finished echo (or a timeout) before firing the next sensor
+  if (activeSensor != NO_ACTIVE_SENSOR) {
+    servicePing();
+    if (activeSensor != NO_ACTIVE_SENSOR)
+      return; // Echo still in flight
+  }
+
+  // Nothing can be due before nextScanTime, so most calls stop here and
+  // the cost per loop stays flat however many sensors there are
   unsigned long currentTime = millis();
+  if ((long)(currentTime - nextScanTime) < 0)
+    return;
 
-  // Update sensors at specified interval
-  if (currentTime - lastSensorUpdate >= SENSOR_UPDATE_INTERVAL) {
-    updateSensorState(FRONT_SENSOR);
-    updateSensorState(REAR_SENSOR);
-    lastSensorUpdate = currentTime;
+  int next = nextSensorDue(currentTime);
+  if (next != NO_ACTIVE_SENSOR) {
+    startPing(next);
   }
 }
 
-void SensorManager::updateSensorState(int sensorIndex) {
-  if (sensorIndex < 0 || sensorIndex >= 2)
+int SensorManager::nextSensorDue(unsigned long now) {
+  // Earliest deadline first among sensors that are due and not held off
+  // by a neighbour's echo; also note when the next one becomes eligible
+  int best = NO_ACTIVE_SENSOR;
+  unsigned long bestDue = 0;
+  unsigned long earliest = now + SENSOR_UPDATE_INTERVAL;
+
+  for (int i = 0; i < SENSOR_COUNT; i++) {
+    unsigned long due = lastPingTime[i] + pingPeriod(i);
+    unsigned long eligible =
+        (long)(quietUntil[i] - due) > 0 ? quietUntil[i] : due;
+
+    if ((long)(now - eligible) < 0) {
+      if ((long)(eligible - earliest) < 0)
+        earliest = eligible;
+      continue;
+    }
+
+    if (best == NO_ACTIVE_SENSOR || (long)(due - bestDue) < 0) {
+      best = i;
+      bestDue = due;
+    }
+  }
+
+  // With a ping starting, the next scan happens once it finishes anyway
+  nextScanTime = best == NO_ACTIVE_SENSOR ? earliest : now;
+  return best;
+}
+
+unsigned long SensorManager::pingPeriod(int sensorIndex) {
+  if (travelDirection == 0 || isFacing(sensorIndex, travelDirection > 0)) {
+    return SENSOR_UPDATE_INTERVAL;
+  }
+  return SENSOR_UPDATE_INTERVAL * SENSOR_BEHIND_SLOWDOWN;
+}
+
+uint16_t SensorManager::headingDifference(uint16_t a, uint16_t b) {
+  uint16_t difference = (a > b ? a - b : b - a) % 360;
+  return difference > 180 ? 360 - difference : difference;
+}
+
+void SensorManager::setTravelDirection(int travelSpeed) {
+  int8_t direction = travelSpeed > 0 ? 1 : (travelSpeed < 0 ? -1 : 0);
+  if (direction != travelDirection) {
+    travelDirection = direction;
+    nextScanTime = millis(); // Periods changed - rescan now
+  }
+}
+
+int SensorManager::getSensorCount() { return SENSOR_COUNT; }
+
+bool SensorManager::isFacing(int sensorIndex, bool forward) {
+  if (sensorIndex < 0 || sensorIndex >= SENSOR_COUNT)
+    return false;
+  return headingDifference(SENSOR_LAYOUT[sensorIndex].headingDeg,
+                           forward ? 0 : 180) <= SENSOR_AHEAD_ANGLE;
+}
+
+bool SensorManager::isRangingInProgress() {
+  return activeSensor != NO_ACTIVE_SENSOR;
+}
+
+void SensorManager::attachEchoInterrupt(int echoPin) {
+#if defined(__AVR__)
+  if (digitalPinToPCICR(echoPin) == nullptr) {
+    DEBUG_PRINT_P("⚠ Echo pin has no pin-change interrupt: ");
+    DEBUG_PRINTLN(echoPin);
     return;
+  }
+  *digitalPinToPCMSK(echoPin) |= bit(digitalPinToPCMSKbit(echoPin));
+  PCIFR |= bit(digitalPinToPCICRbit(echoPin));
+  PCICR |= bit(digitalPinToPCICRbit(echoPin));
+#else
+  attachInterrupt(digitalPinToInterrupt(echoPin), sensorEchoISR, CHANGE);
+#endif
+}
 
-  int trigPin, echoPin;
-  if (sensorIndex == FRONT_SENSOR) {
-    trigPin = FRONT_SENSOR_TRIG;
-    echoPin = FRONT_SENSOR_ECHO;
+void SensorManager::handleEchoEdge() {
+  if (echoState != ECHO_WAIT_RISE && echoState != ECHO_WAIT_FALL)
+    return;
+
+#if defined(__AVR__)
+  bool echoHigh = (*echoInputRegister & echoBitMask) != 0;
+#else
+  bool echoHigh = digitalRead(echoPin) == HIGH;
+#endif
+
+  if (echoHigh && echoState == ECHO_WAIT_RISE) {
+    echoStartTime = micros();
+    echoState = ECHO_WAIT_FALL;
+  } else if (!echoHigh && echoState == ECHO_WAIT_FALL) {
+    echoEndTime = micros();
+    echoState = ECHO_DONE;
+  }
+}
+
+void SensorManager::startPing(int sensorIndex) {
+  int trigPin, sensorEchoPin;
+  getSensorPins(sensorIndex, trigPin, sensorEchoPin);
+
+  // Arm the capture state before the trigger so the rising edge is not missed
+  noInterrupts();
+#if defined(__AVR__)
+  echoInputRegister = portInputRegister(digitalPinToPort(sensorEchoPin));
+  echoBitMask = digitalPinToBitMask(sensorEchoPin);
+#else
+  echoPin = sensorEchoPin;
+#endif
+  echoState = ECHO_WAIT_RISE;
+  activeSensor = sensorIndex;
+  interrupts();
+  lastPingTime[sensorIndex] = millis();
+
+  // Send trigger pulse
+  digitalWrite(trigPin, LOW);
+  delayMicroseconds(2);
+  digitalWrite(trigPin, HIGH);
+  delayMicroseconds(10);
+  digitalWrite(trigPin, LOW);
+
+  pingStartTime = micros();
+}
+
+void SensorManager::servicePing() {
+  noInterrupts();
+  uint8_t state = echoState;
+  unsigned long start = echoStartTime;
+  unsigned long end = echoEndTime;
+  interrupts();
+
+  uint16_t distanceMm;
+  if (state == ECHO_DONE) {
+    distanceMm = ECHO_US_TO_MM(end - start);
+  } else if (micros() - pingStartTime >= SENSOR_ECHO_TIMEOUT_US) {
+    distanceMm = SENSOR_NO_ECHO; // Timeout - no echo received
   } else {
-    trigPin = REAR_SENSOR_TRIG;
-    echoPin = REAR_SENSOR_ECHO;
+    return; // Echo still in flight
+  }
+
+  int finishedSensor = activeSensor;
+  noInterrupts();
+  activeSensor = NO_ACTIVE_SENSOR;
+  echoState = ECHO_IDLE;
+  interrupts();
+
+  processReading(finishedSensor, distanceMm);
+
+  // Late reflections of this ping can still reach sensors facing the same
+  // way; hold them off for a while. Others may fire straight away.
+  unsigned long quietEnd = millis() + SENSOR_CROSSTALK_GAP_MS;
+  for (int i = 0; i < SENSOR_COUNT; i++) {
+    if (crosstalkMask[finishedSensor] & (1 << i))
+      quietUntil[i] = quietEnd;
   }
+  nextScanTime = millis();
+}
 
-  // Read distance
-  float distance = readDistance(trigPin, echoPin);
+void SensorManager::getSensorPins(int sensorIndex, int &trigPin,
+                                  int &echoPin) {
+  trigPin = SENSOR_LAYOUT[sensorIndex].trigPin;
+  echoPin = SENSOR_LAYOUT[sensorIndex].echoPin;
+}
 
-  if (isValidReading(distance)) {
-    stabilizeReading(sensorIndex, distance);
+// Blocking one-shot reading used by calibration and test routines
+void SensorManager::updateSensorState(int sensorIndex) {
+  if (sensorIndex < 0 || sensorIndex >= SENSOR_COUNT)
+    return;
+
+  int trigPin, echoPin;
+  getSensorPins(sensorIndex, trigPin, echoPin);
+
+  processReading(sensorIndex, readDistance(trigPin, echoPin));
+}
+
+void SensorManager::processReading(int sensorIndex, uint16_t distanceMm) {
+  if (isValidReading(distanceMm)) {
+    filterReading(sensorIndex, distanceMm);
 
     // Update obstacle detection
     sensors[sensorIndex].isObstacleDetected =
-        (sensors[sensorIndex].lastStableDistance <= warningDistance);
+        (sensors[sensorIndex].stableDistanceMm <= warningDistanceMm);
     sensors[sensorIndex].isCollisionRisk =
-        (sensors[sensorIndex].lastStableDistance <= collisionDistance);
+        (sensors[sensorIndex].stableDistanceMm <= collisionDistanceMm);
     sensors[sensorIndex].lastUpdate = millis();
     sensors[sensorIndex].isActive = true;
 
@@ -164,14 +443,14 @@ void SensorManager::updateSensorState(int sensorIndex) {
         DEBUG_PRINT_P("🚨 ");
         DEBUG_PRINT(sensors[sensorIndex].name);
         DEBUG_PRINT_P(" COLLISION RISK: ");
-        DEBUG_PRINT_VAL("", sensors[sensorIndex].lastStableDistance);
-        DEBUG_PRINTLN_P("cm");
+        DEBUG_PRINT_VAL("", sensors[sensorIndex].stableDistanceMm);
+        DEBUG_PRINTLN_P("mm");
       } else if (sensors[sensorIndex].isObstacleDetected) {
         DEBUG_PRINT_P("⚠ ");
         DEBUG_PRINT(sensors[sensorIndex].name);
         DEBUG_PRINT_P(" obstacle: ");
-        DEBUG_PRINT_VAL("", sensors[sensorIndex].lastStableDistance);
-        DEBUG_PRINTLN_P("cm");
+        DEBUG_PRINT_VAL("", sensors[sensorIndex].stableDistanceMm);
+        DEBUG_PRINTLN_P("mm");
       }
     }
   } else {
@@ -185,7 +464,7 @@ void SensorManager::updateSensorState(int sensorIndex) {
   }
 }
 
-float SensorManager::readDistance(int trigPin, int echoPin) {
+uint16_t SensorManager::readDistance(int trigPin, int echoPin) {
   // Send trigger pulse
   digitalWrite(trigPin, LOW);
   delayMicroseconds(2);
@@ -197,38 +476,33 @@ float SensorManager::readDistance(int trigPin, int echoPin) {
   unsigned long duration = pulseIn(echoPin, HIGH, 30000); // 30ms timeout
 
   if (duration == 0) {
-    return -1; // Timeout - no echo received
+    return SENSOR_NO_ECHO; // Timeout - no echo received
   }
 
-  // Calculate distance in centimeters
-  float distance = (duration * 0.034) / 2;
-
-  return distance;
+  return ECHO_US_TO_MM(duration);
 }
 
-bool SensorManager::isValidReading(float distance) {
-  return (distance > 0 && distance <= MAX_SENSOR_DISTANCE);
+bool SensorManager::isValidReading(uint16_t distanceMm) {
+  return (distanceMm != SENSOR_NO_ECHO &&
+          distanceMm <= CM_TO_MM(MAX_SENSOR_DISTANCE));
 }
 
-void SensorManager::stabilizeReading(int sensorIndex, float newReading) {
+void SensorManager::filterReading(int sensorIndex, uint16_t newReadingMm) {
   SensorState &sensor = sensors[sensorIndex];
+  sensor.currentDistanceMm = newReadingMm;
 
-  // Check if reading is consistent with previous readings
-  if (abs(newReading - sensor.currentDistance) < 5.0) {
-    sensor.stableReadingCount++;
-  } else {
-    sensor.stableReadingCount = 0;
-  }
-
-  sensor.currentDistance = newReading;
-
-  // Update stable distance if we have enough consistent readings
-  if (sensor.stableReadingCount >= SENSOR_STABILIZE_COUNT) {
-    sensor.lastStableDistance = newReading;
+  // Outliers leave the filtered distance where it was
+  if (SensorFilterStage::addSample(sensor.filter, newReadingMm, millis(),
+                                   warningDistanceMm)) {
+    sensor.stableDistanceMm = SensorFilterStage::getDistance(sensor.filter);
   }
 }
 
 void SensorManager::enableSensors() {
+  // History from before the pause would read as a sudden closing rate
+  for (int i = 0; i < SENSOR_COUNT; i++) {
+    SensorFilterStage::reset(sensors[i].filter);
+  }
   sensorsEnabled = true;
   DEBUG_PRINTLN("📡 Sensors enabled");
 }
@@ -236,8 +510,14 @@ void SensorManager::enableSensors() {
 void SensorManager::disableSensors() {
   sensorsEnabled = false;
 
+  // Abandon any echo still in flight
+  noInterrupts();
+  activeSensor = NO_ACTIVE_SENSOR;
+  echoState = ECHO_IDLE;
+  interrupts();
+
   // Clear obstacle flags when disabling
-  for (int i = 0; i < 2; i++) {
+  for (int i = 0; i < SENSOR_COUNT; i++) {
     sensors[i].isObstacleDetected = false;
     sensors[i].isCollisionRisk = false;
   }
@@ -247,19 +527,26 @@ void SensorManager::disableSensors() {
 
 bool SensorManager::areSensorsEnabled() { return sensorsEnabled; }
 
-float SensorManager::getFrontDistance() {
-  return sensors[FRONT_SENSOR].lastStableDistance;
+uint16_t SensorManager::getFrontDistanceMm() {
+  return sensors[FRONT_SENSOR].stableDistanceMm;
 }
 
-float SensorManager::getRearDistance() {
-  return sensors[REAR_SENSOR].lastStableDistance;
+uint16_t SensorManager::getRearDistanceMm() {
+  return sensors[REAR_SENSOR].stableDistanceMm;
+}
+
+uint16_t SensorManager::getDistanceMm(int sensorIndex) {
+  if (sensorIndex >= 0 && sensorIndex < SENSOR_COUNT) {
+    return sensors[sensorIndex].stableDistanceMm;
+  }
+  return SENSOR_NO_ECHO;
 }
 
-float SensorManager::getDistance(int sensorIndex) {
-  if (sensorIndex >= 0 && sensorIndex < 2) {
-    return sensors[sensorIndex].lastStableDistance;
+int16_t SensorManager::getClosingRate(int sensorIndex) {
+  if (sensorIndex >= 0 && sensorIndex < SENSOR_COUNT) {
+    return SensorFilterStage::getClosingRate(sensors[sensorIndex].filter);
   }
-  return -1;
+  return 0;
 }
 
 bool SensorManager::isFrontObstacleDetected() {
@@ -271,7 +558,7 @@ bool SensorManager::isRearObstacleDetected() {
 }
 
 bool SensorManager::isObstacleDetected(int sensorIndex) {
-  if (sensorIndex >= 0 && sensorIndex < 2) {
+  if (sensorIndex >= 0 && sensorIndex < SENSOR_COUNT) {
     return sensorsEnabled && sensors[sensorIndex].isObstacleDetected;
   }
   return false;
@@ -286,30 +573,33 @@ bool SensorManager::isRearCollisionRisk() {
 }
 
 bool SensorManager::isCollisionRisk(int sensorIndex) {
-  if (sensorIndex >= 0 && sensorIndex < 2) {
+  if (sensorIndex >= 0 && sensorIndex < SENSOR_COUNT) {
     return sensorsEnabled && sensors[sensorIndex].isCollisionRisk;
   }
   return false;
 }
 
-void SensorManager::setCollisionDistance(float distance) {
-  collisionDistance = constrain(distance, 5.0, 100.0);
-  DEBUG_PRINTLN("📏 Collision distance set to " + String(collisionDistance) +
-                "cm");
+void SensorManager::setCollisionDistance(int distanceCm) {
+  collisionDistanceMm = CM_TO_MM(constrain(distanceCm, 5, 100));
+  DEBUG_PRINT_P("📏 Collision distance set to ");
+  DEBUG_PRINT(collisionDistanceMm / 10);
+  DEBUG_PRINTLN_P("cm");
 }
 
-void SensorManager::setWarningDistance(float distance) {
-  warningDistance = constrain(distance, 10.0, 200.0);
-  DEBUG_PRINTLN("📏 Warning distance set to " + String(warningDistance) + "cm");
+void SensorManager::setWarningDistance(int distanceCm) {
+  warningDistanceMm = CM_TO_MM(constrain(distanceCm, 10, 200));
+  DEBUG_PRINT_P("📏 Warning distance set to ");
+  DEBUG_PRINT(warningDistanceMm / 10);
+  DEBUG_PRINTLN_P("cm");
 }
 
-float SensorManager::getCollisionDistance() { return collisionDistance; }
+int SensorManager::getCollisionDistance() { return collisionDistanceMm / 10; }
 
-float SensorManager::getWarningDistance() { return warningDistance; }
+int SensorManager::getWarningDistance() { return warningDistanceMm / 10; }
 
 void SensorManager::getSensorStatus(SensorStatus &status) {
-  status.frontDistance = getFrontDistance();
-  status.rearDistance = getRearDistance();
+  status.frontDistanceMm = getFrontDistanceMm();
+  status.rearDistanceMm = getRearDistanceMm();
   status.frontObstacle = isFrontObstacleDetected();
   status.rearObstacle = isRearObstacleDetected();
   status.frontCollisionRisk = isFrontCollisionRisk();
@@ -318,17 +608,20 @@ void SensorManager::getSensorStatus(SensorStatus &status) {
   status.lastUpdate = millis();
 }
 
-void SensorManager::getDetailedStatus(String &statusString) {
-  statusString = "Sensors: ";
-  statusString += "Front=" + String(getFrontDistance(), 1) + "cm";
-  statusString += ", Rear=" + String(getRearDistance(), 1) + "cm";
-  statusString +=
-      " | Obstacles: F=" + String(isFrontObstacleDetected() ? "YES" : "NO");
-  statusString += ", R=" + String(isRearObstacleDetected() ? "YES" : "NO");
-  statusString +=
-      " | Collision Risk: F=" + String(isFrontCollisionRisk() ? "YES" : "NO");
-  statusString += ", R=" + String(isRearCollisionRisk() ? "YES" : "NO");
-  statusString += " | Active: " + String(sensorsEnabled ? "YES" : "NO");
+void SensorManager::getDetailedStatus(char *buffer, size_t bufferSize) {
+  StringBuilder status(buffer, bufferSize);
+  status.append_P(PSTR("Sensors: "));
+  for (int i = 0; i < SENSOR_COUNT; i++) {
+    status.appendf_P(i ? PSTR(", %s=%umm") : PSTR("%s=%umm"), sensors[i].name,
+                     sensors[i].stableDistanceMm);
+  }
+  status.appendf_P(PSTR(" | Obstacles: F=%s, R=%s"),
+                   isFrontObstacleDetected() ? "YES" : "NO",
+                   isRearObstacleDetected() ? "YES" : "NO");
+  status.appendf_P(PSTR(" | Collision Risk: F=%s, R=%s"),
+                   isFrontCollisionRisk() ? "YES" : "NO",
+                   isRearCollisionRisk() ? "YES" : "NO");
+  status.appendf_P(PSTR(" | Active: %s"), sensorsEnabled ? "YES" : "NO");
 }
 
 bool SensorManager::areSensorsHealthy() {
@@ -336,7 +629,7 @@ bool SensorManager::areSensorsHealthy() {
     return true; // Consider disabled sensors as "healthy"
 
   unsigned long currentTime = millis();
-  for (int i = 0; i < 2; i++) {
+  for (int i = 0; i < SENSOR_COUNT; i++) {
     if (!sensors[i].isActive || (currentTime - sensors[i].lastUpdate > 2000)) {
       return false; // Sensor not responding
     }
@@ -371,31 +664,46 @@ void SensorManager::calibrateSensors() {
   DEBUG_PRINTLN("🔧 Calibrating sensors...");
 
   // Take multiple readings and average them
-  float frontTotal = 0, rearTotal = 0;
-  int validReadings = 0;
-
-  for (int i = 0; i < 10; i++) {
-    float frontDist = readDistance(FRONT_SENSOR_TRIG, FRONT_SENSOR_ECHO);
-    float rearDist = readDistance(REAR_SENSOR_TRIG, REAR_SENSOR_ECHO);
-
-    if (isValidReading(frontDist) && isValidReading(rearDist)) {
-      frontTotal += frontDist;
-      rearTotal += rearDist;
-      validReadings++;
+  unsigned long totals[SENSOR_COUNT] = {0};
+  uint8_t validReadings[SENSOR_COUNT] = {0};
+  bool calibrated = false;
+
+  extern void kickWatchdog();
+  for (int round = 0; round < 10; round++) {
+    kickWatchdog(); // ~3s in all, longer than the watchdog timeout
+    for (int i = 0; i < SENSOR_COUNT; i++) {
+      int trigPin, echoPin;
+      getSensorPins(i, trigPin, echoPin);
+      uint16_t distance = readDistance(trigPin, echoPin);
+
+      if (isValidReading(distance)) {
+        totals[i] += distance;
+        validReadings[i]++;
+      }
+      delay(SENSOR_CROSSTALK_GAP_MS); // Let the echo die down
     }
 
     delay(100);
   }
 
-  if (validReadings > 0) {
-    sensors[FRONT_SENSOR].lastStableDistance = frontTotal / validReadings;
-    sensors[REAR_SENSOR].lastStableDistance = rearTotal / validReadings;
+  // Restart the filters from the calibrated averages
+  for (int i = 0; i < SENSOR_COUNT; i++) {
+    DEBUG_PRINT_P("   ");
+    DEBUG_PRINT(sensors[i].name);
+    if (validReadings[i] == 0) {
+      DEBUG_PRINTLN_P(": no valid readings");
+      continue;
+    }
+
+    SensorFilterStage::reset(sensors[i].filter);
+    filterReading(i, totals[i] / validReadings[i]);
+    calibrated = true;
+    DEBUG_PRINT_VAL(": ", sensors[i].stableDistanceMm);
+    DEBUG_PRINTLN_P("mm");
+  }
 
+  if (calibrated) {
     DEBUG_PRINTLN("✅ Calibration complete");
-    DEBUG_PRINTLN("   Front: " +
-                  String(sensors[FRONT_SENSOR].lastStableDistance, 1) + "cm");
-    DEBUG_PRINTLN("   Rear: " +
-                  String(sensors[REAR_SENSOR].lastStableDistance, 1) + "cm");
   } else {
     DEBUG_PRINTLN("❌ Calibration failed - no valid readings");
   }
@@ -403,38 +711,46 @@ void SensorManager::calibrateSensors() {
 
 void SensorManager::testSensors() {
   DEBUG_PRINTLN("🧪 Testing all sensors...");
-  testSensor(FRONT_SENSOR);
-  testSensor(REAR_SENSOR);
+  for (int i = 0; i < SENSOR_COUNT; i++) {
+    testSensor(i);
+  }
   DEBUG_PRINTLN("✅ Sensor test complete");
 }
 
 void SensorManager::testSensor(int sensorIndex) {
-  if (sensorIndex < 0 || sensorIndex >= 2)
+  if (sensorIndex < 0 || sensorIndex >= SENSOR_COUNT)
     return;
 
   DEBUG_PRINT_P("Testing ");
   DEBUG_PRINT(sensors[sensorIndex].name);
   DEBUG_PRINTLN_P(" sensor...");
 
+  extern void kickWatchdog();
   for (int i = 0; i < 5; i++) {
     updateSensorState(sensorIndex);
     DEBUG_PRINT_P("  Reading ");
     DEBUG_PRINT(i + 1);
     DEBUG_PRINT_P(": ");
-    DEBUG_PRINT_VAL("", sensors[sensorIndex].currentDistance);
-    DEBUG_PRINTLN_P("cm");
+    DEBUG_PRINT_VAL("", sensors[sensorIndex].currentDistanceMm);
+    DEBUG_PRINT_P("mm ");
 
     if (sensors[sensorIndex].isCollisionRisk) {
-      DEBUG_PRINT(" [COLLISION RISK]");
+      DEBUG_PRINT("[COLLISION RISK]");
     } else if (sensors[sensorIndex].isObstacleDetected) {
-      DEBUG_PRINT(" [OBSTACLE]");
+      DEBUG_PRINT("[OBSTACLE]");
     } else {
-      DEBUG_PRINT(" [CLEAR]");
+      DEBUG_PRINT("[CLEAR]");
     }
 
     DEBUG_PRINTLN("");
+    kickWatchdog();
     delay(200);
   }
 }
 
+size_t SensorManager::getRamUsage() {
+  return sizeof(sensors) + sizeof(lastPingTime) + sizeof(quietUntil) +
+         sizeof(crosstalkMask);
+}
+
 #endif // SENSOR_MANAGER_H
@@ -10,9 +10,8 @@
 #include "config.h"
 #include "memory_optimization.h"
 #include "sensor_manager.h"
+#include "telemetry.h"
 
-// Forward declaration to avoid circular dependency
-extern void sendBluetoothMessage(const char *message);
 
 class SensorStatusManager {
 private:
@@ -25,9 +24,8 @@ private:
 
   // Private helper methods
   static void updateCurrentStatus();
-  static String formatStatusForFlutter();
-  static String formatDetailedStatus();
   static void sendStatusUpdate();
+  static void publishTelemetry();
 
 public:
   // Initialize sensor status manager
@@ -55,14 +53,14 @@ public:
 
   // Status data access
   static SensorStatus getCurrentStatus();
-  static float getFrontDistance();
-  static float getRearDistance();
+  static uint16_t getFrontDistanceMm();
+  static uint16_t getRearDistanceMm();
   static bool hasObstacles();
   static bool hasCollisionRisk();
 
   // Flutter app specific formatting
   static void formatForFlutterDashboard(char *buffer, size_t bufferSize);
-  static void formatCollisionWarning(const char *sensor, float distance,
+  static void formatCollisionWarning(const char *sensor, uint16_t distanceMm,
                                      char *buffer, size_t bufferSize);
   static void formatSensorHealthCheck(char *buffer, size_t bufferSize);
 
@@ -72,7 +70,7 @@ public:
 };
 
 // Implementation
-SensorStatus SensorStatusManager::currentStatus = {0.0,   0.0,   false, false,
+SensorStatus SensorStatusManager::currentStatus = {0,     0,     false, false,
                                                    false, false, false, 0};
 unsigned long SensorStatusManager::lastStatusUpdate = 0;
 unsigned long SensorStatusManager::lastStatusSent = 0;
@@ -84,8 +82,8 @@ void SensorStatusManager::init() {
   DEBUG_PRINTLN_P("Initializing Sensor Status Manager...");
 
   // Initialize status structure
-  currentStatus.frontDistance = 0.0;
-  currentStatus.rearDistance = 0.0;
+  currentStatus.frontDistanceMm = 0;
+  currentStatus.rearDistanceMm = 0;
   currentStatus.frontObstacle = false;
   currentStatus.rearObstacle = false;
   currentStatus.frontCollisionRisk = false;
@@ -118,9 +116,9 @@ void SensorStatusManager::update() {
     lastStatusUpdate = currentTime;
   }
 
-  // Send status updates if auto-send is enabled
+  // Publish changed readings if auto-send is enabled
   if (autoSendEnabled && (currentTime - lastStatusSent >= statusSendInterval)) {
-    sendStatusUpdate();
+    publishTelemetry();
     lastStatusSent = currentTime;
   }
 }
@@ -135,7 +133,29 @@ void SensorStatusManager::updateCurrentStatus() {
   }
 }
 
+void SensorStatusManager::publishTelemetry() {
+  int16_t values[TELEMETRY_FIELD_COUNT];
+  values[TELEMETRY_FRONT_MM] = currentStatus.frontDistanceMm;
+  values[TELEMETRY_REAR_MM] = currentStatus.rearDistanceMm;
+
+  uint8_t flags = 0;
+  if (currentStatus.frontObstacle)
+    flags |= TELEMETRY_FLAG_FRONT_OBSTACLE;
+  if (currentStatus.rearObstacle)
+    flags |= TELEMETRY_FLAG_REAR_OBSTACLE;
+  if (currentStatus.frontCollisionRisk)
+    flags |= TELEMETRY_FLAG_FRONT_RISK;
+  if (currentStatus.rearCollisionRisk)
+    flags |= TELEMETRY_FLAG_REAR_RISK;
+  if (currentStatus.sensorsActive)
+    flags |= TELEMETRY_FLAG_SENSORS_ACTIVE;
+  values[TELEMETRY_FLAGS] = flags;
+
+  TelemetryPublisher::publish(values);
+}
+
 void SensorStatusManager::enableAutoSend() {
+  TelemetryPublisher::requestKeyframe(); // App may have missed earlier frames
   autoSendEnabled = true;
   DEBUG_PRINTLN("📊 Auto-send status updates ENABLED");
 }
@@ -155,37 +175,29 @@ void SensorStatusManager::sendStatusNow() {
 void SensorStatusManager::sendDetailedStatus() {
   updateCurrentStatus();
 
-  if (MessageBuffer::isAvailable()) {
-    char *buffer = MessageBuffer::getBuffer();
-    getDetailedStatusBuffer(buffer, MAX_MESSAGE_LENGTH);
-
-    TempString<MAX_MESSAGE_LENGTH + 50>
-        message; // Extra buffer for "SENSOR_DETAILED:" prefix
-    message.printf_P(PSTR("SENSOR_DETAILED:%s"), buffer);
-
+  MessageHandle message(MAX_MESSAGE_LENGTH);
+  if (message) {
+    // Prefix and body share the pool slot - no second copy on the stack
+    int length = message.printf_P(PSTR("SENSOR_DETAILED:"));
+    getDetailedStatusBuffer(message.get() + length, message.size() - length);
     sendBluetoothMessage(message.get());
-    MessageBuffer::releaseBuffer();
   }
 }
 
 void SensorStatusManager::sendStatusUpdate() {
-  if (MessageBuffer::isAvailable()) {
-    char *buffer = MessageBuffer::getBuffer();
-    getStatusBuffer(buffer, MAX_MESSAGE_LENGTH);
-
-    TempString<MAX_MESSAGE_LENGTH + 50>
-        message; // Extra buffer for "SENSOR_STATUS:" prefix
-    message.printf_P(PSTR("SENSOR_STATUS:%s"), buffer);
-
+  MessageHandle message(MAX_MESSAGE_LENGTH);
+  if (message) {
+    // Prefix and body share the pool slot - no second copy on the stack
+    int length = message.printf_P(PSTR("SENSOR_STATUS:"));
+    getStatusBuffer(message.get() + length, message.size() - length);
     sendBluetoothMessage(message.get());
-    MessageBuffer::releaseBuffer();
   }
 }
 
 void SensorStatusManager::getStatusBuffer(char *buffer, size_t bufferSize) {
   char frontStr[8], rearStr[8];
-  formatFloat(currentStatus.frontDistance, frontStr, sizeof(frontStr), 1);
-  formatFloat(currentStatus.rearDistance, rearStr, sizeof(rearStr), 1);
+  formatDistance(currentStatus.frontDistanceMm, frontStr, sizeof(frontStr));
+  formatDistance(currentStatus.rearDistanceMm, rearStr, sizeof(rearStr));
 
   snprintf_P(buffer, bufferSize,
              PSTR("{\"f\":%s,\"r\":%s,\"fo\":%s,\"ro\":%s,\"fr\":%s,\"rr\":%s,"
@@ -200,8 +212,8 @@ void SensorStatusManager::getStatusBuffer(char *buffer, size_t bufferSize) {
 void SensorStatusManager::getDetailedStatusBuffer(char *buffer,
                                                   size_t bufferSize) {
   char frontStr[8], rearStr[8];
-  formatFloat(currentStatus.frontDistance, frontStr, sizeof(frontStr), 1);
-  formatFloat(currentStatus.rearDistance, rearStr, sizeof(rearStr), 1);
+  formatDistance(currentStatus.frontDistanceMm, frontStr, sizeof(frontStr));
+  formatDistance(currentStatus.rearDistanceMm, rearStr, sizeof(rearStr));
 
   // Simplified detailed status to fit in buffer
   snprintf_P(
@@ -218,8 +230,11 @@ void SensorStatusManager::getDetailedStatusBuffer(char *buffer,
 void SensorStatusManager::formatForFlutterDashboard(char *buffer,
                                                     size_t bufferSize) {
   char frontStr[8], rearStr[8];
-  formatFloat(currentStatus.frontDistance, frontStr, sizeof(frontStr), 0);
-  formatFloat(currentStatus.rearDistance, rearStr, sizeof(rearStr), 0);
+  // Whole centimetres, rounded
+  snprintf_P(frontStr, sizeof(frontStr), PSTR("%u"),
+             (currentStatus.frontDistanceMm + 5) / 10);
+  snprintf_P(rearStr, sizeof(rearStr), PSTR("%u"),
+             (currentStatus.rearDistanceMm + 5) / 10);
 
   const char *status;
   if (currentStatus.frontCollisionRisk || currentStatus.rearCollisionRisk) {
@@ -235,10 +250,11 @@ void SensorStatusManager::formatForFlutterDashboard(char *buffer,
 }
 
 void SensorStatusManager::formatCollisionWarning(const char *sensor,
-                                                 float distance, char *buffer,
+                                                 uint16_t distanceMm,
+                                                 char *buffer,
                                                  size_t bufferSize) {
   // This function is now implemented in memory_optimization.h
-  ::formatCollisionMessage(sensor, distance, buffer, bufferSize);
+  ::formatCollisionMessage(sensor, distanceMm, buffer, bufferSize);
 }
 
 void SensorStatusManager::formatSensorHealthCheck(char *buffer,
@@ -262,8 +278,9 @@ void SensorStatusManager::setUpdateInterval(int intervalMs) {
 
 void SensorStatusManager::setSendInterval(int intervalMs) {
   statusSendInterval = constrain(intervalMs, 100, 5000);
-  DEBUG_PRINTLN("📊 Status send interval set to " + String(statusSendInterval) +
-                "ms");
+  DEBUG_PRINT_P("📊 Status send interval set to ");
+  DEBUG_PRINT(statusSendInterval);
+  DEBUG_PRINTLN_P("ms");
 }
 
 int SensorStatusManager::getUpdateInterval() { return statusUpdateInterval; }
@@ -272,12 +289,12 @@ int SensorStatusManager::getSendInterval() { return statusSendInterval; }
 
 SensorStatus SensorStatusManager::getCurrentStatus() { return currentStatus; }
 
-float SensorStatusManager::getFrontDistance() {
-  return currentStatus.frontDistance;
+uint16_t SensorStatusManager::getFrontDistanceMm() {
+  return currentStatus.frontDistanceMm;
 }
 
-float SensorStatusManager::getRearDistance() {
-  return currentStatus.rearDistance;
+uint16_t SensorStatusManager::getRearDistanceMm() {
+  return currentStatus.rearDistanceMm;
 }
 
 bool SensorStatusManager::hasObstacles() {
@@ -291,37 +308,26 @@ bool SensorStatusManager::hasCollisionRisk() {
 void SensorStatusManager::sendDiagnosticData() {
   DEBUG_PRINTLN_P("📊 Sending diagnostic data...");
 
-  // Send sensor readings using buffer
-  if (MessageBuffer::isAvailable()) {
-    char *buffer = MessageBuffer::getBuffer();
-    getDetailedStatusBuffer(buffer, MAX_MESSAGE_LENGTH);
-
-    TempString<MAX_MESSAGE_LENGTH + 30> message;
-    message.printf_P(PSTR("DIAGNOSTIC_SENSORS:%s"), buffer);
-    sendBluetoothMessage(message.get());
-    MessageBuffer::releaseBuffer();
-  }
-
-  // Send collision avoidance status using buffer
-  if (MessageBuffer::isAvailable()) {
-    char *buffer = MessageBuffer::getBuffer();
-    CollisionAvoidance::getStatus(buffer, MAX_MESSAGE_LENGTH);
-
-    TempString<MAX_MESSAGE_LENGTH + 30> message;
-    message.printf_P(PSTR("DIAGNOSTIC_COLLISION:%s"), buffer);
-    sendBluetoothMessage(message.get());
-    MessageBuffer::releaseBuffer();
-  }
-
-  // Send sensor health using buffer
-  if (MessageBuffer::isAvailable()) {
-    char *buffer = MessageBuffer::getBuffer();
-    formatSensorHealthCheck(buffer, MAX_MESSAGE_LENGTH);
-
-    TempString<MAX_MESSAGE_LENGTH + 30> message;
-    message.printf_P(PSTR("DIAGNOSTIC_HEALTH:%s"), buffer);
-    sendBluetoothMessage(message.get());
-    MessageBuffer::releaseBuffer();
+  // One pooled buffer for all three reports
+  MessageHandle message(MAX_MESSAGE_LENGTH);
+  if (message) {
+    char *buffer = message.get();
+    size_t size = message.size();
+
+    // Send sensor readings
+    int length = message.printf_P(PSTR("DIAGNOSTIC_SENSORS:"));
+    getDetailedStatusBuffer(buffer + length, size - length);
+    sendBluetoothMessage(buffer);
+
+    // Send collision avoidance status
+    length = message.printf_P(PSTR("DIAGNOSTIC_COLLISION:"));
+    CollisionAvoidance::getStatus(buffer + length, size - length);
+    sendBluetoothMessage(buffer);
+
+    // Send sensor health
+    length = message.printf_P(PSTR("DIAGNOSTIC_HEALTH:"));
+    formatSensorHealthCheck(buffer + length, size - length);
+    sendBluetoothMessage(buffer);
   }
 
   DEBUG_PRINTLN_P("✅ Diagnostic data sent");
@@ -334,18 +340,17 @@ void SensorStatusManager::testSensorCommunication() {
   sendBluetoothMessage("SENSOR_TEST_START");
 
   // Send multiple status updates
+  extern void kickWatchdog();
   for (int i = 0; i < 5; i++) {
     updateCurrentStatus();
 
-    if (MessageBuffer::isAvailable()) {
-      char *buffer = MessageBuffer::getBuffer();
-      getStatusBuffer(buffer, MAX_MESSAGE_LENGTH);
-
-      TempString<MAX_MESSAGE_LENGTH + 30> message;
-      message.printf_P(PSTR("SENSOR_TEST_%d:%s"), i, buffer);
+    MessageHandle message(MAX_MESSAGE_LENGTH);
+    if (message) {
+      int length = message.printf_P(PSTR("SENSOR_TEST_%d:"), i);
+      getStatusBuffer(message.get() + length, message.size() - length);
       sendBluetoothMessage(message.get());
-      MessageBuffer::releaseBuffer();
     }
+    kickWatchdog();
     delay(200);
   }
 
@@ -7,6 +7,7 @@
 #define SERVO_ARM_H
 
 #include "config.h"
+#include "debug_log.h"
 #include "utils.h"
 #ifdef ESP32
   #include <ESP32Servo.h>
@@ -14,6 +15,26 @@
   #include <Servo.h>
 #endif
 
+// Fixed-point trajectory progress: 0..SERVO_PROGRESS_ONE over a segment
+#define SERVO_PROGRESS_SHIFT 12
+#define SERVO_PROGRESS_ONE (1L << SERVO_PROGRESS_SHIFT)
+
+// A queued arm pose - ARM_HOLD leaves a joint where it is
+struct ArmWaypoint {
+  uint8_t angles[6];
+  uint16_t durationMs; // 0 = derive from the movement speed
+};
+
+// Preset poses, indexed by preset number (0 = home)
+const uint8_t ARM_POSES[4][6] PROGMEM = {
+    {90, 90, 90, 90, 40, 90},                    // Home
+    {90, 60, 60, ARM_HOLD, ARM_HOLD, 180},       // Pickup
+    {90, 90, 90, ARM_HOLD, ARM_HOLD, ARM_HOLD},  // Place
+    {90, 150, 150, ARM_HOLD, ARM_HOLD, ARM_HOLD} // Rest
+};
+
+#define ARM_POSE_COUNT (sizeof(ARM_POSES) / sizeof(ARM_POSES[0]))
+
 class ServoArm {
 private:
   static Servo servos[6];
@@ -21,11 +42,46 @@ private:
   static int servoMovementSpeed;
   static bool armEnabled;
 
+  static ArmWaypoint waypoints[SERVO_WAYPOINT_QUEUE_SIZE];
+  static uint8_t waypointHead;
+  static uint8_t waypointCount;
+
+  static uint16_t angleToPulse(int angle);
+  static int pulseToAngle(uint16_t pulse);
+  static uint16_t durationForTravel(int degrees);
+  static void startSegment(int servoIndex, int angle, uint16_t durationMs);
+  static void startMove(const uint8_t *angles, uint16_t durationMs);
+  static void loadPose(int presetNumber, uint8_t *angles);
+  static void holdPosition();
+  static void runFor(unsigned long duration);
+
 public:
-  static void init();
+  // Attach the servos and home the arm. A warm restart passes the pulses
+  // it had before the reset; the arm then holds there instead of homing.
+  static void init(const uint16_t *resumePulses = nullptr);
   static void update();
   static void setServoAngle(int servoIndex, int angle);
   static int getServoAngle(int servoIndex);
+
+  // Pulse last written to each of the 6 servos (us)
+  static void getPulses(uint16_t *pulses);
+
+  // Coordinated move: every listed joint arrives after durationMs
+  // (0 = paced by the slowest joint at the movement speed). Cancels any
+  // queued waypoints.
+  static void moveTo(const uint8_t *angles, uint16_t durationMs);
+
+  // Append a pose to run once the current move finishes.
+  // Returns false if the queue is full.
+  static bool queueWaypoint(const uint8_t *angles, uint16_t durationMs);
+  static bool queuePreset(int presetNumber, uint16_t durationMs);
+  static void clearWaypoints();
+  static uint8_t getWaypointCount();
+
+  // Static RAM of the servo objects, their state and the waypoint queue
+  static size_t getRamUsage();
+  static bool isMoving();
+
   static void moveToHome();
   static void moveToPreset(int presetNumber);
   static void openGripper();
@@ -34,7 +90,7 @@ public:
   static void disableArm();
   static void stopAll();
   static void setMovementSpeed(int speed);
-  static void getStatus(String &statusString);
+  static int getMovementSpeed();
   static void getStatus(char *buffer, size_t bufferSize);
   static void testAllServos();
   static void calibrateServos();
@@ -42,58 +98,159 @@ public:
 };
 
 Servo ServoArm::servos[6];
+// At its default angle with no trajectory under way
+#define SERVO_AT_REST(angle) {angle, angle, false, 0, 0, 0, 0, 0, 0}
 ServoState ServoArm::servoStates[6] = {
-    {SERVO_BASE_DEFAULT, SERVO_BASE_DEFAULT, false, 0},
-    {SERVO_SHOULDER_DEFAULT, SERVO_SHOULDER_DEFAULT, false, 0},
-    {SERVO_ELBOW_DEFAULT, SERVO_ELBOW_DEFAULT, false, 0},
-    {SERVO_WRIST_ROT_DEFAULT, SERVO_WRIST_ROT_DEFAULT, false, 0},
-    {SERVO_WRIST_TILT_DEFAULT, SERVO_WRIST_TILT_DEFAULT, false, 0},
-    {SERVO_GRIPPER_DEFAULT, SERVO_GRIPPER_DEFAULT, false, 0}};
+    SERVO_AT_REST(SERVO_BASE_DEFAULT),
+    SERVO_AT_REST(SERVO_SHOULDER_DEFAULT),
+    SERVO_AT_REST(SERVO_ELBOW_DEFAULT),
+    SERVO_AT_REST(SERVO_WRIST_ROT_DEFAULT),
+    SERVO_AT_REST(SERVO_WRIST_TILT_DEFAULT),
+    SERVO_AT_REST(SERVO_GRIPPER_DEFAULT)};
 
 int ServoArm::servoMovementSpeed = SERVO_SPEED_NORMAL;
 bool ServoArm::armEnabled = false;
 
-void ServoArm::init() {
+ArmWaypoint ServoArm::waypoints[SERVO_WAYPOINT_QUEUE_SIZE];
+uint8_t ServoArm::waypointHead = 0;
+uint8_t ServoArm::waypointCount = 0;
+
+void ServoArm::init(const uint16_t *resumePulses) {
   DEBUG_PRINTLN("🦾 Initializing Servo Arm...");
 
-  servos[0].attach(SERVO_BASE);
-  servos[1].attach(SERVO_SHOULDER);
-  servos[2].attach(SERVO_ELBOW);
-  servos[3].attach(SERVO_WRIST_ROT);
-  servos[4].attach(SERVO_WRIST_TILT);
-  servos[5].attach(SERVO_GRIPPER);
+  const uint8_t pins[6] = {SERVO_BASE,      SERVO_SHOULDER,   SERVO_ELBOW,
+                           SERVO_WRIST_ROT, SERVO_WRIST_TILT, SERVO_GRIPPER};
+  for (int i = 0; i < 6; i++) {
+    ServoState &state = servoStates[i];
+    if (resumePulses) {
+      state.currentPulse = constrain(resumePulses[i], SERVO_MIN_PULSE_US,
+                                     SERVO_MAX_PULSE_US);
+      state.currentAngle = pulseToAngle(state.currentPulse);
+      state.targetAngle = state.currentAngle;
+    } else {
+      state.currentPulse = angleToPulse(state.currentAngle);
+    }
+    state.startPulse = state.currentPulse;
+    state.endPulse = state.currentPulse;
+    state.moveDuration = 0;
+
+    // Set the pulse before attaching so the first output is the known one
+    servos[i].writeMicroseconds(state.currentPulse);
+    servos[i].attach(pins[i], SERVO_MIN_PULSE_US, SERVO_MAX_PULSE_US);
+  }
 
-  moveToHome();
   armEnabled = true;
+  if (resumePulses) {
+    DEBUG_PRINTLN_P("🦾 Arm pose resumed - homing skipped");
+  } else {
+    moveToHome();
+  }
 
   DEBUG_PRINTLN("✅ Servo Arm initialized");
 }
 
+uint16_t ServoArm::angleToPulse(int angle) {
+  angle = CONSTRAIN_ANGLE(angle);
+  return SERVO_MIN_PULSE_US +
+         (long)angle * (SERVO_MAX_PULSE_US - SERVO_MIN_PULSE_US) /
+             SERVO_MAX_ANGLE;
+}
+
+int ServoArm::pulseToAngle(uint16_t pulse) {
+  // Rounded to the nearest degree
+  const long span = SERVO_MAX_PULSE_US - SERVO_MIN_PULSE_US;
+  return ((long)(pulse - SERVO_MIN_PULSE_US) * SERVO_MAX_ANGLE + span / 2) /
+         span;
+}
+
+uint16_t ServoArm::durationForTravel(int degrees) {
+  // Movement speed is in units of 100 degrees/second
+  return (uint16_t)abs(degrees) * 10 / servoMovementSpeed;
+}
+
+void ServoArm::startSegment(int servoIndex, int angle, uint16_t durationMs) {
+  ServoState &state = servoStates[servoIndex];
+  angle = CONSTRAIN_ANGLE(angle);
+
+  state.targetAngle = angle;
+  state.startPulse = state.currentPulse;
+  state.endPulse = angleToPulse(angle);
+  state.moveStart = micros();
+  state.moveDuration =
+      (unsigned long)min(durationMs, (uint16_t)SERVO_MAX_MOVE_MS) * 1000UL;
+
+  if (state.startPulse == state.endPulse) {
+    state.moveDuration = 0;
+  }
+  state.isMoving = state.moveDuration > 0;
+}
+
+void ServoArm::startMove(const uint8_t *angles, uint16_t durationMs) {
+  if (durationMs == 0) {
+    // Pace the whole move by the joint with the furthest to go
+    int travel = 0;
+    for (int i = 0; i < 6; i++) {
+      if (angles[i] != ARM_HOLD) {
+        travel = max(travel, abs(CONSTRAIN_ANGLE(angles[i]) -
+                                 servoStates[i].currentAngle));
+      }
+    }
+    durationMs = durationForTravel(travel);
+  }
+
+  for (int i = 0; i < 6; i++) {
+    if (angles[i] != ARM_HOLD) {
+      startSegment(i, angles[i], durationMs);
+    }
+  }
+
+  LOG_DEBUG(SERVO, LOG_MSG_ARM_MOVE, durationMs);
+}
+
 void ServoArm::update() {
   if (!armEnabled)
     return;
 
+  unsigned long now = micros();
+
   for (int i = 0; i < 6; i++) {
-    if (servoStates[i].currentAngle != servoStates[i].targetAngle) {
-      int diff = servoStates[i].targetAngle - servoStates[i].currentAngle;
-      if (abs(diff) <= servoMovementSpeed) {
-        servoStates[i].currentAngle = servoStates[i].targetAngle;
-        servoStates[i].isMoving = false;
-      } else {
-        servoStates[i].currentAngle +=
-            (diff > 0) ? servoMovementSpeed : -servoMovementSpeed;
-        servoStates[i].isMoving = true;
-      }
-      servos[i].write(servoStates[i].currentAngle);
-
-      if (DEBUG_SERVO) {
-        DEBUG_PRINT_P("🦾 Servo ");
-        DEBUG_PRINT(getServoName(i));
-        DEBUG_PRINT_P(": ");
-        DEBUG_PRINT_VAL("", servoStates[i].currentAngle);
-        DEBUG_PRINTLN_P("°");
-      }
+    ServoState &state = servoStates[i];
+    uint16_t pulse = state.endPulse;
+
+    unsigned long elapsed = now - state.moveStart;
+    if (state.moveDuration > 0 && elapsed < state.moveDuration) {
+      // Q12 progress; both terms are pre-shifted so a 10s move in
+      // microseconds still fits 32 bits
+      long progress = ((elapsed >> 4) << SERVO_PROGRESS_SHIFT) /
+                      (state.moveDuration >> 4);
+#if SERVO_EASING_ENABLED
+      // Smoothstep 3p^2 - 2p^3: zero velocity at both ends
+      long squared = (progress * progress) >> SERVO_PROGRESS_SHIFT;
+      progress = (squared * (3 * SERVO_PROGRESS_ONE - 2 * progress)) >>
+                 SERVO_PROGRESS_SHIFT;
+#endif
+      long delta = (long)state.endPulse - state.startPulse;
+      pulse = state.startPulse + ((delta * progress) >> SERVO_PROGRESS_SHIFT);
+    } else if (state.isMoving) {
+      state.isMoving = false;
+      state.moveDuration = 0;
+      LOG_DEBUG(SERVO, LOG_MSG_SERVO_ARRIVED, i + 1, state.targetAngle);
     }
+
+    if (pulse != state.currentPulse) {
+      state.currentPulse = pulse;
+      state.currentAngle = pulseToAngle(pulse);
+      state.lastUpdate = millis();
+      servos[i].writeMicroseconds(pulse);
+    }
+  }
+
+  // Start the next waypoint once every joint has arrived
+  if (waypointCount > 0 && !isMoving()) {
+    const ArmWaypoint &next = waypoints[waypointHead];
+    startMove(next.angles, next.durationMs);
+    waypointHead = (waypointHead + 1) % SERVO_WAYPOINT_QUEUE_SIZE;
+    waypointCount--;
   }
 }
 
@@ -101,15 +258,12 @@ void ServoArm::setServoAngle(int servoIndex, int angle) {
   if (servoIndex < 0 || servoIndex >= 6 || !armEnabled)
     return;
   angle = CONSTRAIN_ANGLE(angle);
-  servoStates[servoIndex].targetAngle = angle;
-
-  if (DEBUG_SERVO) {
-    DEBUG_PRINT_P("🎯 Setting ");
-    DEBUG_PRINT(getServoName(servoIndex));
-    DEBUG_PRINT_P(" target to ");
-    DEBUG_PRINT_VAL("", angle);
-    DEBUG_PRINTLN_P("°");
-  }
+
+  uint16_t durationMs =
+      durationForTravel(angle - servoStates[servoIndex].currentAngle);
+  startSegment(servoIndex, angle, durationMs);
+
+  LOG_DEBUG(SERVO, LOG_MSG_SERVO_TARGET, servoIndex + 1, angle, durationMs);
 }
 
 int ServoArm::getServoAngle(int servoIndex) {
@@ -119,52 +273,83 @@ int ServoArm::getServoAngle(int servoIndex) {
   return -1;
 }
 
+void ServoArm::getPulses(uint16_t *pulses) {
+  for (int i = 0; i < 6; i++) {
+    pulses[i] = servoStates[i].currentPulse;
+  }
+}
+
+void ServoArm::moveTo(const uint8_t *angles, uint16_t durationMs) {
+  if (!armEnabled)
+    return;
+  clearWaypoints();
+  startMove(angles, durationMs);
+}
+
+bool ServoArm::queueWaypoint(const uint8_t *angles, uint16_t durationMs) {
+  if (!armEnabled || waypointCount >= SERVO_WAYPOINT_QUEUE_SIZE)
+    return false;
+
+  ArmWaypoint &waypoint =
+      waypoints[(waypointHead + waypointCount) % SERVO_WAYPOINT_QUEUE_SIZE];
+  memcpy(waypoint.angles, angles, sizeof(waypoint.angles));
+  waypoint.durationMs = durationMs;
+  waypointCount++;
+
+  LOG_DEBUG(SERVO, LOG_MSG_ARM_WAYPOINT, waypointCount);
+  return true;
+}
+
+bool ServoArm::queuePreset(int presetNumber, uint16_t durationMs) {
+  uint8_t angles[6];
+  loadPose(presetNumber, angles);
+  return queueWaypoint(angles, durationMs);
+}
+
+void ServoArm::clearWaypoints() {
+  waypointHead = 0;
+  waypointCount = 0;
+}
+
+uint8_t ServoArm::getWaypointCount() { return waypointCount; }
+
+bool ServoArm::isMoving() {
+  for (int i = 0; i < 6; i++) {
+    if (servoStates[i].isMoving)
+      return true;
+  }
+  return false;
+}
+
+void ServoArm::loadPose(int presetNumber, uint8_t *angles) {
+  // Unknown presets fall back to home
+  if (presetNumber < 0 || presetNumber >= (int)ARM_POSE_COUNT) {
+    presetNumber = 0;
+  }
+  memcpy_P(angles, ARM_POSES[presetNumber], 6);
+}
+
 void ServoArm::moveToHome() {
-  DEBUG_PRINTLN("🏠 Moving arm to home position");
-  // for (int i = 0; i < 6; i++) {
-  //   setServoAngle(i, 90);
-  // }
-  setServoAngle(0, 90);
-  setServoAngle(1, 90);
-  setServoAngle(2, 90);
-  setServoAngle(3, 90);
-  setServoAngle(4, 40);
-  setServoAngle(5, 90);
+  LOG_INFO(SERVO, LOG_MSG_ARM_HOME);
+  uint8_t angles[6];
+  loadPose(0, angles);
+  moveTo(angles, 0);
 }
 
 void ServoArm::moveToPreset(int presetNumber) {
-  DEBUG_PRINTLN("📋 Moving to preset position " + String(presetNumber));
-
-  switch (presetNumber) {
-  case 1: // Pickup
-    setServoAngle(0, 90);
-    setServoAngle(1, 60);
-    setServoAngle(2, 60);
-    setServoAngle(5, 180);
-    break;
-  case 2: // Place
-    setServoAngle(0, 90);
-    setServoAngle(1, 90);
-    setServoAngle(2, 90);
-    break;
-  case 3: // Rest
-    setServoAngle(0, 90);
-    setServoAngle(1, 150);
-    setServoAngle(2, 150);
-    break;
-  default:
-    moveToHome();
-    break;
-  }
+  LOG_INFO(SERVO, LOG_MSG_ARM_PRESET, presetNumber);
+  uint8_t angles[6];
+  loadPose(presetNumber, angles);
+  moveTo(angles, 0);
 }
 
 void ServoArm::openGripper() {
-  DEBUG_PRINTLN("✋ Opening gripper");
+  LOG_INFO(SERVO, LOG_MSG_GRIPPER_OPEN);
   setServoAngle(SERVO_GRIPPER_IDX, 180);
 }
 
 void ServoArm::closeGripper() {
-  DEBUG_PRINTLN("🤏 Closing gripper");
+  LOG_INFO(SERVO, LOG_MSG_GRIPPER_CLOSE);
   setServoAngle(SERVO_GRIPPER_IDX, 0);
 }
 
@@ -174,34 +359,37 @@ void ServoArm::enableArm() {
 }
 
 void ServoArm::disableArm() {
+  // Freeze first - a move resumed later would jump to its elapsed point
+  holdPosition();
   armEnabled = false;
   DEBUG_PRINTLN("⏸ Servo arm disabled");
 }
 
-void ServoArm::stopAll() {
+void ServoArm::holdPosition() {
+  // Each joint stops at its last interpolated pulse
+  clearWaypoints();
   for (int i = 0; i < 6; i++) {
-    servoStates[i].targetAngle = servoStates[i].currentAngle;
-    servoStates[i].isMoving = false;
+    ServoState &state = servoStates[i];
+    state.startPulse = state.currentPulse;
+    state.endPulse = state.currentPulse;
+    state.targetAngle = state.currentAngle;
+    state.moveDuration = 0;
+    state.isMoving = false;
   }
+}
+
+void ServoArm::stopAll() {
+  holdPosition();
   DEBUG_PRINTLN("⏹ All servo movement stopped");
 }
 
 void ServoArm::setMovementSpeed(int speed) {
   servoMovementSpeed = constrain(speed, SERVO_SPEED_SLOW, SERVO_SPEED_FAST);
-  DEBUG_PRINTLN("🏃 Servo movement speed set to " + String(servoMovementSpeed));
+  DEBUG_PRINT_P("🏃 Servo movement speed set to ");
+  DEBUG_PRINTLN(servoMovementSpeed);
 }
 
-void ServoArm::getStatus(String &statusString) {
-  statusString = "Servos: ";
-  for (int i = 0; i < 6; i++) {
-    statusString += String(getServoName(i)) + ":" +
-                    String(servoStates[i].currentAngle) + "°";
-    if (i < 5)
-      statusString += ", ";
-  }
-  statusString += " | Speed: " + String(servoMovementSpeed);
-  statusString += " | Enabled: " + String(armEnabled ? "YES" : "NO");
-}
+int ServoArm::getMovementSpeed() { return servoMovementSpeed; }
 
 void ServoArm::getStatus(char *buffer, size_t bufferSize) {
   char angles[48];
@@ -225,11 +413,11 @@ void ServoArm::testAllServos() {
     int originalAngle = servoStates[i].currentAngle;
 
     setServoAngle(i, 45);
-    delay(1000);
+    runFor(1000);
     setServoAngle(i, 135);
-    delay(1000);
+    runFor(1000);
     setServoAngle(i, originalAngle);
-    delay(500);
+    runFor(500);
 
     DEBUG_PRINT_P("✅ ");
     DEBUG_PRINT(getServoName(i));
@@ -241,16 +429,30 @@ void ServoArm::testAllServos() {
 
 void ServoArm::calibrateServos() {
   DEBUG_PRINTLN("🔧 Calibrating servos...");
-  for (int i = 0; i < 6; i++) {
-    setServoAngle(i, 90);
-  }
+  const uint8_t centred[6] = {90, 90, 90, 90, 90, 90};
+  moveTo(centred, 0);
   DEBUG_PRINTLN("✅ Calibration complete - all servos at 90°");
 }
 
+void ServoArm::runFor(unsigned long duration) {
+  // Blocking test routines keep the trajectories advancing while they wait
+  extern void kickWatchdog();
+  unsigned long start = millis();
+  while (millis() - start < duration) {
+    update();
+    kickWatchdog();
+    delay(TASK_SERVO_PERIOD);
+  }
+}
+
 void ServoArm::emergencyStop() {
   DEBUG_PRINTLN("🚨 SERVO ARM EMERGENCY STOP");
   stopAll();
   disableArm();
 }
 
+size_t ServoArm::getRamUsage() {
+  return sizeof(servos) + sizeof(servoStates) + sizeof(waypoints);
+}
+
 #endif // SERVO_ARM_H
\ No newline at end of file
@@ -7,6 +7,7 @@
 #define SYSTEM_STATUS_H
 
 #include "config.h"
+#include "memory_optimization.h"
 
 class SystemStatus {
 private:
@@ -51,12 +52,11 @@ public:
   static unsigned long getTimeSinceLastCommand();
 
   // System information
-  static void getStatus(String &statusString);
   static void getStatus(char *buffer, size_t bufferSize);
   static void getDetailedStatus();
   static unsigned long getUptime();
   static int getFreeMemory();
-  static float getLoopFrequency();
+  static unsigned int getLoopFrequency(); // Hz, 0 until a second has passed
 
   // Safety functions
   static void checkEmergencyButton();
@@ -65,15 +65,15 @@ public:
 
   // Performance monitoring
   static void updatePerformanceMetrics();
-  static void getPerformanceReport(String &report);
+  static void getPerformanceReport(char *buffer, size_t bufferSize);
 
   // Watchdog functions
   static void feedWatchdog();
   static bool isSystemHealthy();
 
-  // Error handling
-  static void reportError(const String &errorMessage);
-  static void reportWarning(const String &warningMessage);
+  // Error handling (printf-style flash formats)
+  static void reportError(PGM_P format, ...);
+  static void reportWarning(PGM_P format, ...);
 };
 
 // Implementation
@@ -184,8 +184,8 @@ void SystemStatus::blinkStatusLED(int count) {
 
 void SystemStatus::setReady(bool ready) {
   state.isReady = ready;
-  DEBUG_PRINTLN("🚦 System ready state: " +
-                String(ready ? "READY" : "NOT READY"));
+  DEBUG_PRINT_P("🚦 System ready state: ");
+  DEBUG_PRINTLN(ready ? "READY" : "NOT READY");
 }
 
 bool SystemStatus::isReady() { return state.isReady; }
@@ -206,7 +206,8 @@ bool SystemStatus::isEmergencyStopActive() { return state.emergencyStop; }
 
 void SystemStatus::setDebugMode(bool enabled) {
   state.debugMode = enabled;
-  DEBUG_PRINTLN("🔍 Debug mode: " + String(enabled ? "ENABLED" : "DISABLED"));
+  DEBUG_PRINT_P("🔍 Debug mode: ");
+  DEBUG_PRINTLN(enabled ? "ENABLED" : "DISABLED");
 }
 
 bool SystemStatus::isDebugModeEnabled() { return state.debugMode; }
@@ -225,38 +226,37 @@ unsigned long SystemStatus::getTimeSinceLastCommand() {
   return millis() - state.lastCommand;
 }
 
-void SystemStatus::getStatus(String &statusString) {
-  statusString = "Uptime: " + String(getUptime()) + "ms";
-  statusString += " | Ready: " + String(state.isReady ? "YES" : "NO");
-  statusString +=
-      " | Emergency: " + String(state.emergencyStop ? "ACTIVE" : "OK");
-  statusString += " | Memory: " + String(getFreeMemory()) + " bytes";
-  statusString += " | Loop: " + String(getLoopFrequency(), 1) + "Hz";
-}
-
 void SystemStatus::getStatus(char *buffer, size_t bufferSize) {
-  char freqStr[8];
-  formatFloat(getLoopFrequency(), freqStr, sizeof(freqStr), 1);
-
   snprintf_P(buffer, bufferSize,
-             PSTR("Uptime:%lu|Ready:%s|Emergency:%s|Memory:%d|Loop:%sHz"),
+             PSTR("Uptime:%lu|Ready:%s|Emergency:%s|Memory:%d|Loop:%uHz"),
              getUptime(), state.isReady ? "YES" : "NO",
-             state.emergencyStop ? "ACTIVE" : "OK", getFreeMemory(), freqStr);
+             state.emergencyStop ? "ACTIVE" : "OK", getFreeMemory(),
+             getLoopFrequency());
 }
 
 void SystemStatus::getDetailedStatus() {
   DEBUG_PRINTLN("📊 === DETAILED SYSTEM STATUS ===");
-  DEBUG_PRINTLN("⏱ Uptime: " + String(getUptime()) + " ms");
-  DEBUG_PRINTLN("🔋 Free Memory: " + String(getFreeMemory()) + " bytes");
-  DEBUG_PRINTLN("🔄 Loop Frequency: " + String(getLoopFrequency(), 1) + " Hz");
-  DEBUG_PRINTLN("🚦 System Ready: " + String(state.isReady ? "YES" : "NO"));
-  DEBUG_PRINTLN("🚨 Emergency Stop: " +
-                String(state.emergencyStop ? "ACTIVE" : "OK"));
-  DEBUG_PRINTLN("🔍 Debug Mode: " + String(state.debugMode ? "ON" : "OFF"));
-  DEBUG_PRINTLN("⚡ Global Speed: " + String(state.globalSpeedMultiplier) +
-                "%");
-  DEBUG_PRINTLN("📡 Last Command: " + String(getTimeSinceLastCommand()) +
-                " ms ago");
+  DEBUG_PRINT_P("⏱ Uptime: ");
+  DEBUG_PRINT(getUptime());
+  DEBUG_PRINTLN_P(" ms");
+  DEBUG_PRINT_P("🔋 Free Memory: ");
+  DEBUG_PRINT(getFreeMemory());
+  DEBUG_PRINTLN_P(" bytes");
+  DEBUG_PRINT_P("🔄 Loop Frequency: ");
+  DEBUG_PRINT(getLoopFrequency());
+  DEBUG_PRINTLN_P(" Hz");
+  DEBUG_PRINT_P("🚦 System Ready: ");
+  DEBUG_PRINTLN(state.isReady ? "YES" : "NO");
+  DEBUG_PRINT_P("🚨 Emergency Stop: ");
+  DEBUG_PRINTLN(state.emergencyStop ? "ACTIVE" : "OK");
+  DEBUG_PRINT_P("🔍 Debug Mode: ");
+  DEBUG_PRINTLN(state.debugMode ? "ON" : "OFF");
+  DEBUG_PRINT_P("⚡ Global Speed: ");
+  DEBUG_PRINT(state.globalSpeedMultiplier);
+  DEBUG_PRINTLN_P("%");
+  DEBUG_PRINT_P("📡 Last Command: ");
+  DEBUG_PRINT(getTimeSinceLastCommand());
+  DEBUG_PRINTLN_P(" ms ago");
   DEBUG_PRINTLN("📊 === END STATUS ===");
 }
 
@@ -265,22 +265,22 @@ unsigned long SystemStatus::getUptime() { return millis() - state.startTime; }
 int SystemStatus::getFreeMemory() {
   char top;
   extern char *__brkval;
-  extern char __bss_end;
-  return __brkval ? &top - __brkval : &top - &__bss_end;
+  extern char __heap_start;
+  return __brkval ? &top - __brkval : &top - &__heap_start;
 }
 
-float SystemStatus::getLoopFrequency() {
+unsigned int SystemStatus::getLoopFrequency() {
   unsigned long currentTime = millis();
   unsigned long elapsed = currentTime - lastLoopCountReset;
 
   if (elapsed > 1000) { // Calculate every second
-    float frequency = (float)loopCount / (elapsed / 1000.0);
+    unsigned int frequency = (unsigned long)loopCount * 1000UL / elapsed;
     loopCount = 0;
     lastLoopCountReset = currentTime;
     return frequency;
   }
 
-  return 0.0; // Not ready yet
+  return 0; // Not ready yet
 }
 
 void SystemStatus::checkEmergencyButton() {
@@ -291,7 +291,7 @@ void SystemStatus::checkEmergencyButton() {
     // Button just pressed
     emergencyStopPressed = true;
     setEmergencyStop(true);
-    reportError("Emergency button pressed");
+    reportError(PSTR("Emergency button pressed"));
   } else if (!buttonPressed && emergencyStopPressed) {
     // Button released
     emergencyStopPressed = false;
@@ -304,20 +304,20 @@ void SystemStatus::performSafetyCheck() {
   // Check memory levels
   int freeMemory = getFreeMemory();
   if (freeMemory < 500) {
-    reportWarning("Low memory: " + String(freeMemory) + " bytes");
+    reportWarning(PSTR("Low memory: %d bytes"), freeMemory);
   }
 
   // Check loop frequency
-  float loopFreq = getLoopFrequency();
+  unsigned int loopFreq = getLoopFrequency();
   if (loopFreq > 0 && loopFreq < 50) {
-    reportWarning("Low loop frequency: " + String(loopFreq, 1) + " Hz");
+    reportWarning(PSTR("Low loop frequency: %u Hz"), loopFreq);
   }
 
   // Check for system hangs
   static unsigned long lastSafetyCheck = 0;
   unsigned long timeSinceLastCheck = millis() - lastSafetyCheck;
   if (lastSafetyCheck != 0 && timeSinceLastCheck > 5000) {
-    reportError("System hang detected");
+    reportError(PSTR("System hang detected"));
   }
   lastSafetyCheck = millis();
 }
@@ -355,12 +355,13 @@ void SystemStatus::updatePerformanceMetrics() {
   lastLoopTime = currentTime;
 }
 
-void SystemStatus::getPerformanceReport(String &report) {
-  report = "Performance Report:\n";
-  report += "  Loop Frequency: " + String(getLoopFrequency(), 1) + " Hz\n";
-  report += "  Average Loop Time: " + String(averageLoopTime) + " ms\n";
-  report += "  Free Memory: " + String(getFreeMemory()) + " bytes\n";
-  report += "  Uptime: " + String(getUptime()) + " ms\n";
+void SystemStatus::getPerformanceReport(char *buffer, size_t bufferSize) {
+  StringBuilder report(buffer, bufferSize);
+  report.append_P(PSTR("Performance Report:\n"));
+  report.appendf_P(PSTR("  Loop Frequency: %u Hz\n"), getLoopFrequency());
+  report.appendf_P(PSTR("  Average Loop Time: %d ms\n"), averageLoopTime);
+  report.appendf_P(PSTR("  Free Memory: %d bytes\n"), getFreeMemory());
+  report.appendf_P(PSTR("  Uptime: %lu ms\n"), getUptime());
 }
 
 void SystemStatus::feedWatchdog() {
@@ -387,8 +388,15 @@ bool SystemStatus::isSystemHealthy() {
   return true;
 }
 
-void SystemStatus::reportError(const String &errorMessage) {
-  DEBUG_PRINTLN("❌ ERROR: " + errorMessage);
+void SystemStatus::reportError(PGM_P format, ...) {
+  TempString<48> message;
+  va_list args;
+  va_start(args, format);
+  message.vappendf_P(format, args);
+  va_end(args);
+
+  DEBUG_PRINT_P("❌ ERROR: ");
+  DEBUG_PRINTLN(message.c_str());
 
   // Blink LED rapidly to indicate error
   for (int i = 0; i < 10; i++) {
@@ -399,11 +407,18 @@ void SystemStatus::reportError(const String &errorMessage) {
   }
 
   // Send error via Bluetooth if available
-  // BluetoothHandler::sendMessage("ERROR:" + errorMessage);
+  // BluetoothHandler::sendMessage(message.get());
 }
 
-void SystemStatus::reportWarning(const String &warningMessage) {
-  DEBUG_PRINTLN("⚠ WARNING: " + warningMessage);
+void SystemStatus::reportWarning(PGM_P format, ...) {
+  TempString<48> message;
+  va_list args;
+  va_start(args, format);
+  message.vappendf_P(format, args);
+  va_end(args);
+
+  DEBUG_PRINT_P("⚠ WARNING: ");
+  DEBUG_PRINTLN(message.c_str());
 
   // Single long blink for warning
   setStatusLED(true);
@@ -411,7 +426,7 @@ void SystemStatus::reportWarning(const String &warningMessage) {
   setStatusLED(false);
 
   // Send warning via Bluetooth if available
-  // BluetoothHandler::sendMessage("WARNING:" + warningMessage);
+  // BluetoothHandler::sendMessage(message.get());
 }
 
 #endif // SYSTEM_STATUS_H
\ No newline at end of file
@@ -0,0 +1,153 @@
+/**********************************************************************
+ *  task_scheduler.h - Cooperative Task Scheduler
+ *  Runs each subsystem update at its own rate and priority, and idles
+ *  the CPU only until the next task is due. Every completed run checks
+ *  in with the hardware watchdog.
+ *********************************************************************/
+
+#ifndef TASK_SCHEDULER_H
+#define TASK_SCHEDULER_H
+
+#include "config.h"
+#include "debug_log.h"
+#include "memory_optimization.h"
+#include "perf_monitor.h"
+#include "watchdog.h"
+
+#if defined(__AVR__)
+#include <avr/sleep.h>
+#endif
+
+#define INVALID_TASK 0xFF
+
+typedef void (*TaskFunction)();
+
+struct Task {
+  TaskFunction function;
+  PGM_P name;             // Flash string, for diagnostics
+  unsigned long period;   // ms between runs
+  unsigned long deadline; // ms a run may start late before it counts
+  unsigned long nextRun;  // millis() when the task is next due
+  unsigned int missedDeadlines;
+  uint8_t priority; // 0 = most urgent
+};
+
+class TaskScheduler {
+private:
+  static Task tasks[MAX_TASKS];
+  static uint8_t taskCount;
+
+  // Sleep until the next interrupt (timer0 ticks every ~1ms)
+  static void idle();
+
+public:
+  // Register a task; returns its id or INVALID_TASK if the table is full
+  static uint8_t addTask(TaskFunction function, PGM_P name,
+                         unsigned long period, uint8_t priority,
+                         unsigned long deadline);
+
+  // Run the most urgent due task, or idle if nothing is due.
+  // Call this from loop().
+  static void run();
+
+  // Change a task's rate at runtime
+  static void setPeriod(uint8_t id, unsigned long period);
+
+  static uint8_t getTaskCount();
+  static const Task &getTask(uint8_t id);
+
+  // Static RAM of the task table
+  static size_t getRamUsage();
+};
+
+// Static variable definitions
+Task TaskScheduler::tasks[MAX_TASKS];
+uint8_t TaskScheduler::taskCount = 0;
+
+// Implementation
+uint8_t TaskScheduler::addTask(TaskFunction function, PGM_P name,
+                               unsigned long period, uint8_t priority,
+                               unsigned long deadline) {
+  if (taskCount >= MAX_TASKS) {
+    DEBUG_PRINTLN_P("⚠ Task table full");
+    return INVALID_TASK;
+  }
+
+  Task &task = tasks[taskCount];
+  task.function = function;
+  task.name = name;
+  task.period = period;
+  task.deadline = deadline;
+  task.nextRun = millis();
+  task.missedDeadlines = 0;
+  task.priority = priority;
+  return taskCount++;
+}
+
+void TaskScheduler::run() {
+  unsigned long now = millis();
+
+  // Pick the most urgent due task; ties go to the one waiting longest
+  uint8_t next = INVALID_TASK;
+  for (uint8_t i = 0; i < taskCount; i++) {
+    if ((long)(now - tasks[i].nextRun) < 0)
+      continue;
+
+    if (next == INVALID_TASK || tasks[i].priority < tasks[next].priority ||
+        (tasks[i].priority == tasks[next].priority &&
+         (long)(tasks[i].nextRun - tasks[next].nextRun) < 0)) {
+      next = i;
+    }
+  }
+
+  if (next == INVALID_TASK) {
+    // Spare time goes to deferred log output; sleep once that is done
+    if (!DeferredLog::drain()) {
+      idle();
+    }
+    return;
+  }
+
+  Task &task = tasks[next];
+  if (now - task.nextRun > task.deadline) {
+    task.missedDeadlines++;
+  }
+
+  // Keep a steady cadence, but don't burst to catch up after a long stall
+  task.nextRun += task.period;
+  if ((long)(now - task.nextRun) >= 0) {
+    task.nextRun = now + task.period;
+  }
+
+  // A run that never returns leaves its name for the watchdog report
+  Watchdog::beginTask(next, task.name);
+  unsigned long startTime = micros();
+  task.function();
+  PerfMonitor::record(PROBE_TASK_BASE + next, micros() - startTime);
+  Watchdog::checkIn(next);
+}
+
+void TaskScheduler::setPeriod(uint8_t id, unsigned long period) {
+  if (id < taskCount) {
+    tasks[id].period = period;
+  }
+}
+
+uint8_t TaskScheduler::getTaskCount() { return taskCount; }
+
+const Task &TaskScheduler::getTask(uint8_t id) { return tasks[id]; }
+
+void TaskScheduler::idle() {
+#if defined(__AVR__)
+  // Idle mode keeps timers, UART and pin-change interrupts running, so any
+  // of them (including the 1ms millis() tick) wakes us back up
+  set_sleep_mode(SLEEP_MODE_IDLE);
+  sleep_enable();
+  sleep_cpu();
+  sleep_disable();
+#endif
+}
+
+size_t TaskScheduler::getRamUsage() { return sizeof(tasks); }
+
+#endif // TASK_SCHEDULER_H
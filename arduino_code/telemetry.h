@@ -0,0 +1,132 @@
+/**********************************************************************
+ *  telemetry.h - Delta Telemetry Publisher
+ *  Sends only the fields that moved beyond their deadband since they
+ *  were last sent, packed into one compact frame, with a periodic
+ *  full keyframe so a late-joining app can resynchronise
+ *
+ *  Frame layout (text, one line):
+ *    TK:f1234,r567,o17   keyframe - every field
+ *    TD:f1250            delta    - changed fields only
+ *  Each field is a one-letter key followed by a signed integer.
+ *********************************************************************/
+
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include "bluetooth_handler.h"
+#include "config.h"
+#include "memory_optimization.h"
+
+// Field ids - index into the values passed to publish()
+enum TelemetryField : uint8_t {
+  TELEMETRY_FRONT_MM, // Front distance (mm)
+  TELEMETRY_REAR_MM,  // Rear distance (mm)
+  TELEMETRY_FLAGS,    // TELEMETRY_FLAG_* bits
+  TELEMETRY_FIELD_COUNT
+};
+
+// Bits of the TELEMETRY_FLAGS field
+#define TELEMETRY_FLAG_FRONT_OBSTACLE 0x01
+#define TELEMETRY_FLAG_REAR_OBSTACLE 0x02
+#define TELEMETRY_FLAG_FRONT_RISK 0x04
+#define TELEMETRY_FLAG_REAR_RISK 0x08
+#define TELEMETRY_FLAG_SENSORS_ACTIVE 0x10
+
+#define TELEMETRY_FRAME_LENGTH 48
+
+struct TelemetryFieldInfo {
+  char key;
+  uint16_t deadband; // Changes up to this size are not sent
+};
+
+// Indexed by TelemetryField
+const TelemetryFieldInfo TELEMETRY_FIELDS[] PROGMEM = {
+    {'f', TELEMETRY_DISTANCE_DEADBAND},
+    {'r', TELEMETRY_DISTANCE_DEADBAND},
+    {'o', 0}};
+
+class TelemetryPublisher {
+private:
+  static int16_t lastSent[TELEMETRY_FIELD_COUNT];
+  static unsigned long lastKeyframe;
+  static bool keyframePending;
+  static unsigned long framesSent;
+  static unsigned long framesSkipped;
+
+public:
+  // Send the fields of values[] that changed (or all of them when a
+  // keyframe is due). Returns true if a frame was queued.
+  static bool publish(const int16_t *values);
+
+  // Make the next publish() a keyframe (e.g. after a reconnect)
+  static void requestKeyframe();
+
+  static unsigned long getFramesSent();
+  static unsigned long getFramesSkipped(); // Nothing had changed
+};
+
+// Static variable definitions
+int16_t TelemetryPublisher::lastSent[TELEMETRY_FIELD_COUNT];
+unsigned long TelemetryPublisher::lastKeyframe = 0;
+bool TelemetryPublisher::keyframePending = true;
+unsigned long TelemetryPublisher::framesSent = 0;
+unsigned long TelemetryPublisher::framesSkipped = 0;
+
+static_assert(sizeof(TELEMETRY_FIELDS) / sizeof(TELEMETRY_FIELDS[0]) ==
+                  TELEMETRY_FIELD_COUNT,
+              "Telemetry field table out of sync with TelemetryField");
+
+// Implementation
+bool TelemetryPublisher::publish(const int16_t *values) {
+  unsigned long now = millis();
+  bool keyframe =
+      keyframePending || (now - lastKeyframe >= TELEMETRY_KEYFRAME_INTERVAL);
+
+  char frame[TELEMETRY_FRAME_LENGTH];
+  int length = snprintf_P(frame, sizeof(frame), keyframe ? PSTR("TK:")
+                                                         : PSTR("TD:"));
+  uint8_t included = 0; // Bit per field in this frame
+
+  for (uint8_t i = 0; i < TELEMETRY_FIELD_COUNT; i++) {
+    uint16_t deadband = pgm_read_word(&TELEMETRY_FIELDS[i].deadband);
+    long change = (long)values[i] - lastSent[i];
+    if (!keyframe && labs(change) <= deadband)
+      continue;
+
+    char key = pgm_read_byte(&TELEMETRY_FIELDS[i].key);
+    length += snprintf_P(frame + length, sizeof(frame) - length,
+                         included ? PSTR(",%c%d") : PSTR("%c%d"), key,
+                         values[i]);
+    included |= 1 << i;
+  }
+
+  if (!included) {
+    framesSkipped++;
+    return false;
+  }
+
+  // A frame that never left keeps the old values, so the change is
+  // retried on the next publish
+  if (BluetoothHandler::sendMessage(frame) != TX_QUEUED)
+    return false;
+
+  for (uint8_t i = 0; i < TELEMETRY_FIELD_COUNT; i++) {
+    if (included & (1 << i))
+      lastSent[i] = values[i];
+  }
+  framesSent++;
+
+  if (keyframe) {
+    keyframePending = false;
+    lastKeyframe = now;
+  }
+  return true;
+}
+
+void TelemetryPublisher::requestKeyframe() { keyframePending = true; }
+
+unsigned long TelemetryPublisher::getFramesSent() { return framesSent; }
+
+unsigned long TelemetryPublisher::getFramesSkipped() { return framesSkipped; }
+
+#endif // TELEMETRY_H
@@ -0,0 +1,325 @@
+/**********************************************************************
+ *  trace.h - Command Trace Record / Replay
+ *  Records timestamped link traffic (inbound commands and frames, plus
+ *  outbound acks) in a compact binary trace, and replays the inbound
+ *  side at the original or an accelerated rate as a repeatable load,
+ *  reporting ack latency, rejected commands and emergency stop timing.
+ *
+ *  Record layout (back to back, little-endian):
+ *    [kind][delta ms x2][length][payload x length]
+ *  delta is the time since the previous record (saturates at 65535).
+ *********************************************************************/
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include "binary_protocol.h"
+#include "config.h"
+#include "memory_optimization.h"
+
+// Record kinds
+#define TRACE_INBOUND 0x01  // Text command line
+#define TRACE_FRAME 0x02    // Binary command frame
+#define TRACE_OUTBOUND 0x03 // High priority line (acks, emergency notices)
+
+#define TRACE_HEADER_LENGTH 4
+#define TRACE_SETTLE_TIME 1000 // ms to wait for acks after the last record
+#define TRACE_DUMP_BYTES 32    // Trace bytes per TR: line
+
+enum TraceState : uint8_t { TRACE_IDLE, TRACE_RECORDING, TRACE_REPLAYING };
+
+class CommandTrace {
+private:
+  static uint8_t buffer[TRACE_BUFFER_SIZE];
+  static uint16_t length;
+  static TraceState state;
+  static unsigned long lastRecordTime;
+  static unsigned int recordsDropped; // Didn't fit while recording
+
+  // Replay position and clock
+  static uint16_t replayPosition;
+  static unsigned long replayClock; // Trace time of the next record (ms)
+  static unsigned long replayStart;
+  static unsigned long lastInjectTime;
+  static uint8_t replaySpeed;
+
+  // Replay results
+  static unsigned int injectedCount;
+  static unsigned int ackCount;
+  static unsigned long ackTotal; // us
+  static unsigned long ackMin;
+  static unsigned long ackMax;
+  static unsigned int rejectedCount; // Queue full or unparseable
+  static unsigned int emergencyCount;
+  static unsigned long emergencyMax; // us
+
+  static void record(uint8_t kind, const uint8_t *payload, uint8_t size);
+  static void injectNext();
+
+public:
+  // Start a new recording (clears the previous trace)
+  static void startRecording();
+
+  // Start replaying the recorded trace; speed 2 = twice as fast
+  static void startReplay(uint8_t speed);
+
+  // Stop recording or replay, keeping the trace
+  static void stop();
+
+  // Replace the trace with one captured earlier (a TRACE:4 dump), e.g.
+  // for host/trace_replay. False if it doesn't fit or a record is cut off.
+  static bool load(const uint8_t *data, uint16_t size);
+
+  // Hooks called by the link handlers
+  static void recordInbound(const char *line);
+  static void recordFrame(const uint8_t *frame);
+  static void recordOutbound(const char *line);
+
+  // A queued command has run its handler (and sent its ack)
+  static void onCommandDone(const Command &cmd);
+
+  // Feed replayed commands when due. Call every tick.
+  static void update();
+
+  // Hex of the trace from offset into a TR: line and move offset past
+  // it; false at the end (REPORT source for TRACE:4)
+  static bool dumpLine(uint16_t &offset, uint16_t argument, char *text,
+                       size_t textSize);
+  static uint16_t getLength();
+
+  // Send the state, size and last replay results
+  static void sendReport();
+};
+
+// Static variable definitions
+uint8_t CommandTrace::buffer[TRACE_BUFFER_SIZE];
+uint16_t CommandTrace::length = 0;
+TraceState CommandTrace::state = TRACE_IDLE;
+unsigned long CommandTrace::lastRecordTime = 0;
+unsigned int CommandTrace::recordsDropped = 0;
+uint16_t CommandTrace::replayPosition = 0;
+unsigned long CommandTrace::replayClock = 0;
+unsigned long CommandTrace::replayStart = 0;
+unsigned long CommandTrace::lastInjectTime = 0;
+uint8_t CommandTrace::replaySpeed = 1;
+unsigned int CommandTrace::injectedCount = 0;
+unsigned int CommandTrace::ackCount = 0;
+unsigned long CommandTrace::ackTotal = 0;
+unsigned long CommandTrace::ackMin = 0;
+unsigned long CommandTrace::ackMax = 0;
+unsigned int CommandTrace::rejectedCount = 0;
+unsigned int CommandTrace::emergencyCount = 0;
+unsigned long CommandTrace::emergencyMax = 0;
+
+// Implementation
+void CommandTrace::startRecording() {
+  length = 0;
+  recordsDropped = 0;
+  lastRecordTime = millis();
+  state = TRACE_RECORDING;
+}
+
+void CommandTrace::startReplay(uint8_t speed) {
+  replaySpeed = constrain(speed, 1, 16);
+  replayPosition = 0;
+  replayClock = 0;
+  replayStart = millis();
+  lastInjectTime = replayStart;
+
+  injectedCount = 0;
+  ackCount = 0;
+  ackTotal = 0;
+  ackMin = 0xFFFFFFFF;
+  ackMax = 0;
+  rejectedCount = 0;
+  emergencyCount = 0;
+  emergencyMax = 0;
+
+  state = TRACE_REPLAYING;
+}
+
+void CommandTrace::stop() { state = TRACE_IDLE; }
+
+bool CommandTrace::load(const uint8_t *data, uint16_t size) {
+  if (size > TRACE_BUFFER_SIZE)
+    return false;
+
+  // injectNext() trusts the lengths, so check every record first
+  uint16_t position = 0;
+  while (position < size) {
+    if (size - position < TRACE_HEADER_LENGTH)
+      return false;
+    uint8_t kind = data[position];
+    if (kind < TRACE_INBOUND || kind > TRACE_OUTBOUND)
+      return false;
+    if (kind == TRACE_FRAME && data[position + 3] != FRAME_LENGTH)
+      return false;
+    position += TRACE_HEADER_LENGTH + data[position + 3];
+  }
+  if (position != size)
+    return false;
+
+  state = TRACE_IDLE;
+  memcpy(buffer, data, size);
+  length = size;
+  recordsDropped = 0;
+  return true;
+}
+
+void CommandTrace::record(uint8_t kind, const uint8_t *payload,
+                          uint8_t size) {
+  if (state != TRACE_RECORDING)
+    return;
+
+  // Once full the trace keeps its start; later traffic is only counted
+  if (length + TRACE_HEADER_LENGTH + size > TRACE_BUFFER_SIZE) {
+    if (recordsDropped != 0xFFFF)
+      recordsDropped++;
+    return;
+  }
+
+  unsigned long now = millis();
+  unsigned long delta = min(now - lastRecordTime, 0xFFFFUL);
+  lastRecordTime = now;
+
+  buffer[length++] = kind;
+  buffer[length++] = delta & 0xFF;
+  buffer[length++] = delta >> 8;
+  buffer[length++] = size;
+  memcpy(buffer + length, payload, size);
+  length += size;
+}
+
+void CommandTrace::recordInbound(const char *line) {
+  record(TRACE_INBOUND, (const uint8_t *)line, strlen(line));
+}
+
+void CommandTrace::recordFrame(const uint8_t *frame) {
+  record(TRACE_FRAME, frame, FRAME_LENGTH);
+}
+
+void CommandTrace::recordOutbound(const char *line) {
+  record(TRACE_OUTBOUND, (const uint8_t *)line, strlen(line));
+}
+
+void CommandTrace::onCommandDone(const Command &cmd) {
+  if (state != TRACE_REPLAYING)
+    return;
+
+  // From queueing to the end of the handler, which sends the ack
+  unsigned long latency = micros() - cmd.queuedAt;
+  ackCount++;
+  ackTotal += latency;
+  ackMin = min(ackMin, latency);
+  ackMax = max(ackMax, latency);
+  if (cmd.opcode == OP_EMERGENCY) {
+    emergencyCount++;
+    emergencyMax = max(emergencyMax, latency);
+  }
+}
+
+void CommandTrace::injectNext() {
+  uint8_t kind = buffer[replayPosition];
+  uint8_t size = buffer[replayPosition + 3];
+  const uint8_t *payload = buffer + replayPosition + TRACE_HEADER_LENGTH;
+  replayPosition += TRACE_HEADER_LENGTH + size;
+
+  extern bool addCommandToQueue(const char *cmd);
+  extern bool addFrameCommandToQueue(const Command &cmd);
+
+  if (kind == TRACE_INBOUND) {
+    char line[MAX_LINE_LENGTH];
+    size = min(size, (uint8_t)(sizeof(line) - 1));
+    memcpy(line, payload, size);
+    line[size] = '\0';
+
+    // The TRACE commands that framed the recording are not part of the load
+    if (strncasecmp_P(line, PSTR("TRACE"), 5) == 0)
+      return;
+
+    if (!addCommandToQueue(line))
+      rejectedCount++;
+  } else if (kind == TRACE_FRAME) {
+    Command cmd;
+    if (!BinaryProtocol::decodeFrame(payload, cmd))
+      return;
+
+    if (!addFrameCommandToQueue(cmd))
+      rejectedCount++;
+  } else {
+    return; // Outbound records are what the robot said; nothing to replay
+  }
+
+  injectedCount++;
+  lastInjectTime = millis();
+}
+
+void CommandTrace::update() {
+  if (state != TRACE_REPLAYING)
+    return;
+
+  unsigned long elapsed = (millis() - replayStart) * replaySpeed;
+  while (replayPosition < length) {
+    uint16_t delta =
+        buffer[replayPosition + 1] | (buffer[replayPosition + 2] << 8);
+    if (replayClock + delta > elapsed)
+      return;
+
+    replayClock += delta;
+    injectNext();
+  }
+
+  // Everything is queued; report once the last acks have had time
+  if (millis() - lastInjectTime > TRACE_SETTLE_TIME) {
+    state = TRACE_IDLE;
+    sendReport();
+  }
+}
+
+bool CommandTrace::dumpLine(uint16_t &offset, uint16_t argument, char *text,
+                            size_t textSize) {
+  if (offset >= length)
+    return false;
+
+  uint16_t end = min((uint16_t)(offset + TRACE_DUMP_BYTES), length);
+  size_t used = snprintf_P(text, textSize, PSTR("TR:"));
+  for (; offset < end && used + 2 < textSize; offset++) {
+    used += snprintf_P(text + used, textSize - used, PSTR("%02x"),
+                       buffer[offset]);
+  }
+  return true;
+}
+
+uint16_t CommandTrace::getLength() { return length; }
+
+void CommandTrace::sendReport() {
+  MessageHandle message(MAX_MESSAGE_LENGTH);
+  if (!message)
+    return;
+
+  const char *stateName = state == TRACE_RECORDING   ? "RECORDING"
+                          : state == TRACE_REPLAYING ? "REPLAYING"
+                                                     : "IDLE";
+  message.printf_P(PSTR("TRACE:%s bytes=%u/%u dropped=%u"), stateName,
+                   length, TRACE_BUFFER_SIZE, recordsDropped);
+  sendBluetoothMessage(message.get());
+
+  if (ackCount > 0) {
+    message.printf_P(PSTR("TRACE:ACK n=%u min=%lu avg=%lu max=%lu us"),
+                     ackCount, ackMin, ackTotal / ackCount, ackMax);
+    sendBluetoothMessage(message.get());
+  }
+
+  // Commands replaced in the queue by a newer setpoint are never acked
+  message.printf_P(PSTR("TRACE:REJECTED %u injected=%u"), rejectedCount,
+                   injectedCount);
+  sendBluetoothMessage(message.get());
+
+  if (emergencyCount > 0) {
+    message.printf_P(PSTR("TRACE:ESTOP n=%u max=%lu us"), emergencyCount,
+                     emergencyMax);
+    sendBluetoothMessage(message.get());
+  }
+}
+
+#endif // TRACE_H
@@ -12,8 +12,8 @@
 inline int freeMemory() {
   char top;
   extern char *__brkval;
-  extern char __bss_end;
-  return __brkval ? &top - __brkval : &top - &__bss_end;
+  extern char __heap_start;
+  return __brkval ? &top - __brkval : &top - &__heap_start;
 }
 
 // String utility functions - optimized for memory
@@ -0,0 +1,293 @@
+/**********************************************************************
+ *  watchdog.h - Hardware Watchdog and Warm Restart
+ *  Runs the AVR watchdog and feeds it only once every scheduled task has
+ *  checked in (run to completion) since the last feed, so a task that
+ *  hangs and one that never gets to run both end in a reset.
+ *
+ *  A few variables live in .noinit RAM, which the C runtime leaves alone
+ *  across a reset: the task that was running when the watchdog fired and
+ *  a CRC-checked WarmState snapshot (arm pose, settings, Bluetooth rate)
+ *  taken every TASK_WATCHDOG_PERIOD. After a watchdog reset setup()
+ *  resumes from it: the servos attach where they were instead of
+ *  homing, and the Bluetooth link skips its settle and rate detection.
+ *
+ *  Boot report (sent once ROBOT_READY is queued):
+ *    BOOT:<WARM|COLD> cause=<cause> [task=<name>] [missing=<mask>]
+ *        [restarts=<n>] ms=<boot time>
+ *********************************************************************/
+
+#ifndef WATCHDOG_H
+#define WATCHDOG_H
+
+#include "bluetooth_handler.h"
+#include "config.h"
+#include "config_store.h"
+#include "memory_optimization.h"
+#include "servo_arm.h"
+
+#if defined(__AVR__)
+#include <avr/interrupt.h>
+#include <avr/wdt.h>
+#define WATCHDOG_NOINIT __attribute__((section(".noinit")))
+#else
+#define WATCHDOG_NOINIT
+#endif
+
+#define WARM_STATE_MAGIC 0x57A2
+#define WATCHDOG_RESET_MARK 0xD06F // Left by the watchdog interrupt
+#define WATCHDOG_NO_TASK 0xFF
+
+static_assert(MAX_TASKS <= 16, "Task check-in mask is 16 bits");
+
+enum ResetCause : uint8_t {
+  RESET_POWER,
+  RESET_EXTERNAL,
+  RESET_BROWNOUT,
+  RESET_WATCHDOG,
+  RESET_UNKNOWN
+};
+
+class Watchdog {
+private:
+  // Kept across the reset (.noinit)
+  static uint8_t resetFlags;  // MCUSR, saved before the C runtime starts
+  static uint16_t resetMark;  // WATCHDOG_RESET_MARK after a watchdog reset
+  static uint8_t runningTask; // Task in progress, WATCHDOG_NO_TASK between
+  static PGM_P runningTaskName;
+  static uint16_t checkedIn; // Tasks run since the last feed
+  static uint16_t expected;  // One bit per scheduled task
+  static WarmState warmState;
+
+  // What init() found
+  static ResetCause cause;
+  static uint8_t stalledTask;
+  static char stalledTaskName[16];
+  static uint16_t missingTasks; // Hadn't checked in when it fired
+  static bool warmBoot;
+  static bool running;
+
+#if defined(__AVR__)
+  static void captureResetFlags()
+      __attribute__((naked, used, section(".init3")));
+#endif
+  static uint16_t warmStateCrc();
+
+public:
+  // Work out why we reset and whether the snapshot can be resumed.
+  // Call first thing in setup().
+  static void init();
+
+  // Arm the watchdog once taskCount tasks are registered
+  static void start(uint8_t taskCount);
+
+  // Scheduler hooks around each task run. The last task of a round to
+  // check in feeds the watchdog.
+  static void beginTask(uint8_t id, PGM_P name);
+  static void checkIn(uint8_t id);
+
+  // Feed from a bounded blocking loop (test routines, bulk output) that
+  // keeps the tasks from running
+  static void kick();
+
+  // Called from the watchdog interrupt: mark the reset as ours and take
+  // it at once rather than after a second timeout
+  static void onTimeout();
+
+  // Refresh the snapshot a warm restart resumes from. Call every
+  // TASK_WATCHDOG_PERIOD.
+  static void update();
+
+  // Whether setup() should resume from getWarmState()
+  static bool isWarmBoot();
+  static const WarmState &getWarmState();
+
+  // BOOT: line for the app
+  static void getBootReport(char *buffer, size_t bufferSize);
+};
+
+// Static variable definitions
+uint8_t Watchdog::resetFlags WATCHDOG_NOINIT;
+uint16_t Watchdog::resetMark WATCHDOG_NOINIT;
+uint8_t Watchdog::runningTask WATCHDOG_NOINIT;
+PGM_P Watchdog::runningTaskName WATCHDOG_NOINIT;
+uint16_t Watchdog::checkedIn WATCHDOG_NOINIT;
+uint16_t Watchdog::expected WATCHDOG_NOINIT;
+WarmState Watchdog::warmState WATCHDOG_NOINIT;
+ResetCause Watchdog::cause = RESET_UNKNOWN;
+uint8_t Watchdog::stalledTask = WATCHDOG_NO_TASK;
+char Watchdog::stalledTaskName[16];
+uint16_t Watchdog::missingTasks = 0;
+bool Watchdog::warmBoot = false;
+bool Watchdog::running = false;
+
+#if defined(__AVR__)
+// Runs before .data and .bss are set up. The watchdog stays enabled
+// through its own reset, so stop it before setup() has to outrun it.
+void Watchdog::captureResetFlags() {
+  resetFlags = MCUSR;
+  MCUSR = 0;
+  wdt_disable();
+}
+
+ISR(WDT_vect) { Watchdog::onTimeout(); }
+#endif
+
+// Implementation
+uint16_t Watchdog::warmStateCrc() {
+  return ConfigStore::crc16((const uint8_t *)&warmState,
+                            offsetof(WarmState, crc));
+}
+
+void Watchdog::init() {
+#if defined(__AVR__)
+  // The Mega bootloader may clear MCUSR before starting the sketch, so
+  // the mark left by the interrupt is what identifies a watchdog reset
+  if (resetFlags & (_BV(PORF) | _BV(BORF))) {
+    cause = resetFlags & _BV(PORF) ? RESET_POWER : RESET_BROWNOUT;
+  } else if (resetMark == WATCHDOG_RESET_MARK || (resetFlags & _BV(WDRF))) {
+    cause = RESET_WATCHDOG;
+  } else if (resetFlags & _BV(EXTRF)) {
+    cause = RESET_EXTERNAL;
+  } else {
+    cause = RESET_UNKNOWN;
+  }
+#else
+  cause = RESET_POWER;
+#endif
+  resetMark = 0;
+
+  if (cause == RESET_WATCHDOG) {
+    stalledTask = runningTask;
+    if (stalledTask != WATCHDOG_NO_TASK) {
+      strncpy_P(stalledTaskName, runningTaskName,
+                sizeof(stalledTaskName) - 1);
+      stalledTaskName[sizeof(stalledTaskName) - 1] = '\0';
+    }
+    missingTasks = expected & ~checkedIn;
+  }
+
+  // A reset button press or power cycle asks for a full start, and a
+  // snapshot that keeps leading to a hang stops being resumed
+  warmBoot = cause == RESET_WATCHDOG &&
+             warmState.magic == WARM_STATE_MAGIC &&
+             warmState.crc == warmStateCrc() &&
+             warmState.warmBoots < WATCHDOG_MAX_WARM_BOOTS;
+
+  if (warmBoot) {
+    warmState.warmBoots++;
+  } else {
+    memset(&warmState, 0, sizeof(warmState));
+    warmState.magic = WARM_STATE_MAGIC;
+  }
+  warmState.crc = warmStateCrc();
+
+  runningTask = WATCHDOG_NO_TASK;
+  checkedIn = 0;
+  expected = 0;
+}
+
+void Watchdog::start(uint8_t taskCount) {
+  expected = taskCount >= 16 ? 0xFFFF : (1U << taskCount) - 1;
+  checkedIn = 0;
+
+#if defined(__AVR__) && WATCHDOG_ENABLED
+  // Interrupt and reset mode: the first timeout runs onTimeout(). WDP3
+  // is not next to WDP0-2, so the wdt.h constant has to be split.
+  uint8_t prescale = (WATCHDOG_TIMEOUT & 0x08 ? _BV(WDP3) : 0) |
+                     (WATCHDOG_TIMEOUT & 0x07);
+  uint8_t sreg = SREG;
+  cli();
+  wdt_reset();
+  WDTCSR = _BV(WDCE) | _BV(WDE);
+  WDTCSR = _BV(WDIE) | _BV(WDE) | prescale;
+  SREG = sreg;
+  running = true;
+#endif
+}
+
+void Watchdog::beginTask(uint8_t id, PGM_P name) {
+  runningTaskName = name;
+  runningTask = id;
+}
+
+void Watchdog::checkIn(uint8_t id) {
+  runningTask = WATCHDOG_NO_TASK;
+  checkedIn |= 1U << id;
+  if ((checkedIn & expected) != expected)
+    return;
+
+  checkedIn = 0;
+#if defined(__AVR__)
+  if (running)
+    wdt_reset();
+#endif
+}
+
+void Watchdog::kick() {
+#if defined(__AVR__)
+  if (running)
+    wdt_reset();
+#endif
+}
+
+void Watchdog::onTimeout() {
+  resetMark = WATCHDOG_RESET_MARK;
+#if defined(__AVR__)
+  wdt_enable(WDTO_15MS);
+  for (;;) {
+  }
+#endif
+}
+
+void Watchdog::update() {
+  ConfigStore::capture(warmState.config);
+  ServoArm::getPulses(warmState.armPulses);
+
+  // Mid bring-up or baud change the rate isn't settled; detect it again
+  warmState.baud =
+      BluetoothHandler::isLinkReady() ? BluetoothHandler::getBaud() : 0;
+
+  if (warmState.warmBoots != 0 && millis() >= WATCHDOG_STABLE_TIME)
+    warmState.warmBoots = 0;
+
+  warmState.crc = warmStateCrc();
+}
+
+bool Watchdog::isWarmBoot() { return warmBoot; }
+
+const WarmState &Watchdog::getWarmState() { return warmState; }
+
+void Watchdog::getBootReport(char *buffer, size_t bufferSize) {
+  StringBuilder report(buffer, bufferSize);
+  report.append_P(warmBoot ? PSTR("BOOT:WARM") : PSTR("BOOT:COLD"));
+  report.append_P(PSTR(" cause="));
+  switch (cause) {
+  case RESET_POWER:
+    report.append_P(PSTR("POWER"));
+    break;
+  case RESET_EXTERNAL:
+    report.append_P(PSTR("EXTERNAL"));
+    break;
+  case RESET_BROWNOUT:
+    report.append_P(PSTR("BROWNOUT"));
+    break;
+  case RESET_WATCHDOG:
+    report.append_P(PSTR("WATCHDOG"));
+    break;
+  default:
+    report.append_P(PSTR("UNKNOWN"));
+    break;
+  }
+
+  if (cause == RESET_WATCHDOG) {
+    // No task means it hung in the scheduler itself (idle, log drain)
+    if (stalledTask != WATCHDOG_NO_TASK)
+      report.appendf_P(PSTR(" task=%s"), stalledTaskName);
+    report.appendf_P(PSTR(" missing=0x%04x"), missingTasks);
+  }
+  if (warmBoot)
+    report.appendf_P(PSTR(" restarts=%u"), warmState.warmBoots);
+  report.appendf_P(PSTR(" ms=%lu"), millis());
+}
+
+#endif // WATCHDOG_H
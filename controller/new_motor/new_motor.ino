@@ -0,0 +1,178 @@
+/**********************************************************************
+ *  4WD Robot - TTGO T-Call (ESP32) Bridge Target
+ *  Arduino Mega 2560 motor controller for the cellular/Wi-Fi robots
+ *
+ *  The same motor and command paths as arduino_code/robot_controller.ino
+ *  (MotorController, CommandProcessor, the task scheduler and watchdog),
+ *  with the ESP32 in the HC-05's place on Serial1:
+ *  - ESP32_BRIDGE_MODE runs Serial1 at BLUETOOTH_BAUD (250000) with no
+ *    AT rate detection - set the ESP32 side's UART to match
+ *  - the ESP32 relays text lines and binary command frames unchanged;
+ *    replies, acks and telemetry come back the same way
+ *  - MEGA_READY is still sent once the link is up, for ESP32 firmware
+ *    that waits for it
+ *
+ *  Pins are the arduino_code/config.h motor map (D0-D3 on 22-29, enable
+ *  on 2-5), unchanged from the standalone tester this replaces. There are
+ *  no range sensors on this build, so nothing vetoes forward motion;
+ *  arm, sensor and relay commands answer ERROR_<command>.
+ *
+ *  The headers are arduino_code's, found through an include path (the
+ *  builder copies the sketch away, so relative paths don't resolve):
+ *    arduino-cli compile --fqbn arduino:avr:mega --build-property \
+ *      "compiler.cpp.extra_flags=-I<repo>/arduino_code" controller/new_motor
+ *  In the IDE, put the same flag in compiler.cpp.extra_flags in the AVR
+ *  core's platform.local.txt.
+ *********************************************************************/
+
+// Before config.h, which the headers below include
+#define ESP32_BRIDGE_MODE true
+
+#include "benchmark.h"
+#include "bluetooth_handler.h"
+#include "command_processor.h"
+#include "config.h"
+#include "config_store.h"
+#include "link_probe.h"
+#include "macro_engine.h"
+#include "memory_optimization.h"
+#include "motor_controller.h"
+#include "report.h"
+#include "task_scheduler.h"
+#include "trace.h"
+#include "watchdog.h"
+
+// Function to handle command queue from the ESP32 (solves circular
+// dependency)
+bool addCommandToQueue(const char *cmd) {
+  return CommandProcessor::addCommand(cmd);
+}
+
+// Function to queue a decoded binary frame (solves circular dependency)
+bool addFrameCommandToQueue(const Command &cmd) {
+  return CommandProcessor::addCommand(cmd);
+}
+
+// Function to send messages to the ESP32 (solves circular dependency)
+void sendBluetoothMessage(const char *message, uint8_t priority) {
+  BluetoothHandler::sendMessage(message, priority);
+}
+
+// Function to run the next benchmark case (solves circular dependency)
+bool benchmarkLine(uint16_t &cursor, uint16_t iterations, char *line,
+                   size_t lineSize) {
+  return Benchmark::reportLine(cursor, iterations, line, lineSize);
+}
+
+// Function for emergency motor stop (solves circular dependency)
+void emergencyStopAllMotors() {
+  MotorController::emergencyStop();
+  MacroEngine::abort(PSTR("COLLISION"));
+}
+
+// Function to feed the watchdog from blocking loops (solves circular
+// dependency)
+void kickWatchdog() { Watchdog::kick(); }
+
+// Function to check collision safety (solves circular dependency) - no
+// range sensors on this build
+bool checkCollisionSafety(bool movingForward) { return true; }
+
+void setup() {
+  // Reset cause and the warm restart snapshot, before any subsystem starts
+  Watchdog::init();
+
+  // Initialize serial for debugging
+  Serial.begin(115200);
+
+  if (Watchdog::isWarmBoot()) {
+    Serial.println(F("♻ Watchdog reset - warm restart"));
+  } else {
+    Serial.println(F("==============================================="));
+    Serial.println(F("4WD Robot - TTGO T-Call Bridge Controller"));
+    Serial.println(F("MODE: ESP32 link on Serial1"));
+    Serial.println(F("==============================================="));
+  }
+
+  MemoryMonitor::init();
+
+  // Motors first, so they are stopped before anything else can run.
+  // Nothing here waits; the link settles in the comms task.
+  bool warm = Watchdog::isWarmBoot();
+  const WarmState &resume = Watchdog::getWarmState();
+  MotorController::init();
+
+  BluetoothHandler::init(warm ? resume.baud : 0);
+
+  // Replace the defaults above with the settings saved in EEPROM
+  ConfigStore::init();
+  if (warm) {
+    ConfigStore::resume(resume.config);
+  }
+
+  CommandProcessor::init();
+
+  registerTasks();
+  Watchdog::start(TaskScheduler::getTaskCount());
+
+  Serial.print(F("✅ System Ready in "));
+  Serial.print(millis());
+  Serial.println(F(" ms"));
+
+  sendBluetoothMessage("MEGA_READY");
+  sendBootReport();
+}
+
+// Longer than the high priority queue takes, so it goes with telemetry
+void sendBootReport() {
+  MessageHandle message(MAX_MESSAGE_LENGTH);
+  if (message) {
+    Watchdog::getBootReport(message.get(), message.size());
+    sendBluetoothMessage(message.get());
+  }
+}
+
+void loop() {
+  // Run whichever task is due next; idles until then
+  TaskScheduler::run();
+}
+
+// ========== SCHEDULED TASKS ==========
+
+void memoryTask() {
+  // Nothing allocates after setup(), so a critical reading means the
+  // stack has grown into the statics
+  MemoryMonitor::checkMemory();
+}
+
+void registerTasks() {
+  TaskScheduler::addTask(BluetoothHandler::update, PSTR("COMMS"),
+                         TASK_COMMS_PERIOD, TASK_COMMS_PRIORITY,
+                         TASK_COMMS_DEADLINE);
+  TaskScheduler::addTask(CommandProcessor::processQueue, PSTR("COMMANDS"),
+                         TASK_COMMANDS_PERIOD, TASK_COMMANDS_PRIORITY,
+                         TASK_COMMANDS_DEADLINE);
+  TaskScheduler::addTask(MotorController::update, PSTR("MOTOR"),
+                         TASK_MOTOR_PERIOD, TASK_MOTOR_PRIORITY,
+                         TASK_MOTOR_DEADLINE);
+  TaskScheduler::addTask(memoryTask, PSTR("MEMORY"), TASK_MEMORY_PERIOD,
+                         TASK_MEMORY_PRIORITY, TASK_MEMORY_DEADLINE);
+  TaskScheduler::addTask(LinkProbe::update, PSTR("LINK_PROBE"),
+                         TASK_LINK_PROBE_PERIOD, TASK_LINK_PROBE_PRIORITY,
+                         TASK_LINK_PROBE_DEADLINE);
+  TaskScheduler::addTask(CommandTrace::update, PSTR("TRACE"),
+                         TASK_TRACE_PERIOD, TASK_TRACE_PRIORITY,
+                         TASK_TRACE_DEADLINE);
+  TaskScheduler::addTask(ConfigStore::update, PSTR("CONFIG"),
+                         TASK_CONFIG_PERIOD, TASK_CONFIG_PRIORITY,
+                         TASK_CONFIG_DEADLINE);
+  TaskScheduler::addTask(MacroEngine::update, PSTR("MACRO"),
+                         TASK_MACRO_PERIOD, TASK_MACRO_PRIORITY,
+                         TASK_MACRO_DEADLINE);
+  TaskScheduler::addTask(Report::update, PSTR("REPORT"),
+                         TASK_REPORT_PERIOD, TASK_REPORT_PRIORITY,
+                         TASK_REPORT_DEADLINE);
+  TaskScheduler::addTask(Watchdog::update, PSTR("WATCHDOG"),
+                         TASK_WATCHDOG_PERIOD, TASK_WATCHDOG_PRIORITY,
+                         TASK_WATCHDOG_DEADLINE);
+}
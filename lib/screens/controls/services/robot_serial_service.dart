@@ -0,0 +1,60 @@
+import 'package:flutter/services.dart';
+
+/// Native serial link to the robots on Windows (windows/runner
+/// robot_serial_channel.cpp). The runner reads each COM port on its own
+/// thread and parses lines, telemetry and frames there, so the UI isolate
+/// only receives decoded batches.
+class RobotSerialService {
+  static const MethodChannel _channel = MethodChannel('robo_app/robot_serial');
+  static const EventChannel _events =
+      EventChannel('robo_app/robot_serial/events');
+
+  static Stream<List<Map<dynamic, dynamic>>>? _batches;
+
+  /// Decoded robot output, one list per batch. Each map has `port` and
+  /// `type`: `line` (text), `telemetry` (keyframe, fields, text),
+  /// `frame` (opcode, value1, value2) or `error` (text; the port closed).
+  static Stream<List<Map<dynamic, dynamic>>> get batches {
+    return _batches ??= _events.receiveBroadcastStream().map(
+        (batch) => (batch as List).cast<Map<dynamic, dynamic>>());
+  }
+
+  /// COM ports currently present, e.g. `['COM3', 'COM5']`
+  static Future<List<String>> listPorts() async {
+    final ports = await _channel.invokeListMethod<String>('listPorts');
+    return ports ?? [];
+  }
+
+  /// Open [port]; reopening at a new [baud] replaces the old connection
+  static Future<void> open(String port, {int baud = 9600}) {
+    return _channel.invokeMethod('open', {'port': port, 'baud': baud});
+  }
+
+  static Future<void> close(String port) {
+    return _channel.invokeMethod('close', {'port': port});
+  }
+
+  /// Send a text command (see RobotControlService for the vocabulary)
+  static Future<void> send(String port, String line) {
+    return _channel.invokeMethod('send', {'port': port, 'line': line});
+  }
+
+  /// Send a binary command frame (arduino_code/binary_protocol.h opcodes)
+  static Future<void> sendFrame(String port, int opcode,
+      [int value1 = 0, int value2 = 0]) {
+    return _channel.invokeMethod('sendFrame', {
+      'port': port,
+      'opcode': opcode,
+      'value1': value1,
+      'value2': value2,
+    });
+  }
+
+  /// Tank drive setpoint (-100 to 100 per side). Sent as a binary frame;
+  /// setpoints that arrive faster than the link drains replace each other
+  /// instead of queueing.
+  static Future<void> drive(String port, int left, int right) {
+    return _channel
+        .invokeMethod('drive', {'port': port, 'left': left, 'right': right});
+  }
+}
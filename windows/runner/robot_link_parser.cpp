@@ -0,0 +1,103 @@
+#include "robot_link_parser.h"
+
+#include <cstdlib>
+
+uint8_t FrameCrc8(const uint8_t* data, size_t length) {
+  uint8_t crc = 0;
+  for (size_t i = 0; i < length; i++) {
+    crc ^= data[i];
+    for (int bit = 0; bit < 8; bit++) {
+      crc = (crc & 0x80) ? static_cast<uint8_t>((crc << 1) ^ 0x07)
+                         : static_cast<uint8_t>(crc << 1);
+    }
+  }
+  return crc;
+}
+
+void EncodeFrame(uint8_t opcode, int8_t value1, int8_t value2,
+                 uint8_t* frame) {
+  frame[0] = kFrameSync;
+  frame[1] = opcode;
+  frame[2] = static_cast<uint8_t>(value1);
+  frame[3] = static_cast<uint8_t>(value2);
+  frame[4] = FrameCrc8(frame + 1, 3);
+}
+
+void RobotLinkParser::Feed(const uint8_t* data, size_t size,
+                           std::vector<RobotLinkMessage>* messages) {
+  for (size_t i = 0; i < size; i++) {
+    uint8_t byte = data[i];
+
+    if (frame_length_ > 0) {
+      frame_[frame_length_++] = byte;
+      if (frame_length_ < kFrameLength) {
+        continue;
+      }
+      frame_length_ = 0;
+      // A bad CRC means the sync byte was noise; the rest is dropped as
+      // the firmware does.
+      if (FrameCrc8(frame_ + 1, 3) == frame_[4]) {
+        RobotLinkMessage message;
+        message.type = RobotLinkMessage::Type::kFrame;
+        message.opcode = frame_[1];
+        message.value1 = static_cast<int8_t>(frame_[2]);
+        message.value2 = static_cast<int8_t>(frame_[3]);
+        messages->push_back(std::move(message));
+      }
+      continue;
+    }
+
+    // The sync byte is outside ASCII, so it only starts a frame between
+    // lines.
+    if (line_.empty() && !line_overflow_ && byte == kFrameSync) {
+      frame_[0] = byte;
+      frame_length_ = 1;
+      continue;
+    }
+
+    if (byte == '\n' || byte == '\r') {
+      if (!line_.empty() && !line_overflow_) {
+        messages->push_back(ParseLine(line_));
+      }
+      line_.clear();
+      line_overflow_ = false;
+      continue;
+    }
+
+    if (line_.size() < kMaxLineLength) {
+      line_.push_back(static_cast<char>(byte));
+    } else {
+      line_overflow_ = true;
+    }
+  }
+}
+
+// static
+RobotLinkMessage RobotLinkParser::ParseLine(const std::string& line) {
+  RobotLinkMessage message;
+  message.text = line;
+
+  // TK:f1234,r567,o17 - a one-letter key and a signed integer per field.
+  bool keyframe = line.compare(0, 3, "TK:") == 0;
+  if (!keyframe && line.compare(0, 3, "TD:") != 0) {
+    return message;
+  }
+
+  const char* cursor = line.c_str() + 3;
+  while (*cursor != '\0') {
+    char key = *cursor++;
+    char* end = nullptr;
+    long value = std::strtol(cursor, &end, 10);
+    if (end == cursor || (*end != ',' && *end != '\0')) {
+      // Not telemetry after all; pass the line through.
+      message.fields.clear();
+      return message;
+    }
+    message.fields.emplace_back(key, static_cast<int32_t>(value));
+    cursor = *end == ',' ? end + 1 : end;
+  }
+
+  message.type = RobotLinkMessage::Type::kTelemetry;
+  message.keyframe = keyframe;
+  return message;
+}
@@ -0,0 +1,67 @@
+#ifndef RUNNER_ROBOT_LINK_PARSER_H_
+#define RUNNER_ROBOT_LINK_PARSER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Binary command frame layout, matching arduino_code/binary_protocol.h:
+// [SYNC 0xA5] [OPCODE] [VALUE1 int8] [VALUE2 int8] [CRC8 over 1-3].
+constexpr uint8_t kFrameSync = 0xA5;
+constexpr size_t kFrameLength = 5;
+constexpr uint8_t kFrameOpTank = 0x05;
+
+// Longest firmware line kept; longer ones are dropped as line noise.
+constexpr size_t kMaxLineLength = 256;
+
+// One decoded unit of robot output.
+struct RobotLinkMessage {
+  enum class Type {
+    kLine,       // Any text line the firmware sends.
+    kTelemetry,  // TK: keyframe or TD: delta, split into fields.
+    kFrame,      // Binary frame with a valid CRC.
+    kError,      // The port failed and was closed; |text| says why.
+  };
+
+  Type type = Type::kLine;
+  std::string text;
+
+  // kTelemetry: one-letter field key and value, in line order.
+  bool keyframe = false;
+  std::vector<std::pair<char, int32_t>> fields;
+
+  // kFrame.
+  uint8_t opcode = 0;
+  int8_t value1 = 0;
+  int8_t value2 = 0;
+};
+
+// CRC-8 (polynomial 0x07, initial value 0), as the firmware computes it.
+uint8_t FrameCrc8(const uint8_t* data, size_t length);
+
+// Builds a frame for |opcode| into |frame|, which must hold kFrameLength.
+void EncodeFrame(uint8_t opcode, int8_t value1, int8_t value2,
+                 uint8_t* frame);
+
+// Splits the robot's byte stream into lines and binary frames. Keeps the
+// partial line or frame between calls, so reads can end anywhere.
+class RobotLinkParser {
+ public:
+  // Decodes |size| bytes of |data|, appending complete messages to
+  // |messages|.
+  void Feed(const uint8_t* data, size_t size,
+            std::vector<RobotLinkMessage>* messages);
+
+ private:
+  // Turns a complete line into a message, splitting telemetry fields.
+  static RobotLinkMessage ParseLine(const std::string& line);
+
+  std::string line_;
+  bool line_overflow_ = false;
+  uint8_t frame_[kFrameLength] = {};
+  size_t frame_length_ = 0;
+};
+
+#endif  // RUNNER_ROBOT_LINK_PARSER_H_
@@ -0,0 +1,345 @@
+#include "robot_serial_channel.h"
+
+#include <flutter/event_stream_handler_functions.h>
+#include <flutter/standard_method_codec.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+
+#include "utils.h"
+
+namespace {
+
+constexpr char kMethodChannelName[] = "robo_app/robot_serial";
+constexpr char kEventChannelName[] = "robo_app/robot_serial/events";
+
+// Rate used when open doesn't give one: an unconfigured HC-05.
+constexpr int64_t kDefaultBaud = 9600;
+
+// Drive setpoints are percentages, as in the firmware's TANK command.
+constexpr int64_t kMaxDriveSpeed = 100;
+
+// Where Windows lists the serial ports it has drivers loaded for.
+constexpr wchar_t kSerialCommRegKey[] = L"HARDWARE\\DEVICEMAP\\SERIALCOMM";
+
+const flutter::EncodableValue* GetArgument(
+    const flutter::EncodableMap& arguments, const char* key) {
+  auto it = arguments.find(flutter::EncodableValue(key));
+  return it == arguments.end() ? nullptr : &it->second;
+}
+
+bool GetString(const flutter::EncodableMap& arguments, const char* key,
+               std::string* value) {
+  const flutter::EncodableValue* argument = GetArgument(arguments, key);
+  const auto* text = argument ? std::get_if<std::string>(argument) : nullptr;
+  if (!text) {
+    return false;
+  }
+  *value = *text;
+  return true;
+}
+
+// Dart ints arrive as int32 or int64 depending on their size.
+bool GetInt(const flutter::EncodableMap& arguments, const char* key,
+            int64_t* value) {
+  const flutter::EncodableValue* argument = GetArgument(arguments, key);
+  if (!argument) {
+    return false;
+  }
+  if (const auto* small = std::get_if<int32_t>(argument)) {
+    *value = *small;
+    return true;
+  }
+  if (const auto* large = std::get_if<int64_t>(argument)) {
+    *value = *large;
+    return true;
+  }
+  return false;
+}
+
+int8_t ClampToInt8(int64_t value, int64_t limit) {
+  return static_cast<int8_t>(std::clamp<int64_t>(value, -limit, limit));
+}
+
+flutter::EncodableValue EncodeMessage(const std::string& port,
+                                      const RobotLinkMessage& message) {
+  flutter::EncodableMap event;
+  event[flutter::EncodableValue("port")] = flutter::EncodableValue(port);
+
+  switch (message.type) {
+    case RobotLinkMessage::Type::kLine:
+      event[flutter::EncodableValue("type")] = flutter::EncodableValue("line");
+      event[flutter::EncodableValue("text")] =
+          flutter::EncodableValue(message.text);
+      break;
+    case RobotLinkMessage::Type::kTelemetry: {
+      flutter::EncodableMap fields;
+      for (const auto& field : message.fields) {
+        fields[flutter::EncodableValue(std::string(1, field.first))] =
+            flutter::EncodableValue(field.second);
+      }
+      event[flutter::EncodableValue("type")] =
+          flutter::EncodableValue("telemetry");
+      event[flutter::EncodableValue("keyframe")] =
+          flutter::EncodableValue(message.keyframe);
+      event[flutter::EncodableValue("fields")] =
+          flutter::EncodableValue(std::move(fields));
+      event[flutter::EncodableValue("text")] =
+          flutter::EncodableValue(message.text);
+      break;
+    }
+    case RobotLinkMessage::Type::kFrame:
+      event[flutter::EncodableValue("type")] =
+          flutter::EncodableValue("frame");
+      event[flutter::EncodableValue("opcode")] =
+          flutter::EncodableValue(static_cast<int32_t>(message.opcode));
+      event[flutter::EncodableValue("value1")] =
+          flutter::EncodableValue(static_cast<int32_t>(message.value1));
+      event[flutter::EncodableValue("value2")] =
+          flutter::EncodableValue(static_cast<int32_t>(message.value2));
+      break;
+    case RobotLinkMessage::Type::kError:
+      event[flutter::EncodableValue("type")] =
+          flutter::EncodableValue("error");
+      event[flutter::EncodableValue("text")] =
+          flutter::EncodableValue(message.text);
+      break;
+  }
+  return flutter::EncodableValue(std::move(event));
+}
+
+}  // namespace
+
+RobotSerialChannel::RobotSerialChannel(flutter::BinaryMessenger* messenger,
+                                       HWND window)
+    : window_(window) {
+  const auto& codec = flutter::StandardMethodCodec::GetInstance();
+
+  method_channel_ =
+      std::make_unique<flutter::MethodChannel<flutter::EncodableValue>>(
+          messenger, kMethodChannelName, &codec);
+  method_channel_->SetMethodCallHandler(
+      [this](const flutter::MethodCall<flutter::EncodableValue>& call,
+             MethodResult result) {
+        HandleMethodCall(call, std::move(result));
+      });
+
+  event_channel_ =
+      std::make_unique<flutter::EventChannel<flutter::EncodableValue>>(
+          messenger, kEventChannelName, &codec);
+  event_channel_->SetStreamHandler(
+      std::make_unique<
+          flutter::StreamHandlerFunctions<flutter::EncodableValue>>(
+          [this](const flutter::EncodableValue* arguments,
+                 std::unique_ptr<flutter::EventSink<flutter::EncodableValue>>&&
+                     events)
+              -> std::unique_ptr<
+                  flutter::StreamHandlerError<flutter::EncodableValue>> {
+            event_sink_ = std::move(events);
+            return nullptr;
+          },
+          [this](const flutter::EncodableValue* arguments)
+              -> std::unique_ptr<
+                  flutter::StreamHandlerError<flutter::EncodableValue>> {
+            event_sink_ = nullptr;
+            return nullptr;
+          }));
+}
+
+RobotSerialChannel::~RobotSerialChannel() {
+  // Joins the I/O threads, so none of them can call back after this.
+  ports_.clear();
+  method_channel_->SetMethodCallHandler(nullptr);
+  event_channel_->SetStreamHandler(nullptr);
+}
+
+void RobotSerialChannel::HandleMethodCall(
+    const flutter::MethodCall<flutter::EncodableValue>& call,
+    MethodResult result) {
+  const std::string& method = call.method_name();
+
+  if (method == "listPorts") {
+    result->Success(flutter::EncodableValue(ListPorts()));
+    return;
+  }
+
+  const auto* arguments =
+      call.arguments() ? std::get_if<flutter::EncodableMap>(call.arguments())
+                       : nullptr;
+  if (!arguments) {
+    result->Error("bad_arguments", "Expected a map of arguments");
+    return;
+  }
+
+  if (method == "open") {
+    std::string name;
+    int64_t baud = kDefaultBaud;
+    if (!GetString(*arguments, "port", &name)) {
+      result->Error("bad_arguments", "Missing port");
+      return;
+    }
+    GetInt(*arguments, "baud", &baud);
+
+    // Reopening (e.g. at a new rate after BAUD:) replaces the old port.
+    ports_.erase(name);
+    auto port = std::make_unique<SerialPort>(name);
+    const SerialPort* source = port.get();
+    std::string error;
+    bool opened = port->Open(
+        static_cast<unsigned long>(baud),
+        [this, name, source](std::vector<RobotLinkMessage>&& messages) {
+          OnPortMessages(name, source, std::move(messages));
+        },
+        &error);
+    if (!opened) {
+      result->Error("open_failed", name + ": " + error);
+      return;
+    }
+    ports_[name] = std::move(port);
+    result->Success();
+    return;
+  }
+
+  if (method == "close") {
+    std::string name;
+    if (GetString(*arguments, "port", &name)) {
+      ports_.erase(name);
+    }
+    result->Success();
+    return;
+  }
+
+  SerialPort* port = FindPort(*arguments, result);
+  if (!port) {
+    return;
+  }
+
+  if (method == "send") {
+    std::string line;
+    if (!GetString(*arguments, "line", &line)) {
+      result->Error("bad_arguments", "Missing line");
+      return;
+    }
+    port->SendLine(line);
+    result->Success();
+  } else if (method == "sendFrame") {
+    int64_t opcode = 0;
+    int64_t value1 = 0;
+    int64_t value2 = 0;
+    if (!GetInt(*arguments, "opcode", &opcode)) {
+      result->Error("bad_arguments", "Missing opcode");
+      return;
+    }
+    GetInt(*arguments, "value1", &value1);
+    GetInt(*arguments, "value2", &value2);
+    port->SendFrame(static_cast<uint8_t>(opcode), ClampToInt8(value1, 127),
+                    ClampToInt8(value2, 127));
+    result->Success();
+  } else if (method == "drive") {
+    int64_t left = 0;
+    int64_t right = 0;
+    GetInt(*arguments, "left", &left);
+    GetInt(*arguments, "right", &right);
+    port->SetDrive(ClampToInt8(left, kMaxDriveSpeed),
+                   ClampToInt8(right, kMaxDriveSpeed));
+    result->Success();
+  } else {
+    result->NotImplemented();
+  }
+}
+
+SerialPort* RobotSerialChannel::FindPort(
+    const flutter::EncodableMap& arguments, MethodResult& result) {
+  std::string name;
+  if (!GetString(arguments, "port", &name)) {
+    result->Error("bad_arguments", "Missing port");
+    return nullptr;
+  }
+  auto it = ports_.find(name);
+  if (it == ports_.end()) {
+    result->Error("not_open", name + " is not open");
+    return nullptr;
+  }
+  return it->second.get();
+}
+
+void RobotSerialChannel::OnPortMessages(
+    const std::string& port, const SerialPort* source,
+    std::vector<RobotLinkMessage>&& messages) {
+  std::lock_guard<std::mutex> lock(pending_mutex_);
+  for (RobotLinkMessage& message : messages) {
+    pending_.push_back({port, source, std::move(message)});
+  }
+
+  // One wake-up per batch: whatever arrives before the platform thread
+  // gets to it goes out in the same event.
+  if (!wake_posted_) {
+    wake_posted_ = true;
+    PostMessage(window_, kRobotSerialEventsMessage, 0, 0);
+  }
+}
+
+void RobotSerialChannel::PostPendingEvents() {
+  std::vector<PendingMessage> batch;
+  {
+    std::lock_guard<std::mutex> lock(pending_mutex_);
+    batch.swap(pending_);
+    wake_posted_ = false;
+  }
+
+  flutter::EncodableList events;
+  events.reserve(batch.size());
+  for (const PendingMessage& pending : batch) {
+    // The I/O thread has stopped; release the port so it can be reopened,
+    // unless it already has been.
+    if (pending.message.type == RobotLinkMessage::Type::kError) {
+      auto it = ports_.find(pending.port);
+      if (it != ports_.end() && it->second.get() == pending.source) {
+        ports_.erase(it);
+      }
+    }
+    events.push_back(EncodeMessage(pending.port, pending.message));
+  }
+
+  if (event_sink_ && !events.empty()) {
+    event_sink_->Success(flutter::EncodableValue(std::move(events)));
+  }
+}
+
+// static
+flutter::EncodableList RobotSerialChannel::ListPorts() {
+  flutter::EncodableList ports;
+  HKEY key;
+  if (RegOpenKeyExW(HKEY_LOCAL_MACHINE, kSerialCommRegKey, 0, KEY_READ,
+                    &key) != ERROR_SUCCESS) {
+    return ports;
+  }
+
+  for (DWORD index = 0;; index++) {
+    wchar_t value_name[256];
+    wchar_t data[64];
+    DWORD value_name_size = static_cast<DWORD>(std::size(value_name));
+    DWORD data_size = sizeof(data);
+    DWORD type = 0;
+    LONG status = RegEnumValueW(key, index, value_name, &value_name_size,
+                                nullptr, &type,
+                                reinterpret_cast<BYTE*>(data), &data_size);
+    if (status == ERROR_NO_MORE_ITEMS) {
+      break;
+    }
+    if (status != ERROR_SUCCESS || type != REG_SZ) {
+      continue;
+    }
+    // The data may or may not include its terminator.
+    std::wstring name(data, data_size / sizeof(wchar_t));
+    while (!name.empty() && name.back() == L'\0') {
+      name.pop_back();
+    }
+    ports.push_back(flutter::EncodableValue(Utf8FromUtf16(name.c_str())));
+  }
+  RegCloseKey(key);
+
+  std::sort(ports.begin(), ports.end());
+  return ports;
+}
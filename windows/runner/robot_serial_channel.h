@@ -0,0 +1,101 @@
+#ifndef RUNNER_ROBOT_SERIAL_CHANNEL_H_
+#define RUNNER_ROBOT_SERIAL_CHANNEL_H_
+
+#include <flutter/binary_messenger.h>
+#include <flutter/encodable_value.h>
+#include <flutter/event_channel.h>
+#include <flutter/event_sink.h>
+#include <flutter/method_channel.h>
+#include <windows.h>
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "robot_link_parser.h"
+#include "serial_port.h"
+
+// Posted to the Flutter window when decoded robot output is waiting; the
+// window calls RobotSerialChannel::PostPendingEvents() on the platform
+// thread.
+constexpr UINT kRobotSerialEventsMessage = WM_APP + 1;
+
+// Native robot link for the desktop app: one SerialPort per connected
+// robot, with the firmware's lines, telemetry and frames decoded off the
+// UI thread.
+//
+// Method channel "robo_app/robot_serial":
+//   listPorts                         -> ["COM5", ...]
+//   open {port, baud}                 -> null, or error "open_failed"
+//   close {port}
+//   send {port, line}                 text command
+//   sendFrame {port, opcode, value1, value2}
+//   drive {port, left, right}         coalesced tank setpoint
+//
+// Event channel "robo_app/robot_serial/events" delivers lists of maps,
+// everything decoded since the previous list:
+//   {port, type: "line", text}
+//   {port, type: "telemetry", keyframe, fields: {"f": 1234, ...}, text}
+//   {port, type: "frame", opcode, value1, value2}
+//   {port, type: "error", text}       the port has been closed
+class RobotSerialChannel {
+ public:
+  // Registers both channels on |messenger|. |window| receives
+  // kRobotSerialEventsMessage.
+  RobotSerialChannel(flutter::BinaryMessenger* messenger, HWND window);
+  ~RobotSerialChannel();
+
+  // Prevent copying.
+  RobotSerialChannel(RobotSerialChannel const&) = delete;
+  RobotSerialChannel& operator=(RobotSerialChannel const&) = delete;
+
+  // Sends everything decoded since the last call as one event. Must be
+  // called on the platform thread.
+  void PostPendingEvents();
+
+ private:
+  using MethodResult =
+      std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>>;
+
+  void HandleMethodCall(
+      const flutter::MethodCall<flutter::EncodableValue>& call,
+      MethodResult result);
+
+  // Queues messages from |port|'s I/O thread, waking the platform thread
+  // if this starts a new batch.
+  void OnPortMessages(const std::string& port, const SerialPort* source,
+                      std::vector<RobotLinkMessage>&& messages);
+
+  // Returns the open port named in |arguments|, or nullptr after failing
+  // |result|.
+  SerialPort* FindPort(const flutter::EncodableMap& arguments,
+                       MethodResult& result);
+
+  // Names of the COM ports currently present.
+  static flutter::EncodableList ListPorts();
+
+  HWND window_;
+  std::unique_ptr<flutter::MethodChannel<flutter::EncodableValue>>
+      method_channel_;
+  std::unique_ptr<flutter::EventChannel<flutter::EncodableValue>>
+      event_channel_;
+  std::unique_ptr<flutter::EventSink<flutter::EncodableValue>> event_sink_;
+
+  std::map<std::string, std::unique_ptr<SerialPort>> ports_;
+
+  // A decoded message and the port it came from.
+  struct PendingMessage {
+    std::string port;
+    const SerialPort* source;
+    RobotLinkMessage message;
+  };
+
+  // Filled by the I/O threads, drained by PostPendingEvents().
+  std::mutex pending_mutex_;
+  std::vector<PendingMessage> pending_;
+  bool wake_posted_ = false;
+};
+
+#endif  // RUNNER_ROBOT_SERIAL_CHANNEL_H_
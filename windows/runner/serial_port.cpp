@@ -0,0 +1,262 @@
+#include "serial_port.h"
+
+#include <utility>
+
+namespace {
+
+// Bytes taken per read; several of the firmware's longest lines.
+constexpr DWORD kReadBufferSize = 1024;
+
+// A read with nothing to return completes empty after this many ms and
+// is reissued.
+constexpr DWORD kReadIdleTimeout = 500;
+
+// Driver-side queue sizes.
+constexpr DWORD kDriverQueueSize = 4096;
+
+// Returns the system message for |code|, without the trailing newline.
+std::string DescribeError(DWORD code) {
+  char* text = nullptr;
+  DWORD length = FormatMessageA(
+      FORMAT_MESSAGE_ALLOCATE_BUFFER | FORMAT_MESSAGE_FROM_SYSTEM |
+          FORMAT_MESSAGE_IGNORE_INSERTS,
+      nullptr, code, 0, reinterpret_cast<char*>(&text), 0, nullptr);
+  if (length == 0) {
+    return "error " + std::to_string(code);
+  }
+  std::string message(text, length);
+  LocalFree(text);
+  while (!message.empty() &&
+         (message.back() == '\n' || message.back() == '\r')) {
+    message.pop_back();
+  }
+  return message;
+}
+
+}  // namespace
+
+SerialPort::SerialPort(const std::string& name) : name_(name) {}
+
+SerialPort::~SerialPort() {
+  Close();
+}
+
+bool SerialPort::Open(unsigned long baud, MessageCallback on_messages,
+                      std::string* error) {
+  // COM10 and above only open through the device namespace.
+  std::wstring path = L"\\\\.\\" + std::wstring(name_.begin(), name_.end());
+  port_ = CreateFileW(path.c_str(), GENERIC_READ | GENERIC_WRITE, 0,
+                      nullptr, OPEN_EXISTING, FILE_FLAG_OVERLAPPED, nullptr);
+  if (port_ == INVALID_HANDLE_VALUE) {
+    *error = DescribeError(GetLastError());
+    return false;
+  }
+
+  DCB dcb = {};
+  dcb.DCBlength = sizeof(dcb);
+  bool configured = GetCommState(port_, &dcb) != FALSE;
+  dcb.BaudRate = baud;
+  dcb.ByteSize = 8;
+  dcb.Parity = NOPARITY;
+  dcb.StopBits = ONESTOPBIT;
+  dcb.fBinary = TRUE;
+  dcb.fParity = FALSE;
+  dcb.fOutxCtsFlow = FALSE;
+  dcb.fOutxDsrFlow = FALSE;
+  dcb.fDtrControl = DTR_CONTROL_ENABLE;
+  dcb.fRtsControl = RTS_CONTROL_ENABLE;
+  dcb.fOutX = FALSE;
+  dcb.fInX = FALSE;
+  dcb.fNull = FALSE;
+  dcb.fAbortOnError = FALSE;
+
+  // A read completes as soon as any byte is there, so input is handled
+  // when it arrives rather than on a polling interval.
+  COMMTIMEOUTS timeouts = {};
+  timeouts.ReadIntervalTimeout = MAXDWORD;
+  timeouts.ReadTotalTimeoutMultiplier = MAXDWORD;
+  timeouts.ReadTotalTimeoutConstant = kReadIdleTimeout;
+
+  configured = configured && SetCommState(port_, &dcb) &&
+               SetCommTimeouts(port_, &timeouts);
+  if (!configured) {
+    *error = DescribeError(GetLastError());
+    CloseHandle(port_);
+    port_ = INVALID_HANDLE_VALUE;
+    return false;
+  }
+  SetupComm(port_, kDriverQueueSize, kDriverQueueSize);
+  PurgeComm(port_, PURGE_RXCLEAR | PURGE_TXCLEAR);
+
+  stop_event_ = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+  send_event_ = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+  on_messages_ = std::move(on_messages);
+  thread_ = std::thread(&SerialPort::Run, this);
+  return true;
+}
+
+void SerialPort::Close() {
+  if (thread_.joinable()) {
+    SetEvent(stop_event_);
+    thread_.join();
+  }
+  if (port_ != INVALID_HANDLE_VALUE) {
+    CloseHandle(port_);
+    port_ = INVALID_HANDLE_VALUE;
+  }
+  if (stop_event_) {
+    CloseHandle(stop_event_);
+    stop_event_ = nullptr;
+  }
+  if (send_event_) {
+    CloseHandle(send_event_);
+    send_event_ = nullptr;
+  }
+}
+
+void SerialPort::SendLine(const std::string& line) {
+  Enqueue(line + "\n");
+}
+
+void SerialPort::SendFrame(uint8_t opcode, int8_t value1, int8_t value2) {
+  uint8_t frame[kFrameLength];
+  EncodeFrame(opcode, value1, value2, frame);
+  Enqueue(std::string(reinterpret_cast<char*>(frame), kFrameLength));
+}
+
+void SerialPort::SetDrive(int8_t left, int8_t right) {
+  uint8_t frame[kFrameLength];
+  EncodeFrame(kFrameOpTank, left, right, frame);
+  {
+    std::lock_guard<std::mutex> lock(outbound_mutex_);
+    drive_frame_.assign(reinterpret_cast<char*>(frame), kFrameLength);
+  }
+  SetEvent(send_event_);
+}
+
+void SerialPort::Enqueue(std::string bytes) {
+  {
+    std::lock_guard<std::mutex> lock(outbound_mutex_);
+    // A STOP sent after a setpoint must not overtake it.
+    if (!drive_frame_.empty()) {
+      outbound_.push_back(std::move(drive_frame_));
+      drive_frame_.clear();
+    }
+    outbound_.push_back(std::move(bytes));
+  }
+  SetEvent(send_event_);
+}
+
+bool SerialPort::TakeOutbound(std::string* buffer) {
+  std::lock_guard<std::mutex> lock(outbound_mutex_);
+  buffer->clear();
+  for (const std::string& bytes : outbound_) {
+    buffer->append(bytes);
+  }
+  outbound_.clear();
+  buffer->append(drive_frame_);
+  drive_frame_.clear();
+  return !buffer->empty();
+}
+
+void SerialPort::Deliver(const uint8_t* data, DWORD count) {
+  std::vector<RobotLinkMessage> messages;
+  parser_.Feed(data, count, &messages);
+  if (!messages.empty()) {
+    on_messages_(std::move(messages));
+  }
+}
+
+void SerialPort::ReportError(const char* operation) {
+  DWORD code = GetLastError();
+  RobotLinkMessage message;
+  message.type = RobotLinkMessage::Type::kError;
+  message.text = std::string(operation) + ": " + DescribeError(code);
+  std::vector<RobotLinkMessage> messages;
+  messages.push_back(std::move(message));
+  on_messages_(std::move(messages));
+}
+
+void SerialPort::Run() {
+  OVERLAPPED read_overlapped = {};
+  OVERLAPPED write_overlapped = {};
+  read_overlapped.hEvent = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+  write_overlapped.hEvent = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+
+  uint8_t read_buffer[kReadBufferSize];
+  std::string write_buffer;
+  bool reading = false;
+  bool writing = false;
+
+  for (;;) {
+    // Both calls signal their event whether they finish at once or later,
+    // so every completion is collected by the wait below.
+    if (!reading) {
+      if (!ReadFile(port_, read_buffer, kReadBufferSize, nullptr,
+                    &read_overlapped) &&
+          GetLastError() != ERROR_IO_PENDING) {
+        ReportError("ReadFile");
+        break;
+      }
+      reading = true;
+    }
+    if (!writing && TakeOutbound(&write_buffer)) {
+      if (!WriteFile(port_, write_buffer.data(),
+                     static_cast<DWORD>(write_buffer.size()), nullptr,
+                     &write_overlapped) &&
+          GetLastError() != ERROR_IO_PENDING) {
+        ReportError("WriteFile");
+        break;
+      }
+      writing = true;
+    }
+
+    // Output ahead of input: a steady stream of telemetry must not hold
+    // back the next setpoint.
+    HANDLE handles[] = {stop_event_,
+                        writing ? write_overlapped.hEvent : send_event_,
+                        read_overlapped.hEvent};
+    DWORD signaled = WaitForMultipleObjects(3, handles, FALSE, INFINITE);
+    DWORD count = 0;
+    if (signaled == WAIT_OBJECT_0) {
+      break;
+    } else if (signaled == WAIT_OBJECT_0 + 1) {
+      // A write finished, or output was queued with none in flight; the
+      // queue is taken at the top either way.
+      if (writing) {
+        writing = false;
+        if (!GetOverlappedResult(port_, &write_overlapped, &count, FALSE)) {
+          ReportError("WriteFile");
+          break;
+        }
+      }
+    } else if (signaled == WAIT_OBJECT_0 + 2) {
+      reading = false;
+      if (!GetOverlappedResult(port_, &read_overlapped, &count, FALSE)) {
+        ReportError("ReadFile");
+        break;
+      }
+      // Empty after the idle timeout; just read again.
+      if (count > 0) {
+        Deliver(read_buffer, count);
+      }
+    } else {
+      ReportError("WaitForMultipleObjects");
+      break;
+    }
+  }
+
+  // The driver still owns the buffers of anything in flight.
+  if (reading || writing) {
+    CancelIo(port_);
+    DWORD count = 0;
+    if (reading) {
+      GetOverlappedResult(port_, &read_overlapped, &count, TRUE);
+    }
+    if (writing) {
+      GetOverlappedResult(port_, &write_overlapped, &count, TRUE);
+    }
+  }
+  CloseHandle(read_overlapped.hEvent);
+  CloseHandle(write_overlapped.hEvent);
+}
@@ -0,0 +1,91 @@
+#ifndef RUNNER_SERIAL_PORT_H_
+#define RUNNER_SERIAL_PORT_H_
+
+#include <windows.h>
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "robot_link_parser.h"
+
+// A COM port (an HC-05's virtual serial port, or a USB serial adapter)
+// driven by one thread with overlapped I/O. Reads complete as soon as
+// bytes arrive and are decoded on that thread; writes are queued and go
+// out back to back.
+//
+// Drive setpoints are coalesced: while a write is in flight, only the
+// newest SetDrive() is kept, so a fast joystick never builds a backlog.
+class SerialPort {
+ public:
+  // Receives each read's decoded messages on the I/O thread.
+  using MessageCallback =
+      std::function<void(std::vector<RobotLinkMessage>&& messages)>;
+
+  explicit SerialPort(const std::string& name);
+  ~SerialPort();
+
+  // Prevent copying.
+  SerialPort(SerialPort const&) = delete;
+  SerialPort& operator=(SerialPort const&) = delete;
+
+  // Opens the port at |baud| (8N1) and starts the I/O thread. On failure
+  // returns false with the reason in |error|.
+  bool Open(unsigned long baud, MessageCallback on_messages,
+            std::string* error);
+
+  // Stops the I/O thread and closes the port. Pending output is dropped.
+  void Close();
+
+  // Queues a text command; the line ending is added here.
+  void SendLine(const std::string& line);
+
+  // Queues a binary command frame.
+  void SendFrame(uint8_t opcode, int8_t value1, int8_t value2);
+
+  // Sets the tank drive setpoint, replacing one not yet sent.
+  void SetDrive(int8_t left, int8_t right);
+
+  const std::string& name() const { return name_; }
+
+ private:
+  // I/O thread body.
+  void Run();
+
+  // Decodes |count| bytes just read and hands over any messages.
+  void Deliver(const uint8_t* data, DWORD count);
+
+  // Moves everything queued into |buffer| for one write. Returns false if
+  // there is nothing to send.
+  bool TakeOutbound(std::string* buffer);
+
+  // Queues |bytes| behind any pending drive setpoint, keeping the order
+  // the calls were made in.
+  void Enqueue(std::string bytes);
+
+  // Reports a failure to the callback from the I/O thread.
+  void ReportError(const char* operation);
+
+  std::string name_;
+  HANDLE port_ = INVALID_HANDLE_VALUE;
+
+  // Set by Close() to end the thread.
+  HANDLE stop_event_ = nullptr;
+
+  // Set when output is queued while no write is in flight.
+  HANDLE send_event_ = nullptr;
+
+  std::thread thread_;
+  MessageCallback on_messages_;
+  RobotLinkParser parser_;
+
+  std::mutex outbound_mutex_;
+  std::deque<std::string> outbound_;
+  std::string drive_frame_;  // Newest setpoint, empty once sent.
+};
+
+#endif  // RUNNER_SERIAL_PORT_H_